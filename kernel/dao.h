@@ -955,6 +955,10 @@ DAO_DLL DaoNamespace* DaoClass_GetNamespace( DaoClass *self );
 
 DAO_DLL DaoClass*   DaoObject_GetClass( DaoObject *self );
 DAO_DLL DaoRoutine* DaoObject_GetMethod( DaoObject *self, const char *name );
+/*
+// The returned instance variable value is borrowed from the object: it must
+// be copied to be used after the object is freed or the variable is updated;
+*/
 DAO_DLL DaoValue*   DaoObject_GetField( DaoObject *self, const char *name );
 DAO_DLL DaoCstruct* DaoObject_CastCstruct( DaoObject *self, DaoType *type );
 DAO_DLL DaoCdata*   DaoObject_CastCdata( DaoObject *self, DaoType *type );
@@ -44,6 +44,9 @@ typedef struct DaoInode      DaoInode;
 typedef struct DaoVmCodeX    DaoVmCodeX;
 
 typedef struct DaoFuture     DaoFuture;
+typedef struct DaoRope       DaoRope;
+typedef struct DaoTable      DaoTable;
+typedef struct DaoObjectProto  DaoObjectProto;
 typedef struct DaoNameValue  DaoNameValue;
 typedef struct DaoConstant   DaoConstant;
 typedef struct DaoVariable   DaoVariable;
@@ -614,6 +614,54 @@ DaoByteBlock* DaoByteBlock_EncodeEnum( DaoByteBlock *self, DaoEnum *value )
 	DaoByteCoder_EncodeUInt32( newBlock->end, value->value );
 	return newBlock;
 }
+static int DaoByteCoder_CompactItemSize( int stype )
+{
+	switch( stype ){
+	case DAO_ARRAY_SINT8   : return 1;
+	case DAO_ARRAY_SINT16  : return 2;
+	case DAO_ARRAY_SINT32  : return 4;
+	case DAO_ARRAY_FLOAT32 : return 4;
+	}
+	return 8;
+}
+/*
+// Elements of compact storages are encoded in big endian,
+// and float32 elements are encoded by their IEEE 754 bit patterns:
+*/
+static void DaoByteCoder_EncodeCompactItems( uchar_t *data, DaoArray *array, daoint start, int count )
+{
+	uint_t bits;
+	int i;
+	for(i=0; i<count; ++i){
+		daoint k = start + i;
+		switch( array->stype ){
+		case DAO_ARRAY_SINT8  : data[i] = (uchar_t) array->data.i8[k]; break;
+		case DAO_ARRAY_SINT16 : DaoByteCoder_EncodeUInt16( data + 2*i, (ushort_t) array->data.i16[k] ); break;
+		case DAO_ARRAY_SINT32 : DaoByteCoder_EncodeUInt32( data + 4*i, (uint_t) array->data.i32[k] ); break;
+		case DAO_ARRAY_FLOAT32 :
+			memcpy( & bits, array->data.f32 + k, sizeof(float) );
+			DaoByteCoder_EncodeUInt32( data + 4*i, bits );
+			break;
+		}
+	}
+}
+static void DaoByteCoder_DecodeCompactItems( uchar_t *data, DaoArray *array, daoint start, int count )
+{
+	uint_t bits;
+	int i;
+	for(i=0; i<count; ++i){
+		daoint k = start + i;
+		switch( array->stype ){
+		case DAO_ARRAY_SINT8  : array->data.i8[k] = (signed char) data[i]; break;
+		case DAO_ARRAY_SINT16 : array->data.i16[k] = (short) DaoByteCoder_DecodeUInt16( data + 2*i ); break;
+		case DAO_ARRAY_SINT32 : array->data.i32[k] = (int) DaoByteCoder_DecodeUInt32( data + 4*i ); break;
+		case DAO_ARRAY_FLOAT32 :
+			bits = DaoByteCoder_DecodeUInt32( data + 4*i );
+			memcpy( array->data.f32 + k, & bits, sizeof(float) );
+			break;
+		}
+	}
+}
 DaoByteBlock* DaoByteBlock_EncodeArray( DaoByteBlock *self, DaoArray *value )
 {
 	int i;
@@ -622,7 +670,7 @@ DaoByteBlock* DaoByteBlock_EncodeArray( DaoByteBlock *self, DaoArray *value )
 	if( block ) return block;
 	block = DaoByteBlock_AddBlock( self, (DaoValue*) value, DAO_ASM_VALUE );
 	block->begin[0] = DAO_ARRAY;
-	block->begin[1] = value->etype;
+	block->begin[1] = value->etype | (value->stype << 4);
 	DaoByteCoder_EncodeUInt16( block->begin+2, value->ndim );
 	DaoByteCoder_EncodeUInt32( block->begin+4, value->size );
 	for(i=0; (i+2)<value->ndim; i+=2){
@@ -633,7 +681,15 @@ DaoByteBlock* DaoByteBlock_EncodeArray( DaoByteBlock *self, DaoArray *value )
 	databk = DaoByteBlock_NewBlock( block, DAO_ASM_DATA );
 	DaoByteCoder_EncodeUInt32( databk->begin, value->dims[i] );
 	if( (i+1)<value->ndim ) DaoByteCoder_EncodeUInt32( databk->begin+4, value->dims[i+1] );
-	if( value->etype == DAO_INTEGER && sizeof(dao_integer) == 8 ){
+	if( value->stype ){
+		/* Compact elements are packed into the data blocks: */
+		int m = 8 / DaoByteCoder_CompactItemSize( value->stype );
+		for(i=0; (i+m)<value->size; i+=m){
+			databk = DaoByteBlock_NewBlock( block, DAO_ASM_DATA );
+			DaoByteCoder_EncodeCompactItems( databk->begin, value, i, m );
+		}
+		if( i < value->size ) DaoByteCoder_EncodeCompactItems( block->end, value, i, value->size - i );
+	}else if( value->etype == DAO_INTEGER && sizeof(dao_integer) == 8 ){
 		for(i=0; (i+1)<value->size; i+=1){
 			databk = DaoByteBlock_NewBlock( block, DAO_ASM_DATA );
 			DaoByteCoder_EncodeDaoInt( databk->begin, value->data.i[i] );
@@ -1856,8 +1912,14 @@ static void DaoByteCoder_DecodeValue( DaoByteCoder *self, DaoByteBlock *block )
 		B = D = DaoByteCoder_DecodeUInt16( block->begin+2 );
 		C = DaoByteCoder_DecodeUInt32( block->begin+4 );
 		i = 0;
-		array = DaoArray_New( A );
+		array = DaoArray_New( A & 0xF );
+		array->stype = A >> 4;
 		value = (DaoValue*) array;
+		if( array->stype > DAO_ARRAY_FLOAT32 ){
+			DaoByteCoder_Error( self, block, "invalid array storage!" );
+			array->stype = 0;
+			break;
+		}
 		DaoArray_SetDimCount( array, D );
 		while( B > 0 && pb != NULL ){
 			if( i < D ) array->dims[i++] = DaoByteCoder_DecodeUInt32( pb->begin );
@@ -1869,7 +1931,13 @@ static void DaoByteCoder_DecodeValue( DaoByteCoder *self, DaoByteBlock *block )
 		if( array->size != C ) DaoByteCoder_Error( self, block, "size not matching!" );
 		if( self->error ) break;
 
-		if( array->etype == DAO_INTEGER && sizeof(dao_integer) == 8 ){
+		if( array->stype ){
+			int m = 8 / DaoByteCoder_CompactItemSize( array->stype );
+			for(i=0; (i+m)<C && pb != NULL; i+=m, pb=pb->next){
+				DaoByteCoder_DecodeCompactItems( pb->begin, array, i, m );
+			}
+			if( C ) DaoByteCoder_DecodeCompactItems( block->end, array, i, (C-i) < m ? C-i : m );
+		}else if( array->etype == DAO_INTEGER && sizeof(dao_integer) == 8 ){
 			for(i=0; (i+1)<C && pb != NULL; i+=1, pb=pb->next){
 				array->data.i[i] = DaoByteCoder_DecodeDaoInt( self, pb->begin );
 			}
@@ -2355,6 +2423,7 @@ static void DaoByteCoder_DecodeClass( DaoByteCoder *self, DaoByteBlock *block )
 	}
 	DaoClass_UpdateMixinConstructors( klass );
 	DaoClass_UpdateVirtualMethods( klass );
+	DaoClass_UpdateObjectProto( klass );
 	/* Check inferred attributes: */
 	if( klass->attribs != (C & ~(DAO_CLS_INVAR|DAO_CLS_ASYNCHRONOUS)) ){
 		DaoByteCoder_Error( self, block, "Class attributes not matching!" );
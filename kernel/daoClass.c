@@ -102,6 +102,7 @@ void DaoClass_Delete( DaoClass *self )
 	DArray_Delete( self->ranges );
 	DList_Delete( self->auxData );
 	if( self->interMethods ) DMap_Delete( self->interMethods );
+	if( self->objProto ) DaoObjectProto_Delete( self->objProto );
 
 	DString_Delete( self->className );
 	dao_free( self );
@@ -1430,6 +1431,11 @@ DaoValue* DaoClass_DoConversion( DaoValue *self, DaoType *type, int copy, DaoPro
 	return NULL;
 }
 
+void DaoClass_UpdateObjectProto( DaoClass *self )
+{
+	if( self->objProto ) DaoObjectProto_Delete( self->objProto );
+	self->objProto = DaoObjectProto_New( self );
+}
 void DaoClass_CoreDelete( DaoValue *self )
 {
 	DaoClass_Delete( (DaoClass*) self );
@@ -149,6 +149,8 @@ struct DaoClass
 
 	DList_(DaoValue*) *auxData; /* Auxiliary data; */
 
+	DaoObjectProto  *objProto;  /* Construction prototype for the instances; */
+
 	uint_t    attribs;
 	ushort_t  objDefCount;
 	ushort_t  derived;
@@ -170,6 +172,7 @@ DAO_DLL void DaoClass_DeriveObjectData( DaoClass *self );
 DAO_DLL void DaoClass_UpdateMixinConstructors( DaoClass *self );
 DAO_DLL void DaoClass_UpdateAttributes( DaoClass *self );
 DAO_DLL void DaoClass_UpdateVirtualMethods( DaoClass *self );
+DAO_DLL void DaoClass_UpdateObjectProto( DaoClass *self );
 DAO_DLL void DaoClass_CastingMethod( DaoClass *self, DaoRoutine *routine );
 
 DAO_DLL int  DaoClass_ChildOf( DaoClass *self, DaoValue *base );
@@ -160,7 +160,8 @@ enum DaoValueTrait
 	DAO_VALUE_CONST   = (1<<1), /* constant value; */
 	DAO_VALUE_NOCOPY  = (1<<2), /* value not for copying; */
 	DAO_VALUE_DELAYGC = (1<<3), /* values with this trait are scanned less frequently by GC; */
-	DAO_VALUE_BROKEN  = (1<<4)  /* reference already broken (may not yet set to NULL) by GC; */
+	DAO_VALUE_BROKEN  = (1<<4), /* reference already broken (may not yet set to NULL) by GC; */
+	DAO_VALUE_INLINE  = (1<<5)  /* value stored inline in its owner (not freed by GC); */
 };
 enum DaoTypeAttribs
 {
@@ -200,7 +201,8 @@ enum DaoProcessPauseType
 	DAO_PAUSE_CHANNEL_SEND ,    /* channel::send(); */
 	DAO_PAUSE_CHANNEL_RECEIVE , /* channel::send(); */
 	DAO_PAUSE_CHANFUT_SELECT ,  /* mt::select(); */
-	DAO_PAUSE_COROUTINE_YIELD   /* coroutine; */
+	DAO_PAUSE_COROUTINE_YIELD , /* coroutine; */
+	DAO_PAUSE_IO_WAIT           /* waiting for a file descriptor; */
 };
 
 enum DaoFieldPermission
@@ -42,6 +42,7 @@
 #include"daoVmspace.h"
 #include"daoThread.h"
 #include"daoValue.h"
+#include"daoStream.h"
 
 
 
@@ -143,6 +144,8 @@ static int DaoGC_CycRefCountIncScan( DaoValue *value );
 static int DaoGC_RefCountDecScan( DaoValue *value );
 
 static void DaoGC_PrepareCandidates();
+static void DaoGC_ProfileCycle();
+static void DaoGC_ProfilePause( int kind, double start );
 
 static void DaoCGC_FreeGarbage();
 static void DaoCGC_CycRefCountDecScan();
@@ -620,6 +623,361 @@ void DaoGC_SetMode( int fullgc, int finalizing )
 	gcWorker.finalizing = finalizing;
 }
 
+/*
+// Allocation and GC profiling:
+*/
+typedef struct DaoGcSite   DaoGcSite;
+typedef struct DaoGcPause  DaoGcPause;
+
+struct DaoGcSite
+{
+	DString  *name;      /* allocating routine and line; */
+	short     type;
+	daoint    count;     /* number of allocations; */
+	daoint    bytes;     /* bytes of the value structures; */
+	daoint    freed;     /* number of deletions; */
+	daoint    survived;  /* number of deletions after surviving GC cycles; */
+};
+
+struct DaoGcPause
+{
+	daoint  count;
+	double  total;
+	double  max;
+};
+
+/* Pause kinds following the incremental GC steps (DaoGCWorkType): */
+enum DaoGcPauseKind
+{
+	DAO_GC_PAUSE_CGC = 7 ,
+	DAO_GC_PAUSE_BLOCK ,
+	DAO_GC_PAUSE_KINDS
+};
+
+static const char *const dao_gc_pause_names[] =
+{
+	"IGC: prepare candidates",
+	"IGC: cyclic refcount dec",
+	"IGC: cyclic refcount inc",
+	"IGC: deregister modules",
+	"IGC: cyclic refcount inc 2",
+	"IGC: refcount dec",
+	"IGC: free garbage",
+	"CGC: cycle",
+	"CGC: mutator blocking"
+};
+
+typedef struct DaoGcProfiler  DaoGcProfiler;
+struct DaoGcProfiler
+{
+	DMap       *sites;   /* call stacks to sites; */
+	DMap       *young;   /* values that have not survived any GC cycle; */
+	DMap       *old;     /* values that have survived GC cycles; */
+	DList      *survivors; /* candidates that have survived the current cycle; */
+	DString    *stack;
+	daoint      cycles;
+	DaoGcPause  pauses[DAO_GC_PAUSE_KINDS];
+	DMutex      mutex;
+};
+
+int dao_gc_profiling = 0;
+
+static DaoGcProfiler dao_gc_profiler = {0};
+
+static const char* DaoGC_GetTypeName( int type )
+{
+	static const char *const names[] =
+	{
+		"none", "bool", "int", "float", "complex", "string", "enum",
+		"array", "list", "map", "tuple", "object", "cinvalue", "cstruct",
+		"cdata", "ctype", "class", "cintype", "interface", "routine",
+		"process", "namespace", "type"
+	};
+	switch( type ){
+	case DAO_VMSPACE   : return "vmspace";
+	case DAO_CONSTANT  : return "constant";
+	case DAO_VARIABLE  : return "variable";
+	case DAO_ROUTBODY  : return "routbody";
+	case DAO_TYPEKERNEL : return "typekernel";
+	case DAO_PAR_NAMED : return "namevalue";
+	}
+	if( type >= 0 && type < END_CORE_TYPES ) return names[type];
+	return "value";
+}
+
+static daoint DaoGC_GetValueSize( DaoValue *value )
+{
+	switch( value->type ){
+	case DAO_NONE      : return sizeof(DaoNone);
+	case DAO_BOOLEAN   : return sizeof(DaoBoolean);
+	case DAO_INTEGER   : return sizeof(DaoInteger);
+	case DAO_FLOAT     : return sizeof(DaoFloat);
+	case DAO_COMPLEX   : return sizeof(DaoComplex);
+	case DAO_STRING    : return sizeof(DaoString);
+	case DAO_ENUM      : return sizeof(DaoEnum);
+#ifdef DAO_WITH_NUMARRAY
+	case DAO_ARRAY     : return sizeof(DaoArray);
+#endif
+	case DAO_LIST      : return sizeof(DaoList) + sizeof(DList);
+	case DAO_MAP       : return sizeof(DaoMap) + sizeof(DMap);
+	case DAO_TUPLE     :
+		if( value->xTuple.size <= DAO_TUPLE_MINSIZE ) return sizeof(DaoTuple);
+		return sizeof(DaoTuple) + (value->xTuple.size - DAO_TUPLE_MINSIZE)*sizeof(DaoValue*);
+	case DAO_OBJECT    : return sizeof(DaoObject);
+	case DAO_CSTRUCT   : return sizeof(DaoCstruct);
+	case DAO_CDATA     : return sizeof(DaoCdata);
+	case DAO_CLASS     : return sizeof(DaoClass);
+	case DAO_ROUTINE   : return sizeof(DaoRoutine);
+	case DAO_PROCESS   : return sizeof(DaoProcess);
+	case DAO_NAMESPACE : return sizeof(DaoNamespace);
+	case DAO_TYPE      : return sizeof(DaoType);
+	}
+	return sizeof(DaoValue);
+}
+
+static void DaoGC_MakeStack( DString *stack, DaoValue *value )
+{
+	DaoProcess *process = NULL;
+	DaoStackFrame *frame;
+	int depth = 0;
+	char buf[32];
+
+	DString_Reset( stack, 0 );
+#ifdef DAO_WITH_THREAD
+	process = DThread_GetCurrent()->process;
+#endif
+	for(frame=process?process->topFrame:NULL; frame && frame->routine; frame=frame->prev){
+		DaoRoutine *routine = frame->routine;
+		daoint k = frame->entry - 1, line = 0;
+		if( ++depth > 32 ) break;
+		if( frame == process->topFrame && process->activeRoutine == routine && process->activeCode ){
+			k = process->activeCode - frame->codes;
+		}
+		if( routine->body && k >= 0 && k < routine->body->annotCodes->size ){
+			line = routine->body->annotCodes->items.pVmc[k]->line;
+		}
+		/* Stack frames are visited from the top, so the names are prepended: */
+		sprintf( buf, "():%i;", (int) line );
+		DString_InsertChars( stack, buf, 0, 0, -1 );
+		DString_Insert( stack, routine->routName, 0, 0, -1 );
+		/* The names of the implicit class constructors are already qualified: */
+		if( routine->routHost && DString_FindChars( routine->routName, "::", 0 ) == DAO_NULLPOS ){
+			DString_InsertChars( stack, "::", 0, 0, -1 );
+			DString_Insert( stack, routine->routHost->name, 0, 0, -1 );
+		}
+	}
+	if( stack->size == 0 ) DString_AppendChars( stack, "[unknown];" );
+	DString_AppendChar( stack, '[' );
+	DString_AppendChars( stack, DaoGC_GetTypeName( value->type ) );
+	DString_AppendChar( stack, ']' );
+}
+
+static void DaoGC_ProfileDelete2( DaoValue *value )
+{
+	DNode *it = DMap_Find( dao_gc_profiler.young, value );
+	if( it != NULL ){
+		((DaoGcSite*) it->value.pVoid)->freed += 1;
+		DMap_EraseNode( dao_gc_profiler.young, it );
+		return;
+	}
+	it = DMap_Find( dao_gc_profiler.old, value );
+	if( it != NULL ){
+		((DaoGcSite*) it->value.pVoid)->freed += 1;
+		((DaoGcSite*) it->value.pVoid)->survived += 1;
+		DMap_EraseNode( dao_gc_profiler.old, it );
+	}
+}
+
+void DaoGC_ProfileNew( DaoValue *value )
+{
+	DaoGcProfiler *self = & dao_gc_profiler;
+	DaoGcSite *site;
+	DNode *it;
+
+	if( self->sites == NULL ) return;
+	DMutex_Lock( & self->mutex );
+	/* Values deleted without going through the GC leave their addresses: */
+	DaoGC_ProfileDelete2( value );
+	DaoGC_MakeStack( self->stack, value );
+	it = DMap_Find( self->sites, self->stack );
+	if( it == NULL ){
+		/* The site name is the innermost frame of the stack: */
+		daoint pos = DString_RFindChar( self->stack, ';', -1 );
+		daoint start = pos > 0 ? DString_RFindChar( self->stack, ';', pos - 1 ) : DAO_NULLPOS;
+		start = start == DAO_NULLPOS ? 0 : start + 1;
+		site = (DaoGcSite*) dao_calloc( 1, sizeof(DaoGcSite) );
+		site->name = DString_New();
+		site->type = value->type;
+		DString_SubString( self->stack, site->name, start, pos - start );
+		it = DMap_Insert( self->sites, self->stack, site );
+	}
+	site = (DaoGcSite*) it->value.pVoid;
+	site->count += 1;
+	site->bytes += DaoGC_GetValueSize( value );
+	DMap_Insert( self->young, value, site );
+	DMutex_Unlock( & self->mutex );
+}
+
+void DaoGC_ProfileDelete( DaoValue *value )
+{
+	if( dao_gc_profiler.sites == NULL ) return;
+	DMutex_Lock( & dao_gc_profiler.mutex );
+	DaoGC_ProfileDelete2( value );
+	DMutex_Unlock( & dao_gc_profiler.mutex );
+}
+
+/*
+// Called at the end of each GC cycle: the candidates that have been scanned
+// in the cycle but not identified as garbage have survived the cycle.
+*/
+static void DaoGC_ProfileCycle()
+{
+	DaoGcProfiler *self = & dao_gc_profiler;
+	DList *survivors = self->survivors;
+	DNode *it;
+	daoint i;
+
+	if( self->sites == NULL ) return;
+	DMutex_Lock( & self->mutex );
+	self->cycles += 1;
+	for(i=0; i<survivors->size; ++i){
+		it = DMap_Find( self->young, survivors->items.pValue[i] );
+		if( it == NULL ) continue;
+		DMap_Insert( self->old, it->key.pVoid, it->value.pVoid );
+		DMap_EraseNode( self->young, it );
+	}
+	survivors->size = 0;
+	DMutex_Unlock( & self->mutex );
+}
+
+static void DaoGC_ProfilePause( int kind, double start )
+{
+	DaoGcPause *pause = dao_gc_profiler.pauses + kind;
+	double time = Dao_GetCurrentTime() - start;
+
+	if( dao_gc_profiler.sites == NULL ) return;
+	DMutex_Lock( & dao_gc_profiler.mutex );
+	pause->count += 1;
+	pause->total += time;
+	if( time > pause->max ) pause->max = time;
+	DMutex_Unlock( & dao_gc_profiler.mutex );
+}
+
+void DaoGC_SetProfiling( int enable )
+{
+	DaoGcProfiler *self = & dao_gc_profiler;
+	if( self->sites == NULL && enable ){
+		DMutex_Init( & self->mutex );
+		self->sites = DHash_New( DAO_DATA_STRING, 0 );
+		self->young = DHash_New( 0, 0 );
+		self->old = DHash_New( 0, 0 );
+		self->survivors = DList_New(0);
+		self->stack = DString_New();
+	}
+	dao_gc_profiling = enable != 0;
+}
+
+static int DaoGcSite_Compare( const void *first, const void *second )
+{
+	DaoGcSite *site1 = *(DaoGcSite**) first;
+	DaoGcSite *site2 = *(DaoGcSite**) second;
+	if( site1->bytes != site2->bytes ) return site1->bytes < site2->bytes ? 1 : -1;
+	if( site1->count != site2->count ) return site1->count < site2->count ? 1 : -1;
+	return 0;
+}
+
+/*
+// Print the allocation sites (merged by routine, line and type) and the GC pauses
+// to "stream", and append the allocation call stacks (weighted by bytes) in the
+// folded format for flame graphs to "folded":
+*/
+void DaoGC_PrintProfile( DaoStream *stream, DString *folded )
+{
+	DaoGcProfiler *self = & dao_gc_profiler;
+	const char *delimiter = "-------------------------------------------------------------------------------\n";
+	DMap *merged;
+	DNode *it, *it2;
+	DaoGcSite **sites;
+	DString *key;
+	daoint i, count = 0, bytes = 0;
+	char buf[256];
+
+	if( self->sites == NULL ) return;
+	DMutex_Lock( & self->mutex );
+
+	key = DString_New();
+	merged = DHash_New( DAO_DATA_STRING, 0 );
+	for(it=DMap_First(self->sites); it; it=DMap_Next(self->sites,it)){
+		DaoGcSite *site = (DaoGcSite*) it->value.pVoid;
+		DaoGcSite *site2;
+		DString_Assign( key, site->name );
+		DString_AppendChar( key, '\t' );
+		DString_AppendChars( key, DaoGC_GetTypeName( site->type ) );
+		it2 = DMap_Find( merged, key );
+		if( it2 == NULL ){
+			site2 = (DaoGcSite*) dao_calloc( 1, sizeof(DaoGcSite) );
+			site2->name = site->name;
+			site2->type = site->type;
+			it2 = DMap_Insert( merged, key, site2 );
+		}
+		site2 = (DaoGcSite*) it2->value.pVoid;
+		site2->count += site->count;
+		site2->bytes += site->bytes;
+		site2->freed += site->freed;
+		site2->survived += site->survived;
+		count += site->count;
+		bytes += site->bytes;
+
+		if( folded ){
+			DString_Append( folded, it->key.pString );
+			snprintf( buf, sizeof(buf), " %" DAO_I64 "\n", (long long) site->bytes );
+			DString_AppendChars( folded, buf );
+		}
+	}
+	sites = (DaoGcSite**) dao_malloc( (merged->size + 1) * sizeof(DaoGcSite*) );
+	for(i=0,it=DMap_First(merged); it; it=DMap_Next(merged,it)) sites[i++] = it->value.pVoid;
+	qsort( sites, merged->size, sizeof(DaoGcSite*), DaoGcSite_Compare );
+
+	DaoStream_WriteChars( stream, "\n============== Allocation Profile ==============\n" );
+	snprintf( buf, sizeof(buf), "Allocations: %" DAO_I64 ", bytes: %" DAO_I64 ", GC cycles: %" DAO_I64 "\n",
+			(long long) count, (long long) bytes, (long long) self->cycles );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter );
+	snprintf( buf, sizeof(buf), "%-30s %-8s: %9s %11s %9s %9s %9s\n", "Site", "Type",
+			"#Count", "Bytes", "#Freed", "#Survived", "#Live" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter );
+	for(i=0; i<merged->size && i<50; ++i){
+		DaoGcSite *site = sites[i];
+		snprintf( buf, sizeof(buf), "%-30.30s %-8.8s: %9" DAO_I64 " %11" DAO_I64 " %9" DAO_I64
+				" %9" DAO_I64 " %9" DAO_I64 "\n", site->name->chars, DaoGC_GetTypeName( site->type ),
+				(long long) site->count, (long long) site->bytes, (long long) site->freed,
+				(long long) site->survived, (long long) (site->count - site->freed) );
+		DaoStream_WriteChars( stream, buf );
+	}
+	DaoStream_WriteChars( stream, delimiter );
+	snprintf( buf, sizeof(buf), "%-30s: %9s %12s %12s %12s\n", "GC Pause", "#Count",
+			"Total(ms)", "Max(ms)", "Mean(ms)" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter );
+	for(i=0; i<DAO_GC_PAUSE_KINDS; ++i){
+		DaoGcPause *pause = self->pauses + i;
+		if( pause->count == 0 ) continue;
+		snprintf( buf, sizeof(buf), "%-30s: %9" DAO_I64 " %12.3f %12.3f %12.4f\n",
+				dao_gc_pause_names[i], (long long) pause->count, 1E3 * pause->total,
+				1E3 * pause->max, 1E3 * pause->total / pause->count );
+		DaoStream_WriteChars( stream, buf );
+	}
+
+	for(it=DMap_First(merged); it; it=DMap_Next(merged,it)) dao_free( it->value.pVoid );
+	DMap_Delete( merged );
+	DString_Delete( key );
+	dao_free( sites );
+	DMutex_Unlock( & self->mutex );
+}
+
+
+
 void DaoGC_Init()
 {
 	if( gcWorker.idleList != NULL ) return;
@@ -691,6 +1049,8 @@ void DaoCGC_Start()
 static void DaoGC_DeleteSimpleData( DaoValue *value )
 {
 	if( value == NULL || value->xGC.refCount ) return;
+	if( value->xBase.trait & DAO_VALUE_INLINE ) return; /* freed with its owner; */
+	if( dao_gc_profiling ) DaoGC_ProfileDelete( value );
 	switch( value->type ){
 	case DAO_NONE :
 	case DAO_BOOLEAN :
@@ -710,6 +1070,7 @@ static void DaoGC_DeleteSimpleData( DaoValue *value )
 }
 static void DaoValue_Delete( DaoValue *self )
 {
+	if( dao_gc_profiling && self->type >= DAO_ENUM ) DaoGC_ProfileDelete( self );
 	switch( self->type ){
 	default :
 		if( self->type < DAO_ENUM ){
@@ -1244,9 +1605,11 @@ void DaoCGC_TryBlock()
 	if( gcWorker.idleList->size >= gcWorker.gcMax ){
 		DThread *thread = DThread_GetCurrent();
 		if( thread && ! (thread->state & DTHREAD_NO_PAUSE) ){
+			double start = dao_gc_profiling ? Dao_GetCurrentTime() : 0.0;
 			DMutex_Lock( & gcWorker.mutex_block_mutator );
 			DCondVar_TimedWait( & gcWorker.condv_block_mutator, & gcWorker.mutex_block_mutator, 0.001 );
 			DMutex_Unlock( & gcWorker.mutex_block_mutator );
+			if( dao_gc_profiling ) DaoGC_ProfilePause( DAO_GC_PAUSE_BLOCK, start );
 		}
 	}
 }
@@ -1260,6 +1623,7 @@ void DaoCGC_Recycle( void *p )
 	DList *idles2 = gcWorker.idleList2;
 	DList *frees = gcWorker.freeList;
 	DList *delays = gcWorker.delayList;
+	double start;
 	daoint N;
 	while(1){
 		N = idles->size + works->size + idles2->size + works2->size + frees->size + delays->size;
@@ -1280,6 +1644,7 @@ void DaoCGC_Recycle( void *p )
 			}
 		}
 		gcWorker.busy = 1;
+		start = dao_gc_profiling ? Dao_GetCurrentTime() : 0.0;
 
 		DMutex_Lock( & gcWorker.mutex_idle_list );
 		DList_Swap( idles, works );
@@ -1295,6 +1660,10 @@ void DaoCGC_Recycle( void *p )
 		DaoCGC_CycRefCountIncScan();
 		DaoCGC_RefCountDecScan();
 		DaoCGC_FreeGarbage();
+		if( dao_gc_profiling ){
+			DaoGC_ProfilePause( DAO_GC_PAUSE_CGC, start );
+			DaoGC_ProfileCycle();
+		}
 	}
 	DThread_Exit( & gcWorker.thread );
 }
@@ -1392,6 +1761,9 @@ static void DaoCGC_FreeGarbage()
 	for(i=0; i<workList->size; i++){
 		DaoValue *value = workList->items.pValue[i];
 		value->xGC.work = value->xGC.alive = 0;
+		if( dao_gc_profiling && (value->xGC.cycRefCount || value->xGC.refCount) ){
+			DList_PushBack( dao_gc_profiler.survivors, value );
+		}
 		if( value->xGC.cycRefCount && value->xGC.refCount ) continue;
 		if( value->xGC.refCount ){
 			/* This is possible since Cyclic RefCount is not updated atomically: */
@@ -1468,9 +1840,12 @@ void DaoIGC_Switch()
 }
 void DaoIGC_Continue()
 {
+	int workType = gcWorker.workType;
+	double start;
 	if( gcWorker.busy ) return;
 	//printf( "DaoIGC_Continue: %i\n", gcWorker.workType );
 	gcWorker.busy = 1;
+	start = dao_gc_profiling ? Dao_GetCurrentTime() : 0.0;
 	switch( gcWorker.workType ){
 	case GC_RESET_RC :
 		DaoGC_PrepareCandidates();
@@ -1504,6 +1879,11 @@ void DaoIGC_Continue()
 		break;
 	default : break;
 	}
+	if( dao_gc_profiling ){
+		DaoGC_ProfilePause( workType, start );
+		/* The cycle is complete when the free step resets the work type: */
+		if( workType == GC_FREE && gcWorker.workType == GC_RESET_RC ) DaoGC_ProfileCycle();
+	}
 	gcWorker.busy = 0;
 }
 void DaoIGC_Finish()
@@ -1660,6 +2040,9 @@ void DaoIGC_FreeGarbage()
 	for(; i<workList->size; i++, j++){
 		DaoValue *value = workList->items.pValue[i];
 		value->xGC.work = value->xGC.alive = 0;
+		if( dao_gc_profiling && (value->xGC.cycRefCount || value->xGC.refCount) ){
+			DList_PushBack( dao_gc_profiler.survivors, value );
+		}
 		if( value->xGC.cycRefCount && value->xGC.refCount ) continue;
 		if( value->xGC.refCount ){
 			/* This is possible since Cyclic RefCount is not updated atomically: */
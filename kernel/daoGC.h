@@ -47,6 +47,22 @@ DAO_DLL void DaoObjectLogger_LogDelete( DaoValue *object );
 DAO_DLL void DaoObjectLogger_PrintProfile();
 #endif
 
+/*
+// Allocation and GC profiling, which can be switched on and off at runtime:
+// -- Each new value is attributed to the call stack (with line numbers)
+//    of the process running on the current thread;
+// -- Values that are still referenced when a GC cycle starts are counted
+//    as survivors of GC cycles;
+// -- The time of each incremental GC step, concurrent GC cycle and
+//    mutator blocking by the concurrent GC is recorded;
+*/
+extern int dao_gc_profiling;
+
+DAO_DLL void DaoGC_SetProfiling( int enable );
+DAO_DLL void DaoGC_ProfileNew( DaoValue *value );
+DAO_DLL void DaoGC_ProfileDelete( DaoValue *value );
+DAO_DLL void DaoGC_PrintProfile( DaoStream *stream, DString *folded );
+
 DAO_DLL int DaoGC_IsConcurrent();
 DAO_DLL int DaoGC_Min( int n );
 DAO_DLL int DaoGC_Max( int n );
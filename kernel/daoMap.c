@@ -42,6 +42,25 @@
 #define RB_RED    0
 #define RB_BLACK  1
 
+/*
+// Hash maps use open addressing with one control byte per slot. The slots are
+// probed in groups, and the control bytes of a group are matched all at once
+// with word-wide bit operations. The control byte of an occupied slot holds the
+// low seven bits of the node hash, so most mismatching slots are skipped without
+// comparing the keys. The nodes of a hash map are also chained in insertion
+// order through their "left" and "right" fields, which is used for iteration.
+*/
+#define DHASH_EMPTY    0x80
+#define DHASH_ERASED   0xFE
+#define DHASH_GROUP    8
+#define DHASH_MINSIZE  8
+#define DHASH_MOVING   4096  /* Minimum table size to be resized incrementally; */
+#define DHASH_MOVES    16    /* Slots to be moved in each incremental step; */
+#define DHASH_LSBS     0x0101010101010101ULL
+#define DHASH_MSBS     0x8080808080808080ULL
+
+typedef unsigned long long DHashGroup;
+
 
 static DNode* DNode_New( DMap *map, int keytype, int valtype )
 {
@@ -92,14 +111,36 @@ DaoValue* DNode_Value( DNode *self )
 	return self->value.pValue;
 }
 
+static void DHash_FreeTable0( DMap *self )
+{
+	if( self->table0 ) dao_free( self->table0 );
+	self->table0 = NULL;
+	self->tsize0 = self->moved = 0;
+}
+static void DHash_InitTable( DMap *self, size_t tsize )
+{
+	/* Slots and their control bytes are allocated in one block: */
+	self->table = (DNode**) dao_malloc( tsize * (sizeof(DNode*) + 1) );
+	self->control = (uchar_t*) (self->table + tsize);
+	self->tsize = tsize;
+	self->used = 0;
+	memset( self->control, DHASH_EMPTY, tsize );
+}
+
 DMap* DMap_New( short kt, short vt )
 {
 	DMap *self = (DMap*) dao_malloc( sizeof( DMap) );
 	self->size = 0;
-	self->tsize2rt = 0;
+	self->used = 0;
+	self->tsize = 0;
 	self->list = NULL;
 	self->root = NULL;
+	self->last = NULL;
 	self->table = NULL;
+	self->control = NULL;
+	self->table0 = NULL;
+	self->tsize0 = 0;
+	self->moved = 0;
 	self->keytype = kt;
 	self->valtype = vt;
 	self->hashing = 0;
@@ -109,13 +150,63 @@ DMap* DHash_New( short kt, short vt )
 {
 	DMap *self = DMap_New( kt, vt );
 	self->hashing = DAO_HASH_SEED;
-	self->tsize2rt = 2;
-	self->table = (DNode**) dao_calloc( self->tsize2rt * self->tsize2rt, sizeof(DNode*) );
+	DHash_InitTable( self, DHASH_MINSIZE );
 	return self;
 }
+void DMap_SetHashing( DMap *self, uint_t hashing )
+{
+	/* Only for empty maps; */
+	if( hashing == 0 ){
+		if( self->table ) dao_free( self->table );
+		DHash_FreeTable0( self );
+		self->table = NULL;
+		self->control = NULL;
+		self->tsize = self->used = 0;
+	}else if( self->hashing == 0 ){
+		DHash_InitTable( self, DHASH_MINSIZE );
+	}
+	self->hashing = hashing;
+}
+
+
+#ifdef DAO_WITH_NUMARRAY
+#define DAO_ARRAY_HASH_CHUNK  64
+/*
+// Arrays are hashed in chunks of elements in the default storage, to be
+// consistent with the comparison. The elements of compact arrays are widened
+// chunk by chunk into a local buffer, without copying the whole array.
+*/
+static unsigned int DaoArray_Hash( DaoArray *self, unsigned int hash )
+{
+	dao_integer ints[DAO_ARRAY_HASH_CHUNK];
+	dao_float floats[DAO_ARRAY_HASH_CHUNK];
+	daoint i, j, n, size = 0;
 
+	switch( self->etype ){
+	case DAO_BOOLEAN : size = sizeof(dao_boolean); break;
+	case DAO_INTEGER : size = sizeof(dao_integer); break;
+	case DAO_FLOAT   : size = sizeof(dao_float); break;
+	case DAO_COMPLEX : size = sizeof(dao_complex); break;
+	default : break;
+	}
+	for(i=0; i<self->size; i+=DAO_ARRAY_HASH_CHUNK){
+		void *data = (char*) self->data.p + i*size;
+		n = self->size - i;
+		if( n > DAO_ARRAY_HASH_CHUNK ) n = DAO_ARRAY_HASH_CHUNK;
+		if( self->etype == DAO_INTEGER && self->stype ){
+			for(j=0; j<n; ++j) ints[j] = DaoArray_GetInteger( self, i + j );
+			data = ints;
+		}else if( self->etype == DAO_FLOAT && self->stype ){
+			for(j=0; j<n; ++j) floats[j] = DaoArray_GetFloat( self, i + j );
+			data = floats;
+		}
+		hash = Dao_Hash( data, n*size, hash );
+	}
+	return hash;
+}
+#endif
 
-static int DaoValue_Hash( DaoValue *self, unsigned int hash )
+int DaoValue_Hash( DaoValue *self, unsigned int hash )
 {
 	DaoValue *base;
 	DaoTypeCore *core;
@@ -136,18 +227,11 @@ static int DaoValue_Hash( DaoValue *self, unsigned int hash )
 		len = sizeof(int);
 		break;
 	case DAO_STRING  :
-		data = self->xString.value->chars;
-		len = self->xString.value->size;
-		break;
+		return DString_Hash( self->xString.value, hash );
 	case DAO_ARRAY :
-		data = self->xArray.data.p;
-		len = self->xArray.size;
-		switch( self->xArray.etype ){
-		case DAO_INTEGER : len *= sizeof(dao_integer); break;
-		case DAO_FLOAT   : len *= sizeof(dao_float); break;
-		case DAO_COMPLEX : len *= sizeof(dao_complex); break;
-		default : break;
-		}
+#ifdef DAO_WITH_NUMARRAY
+		return DaoArray_Hash( (DaoArray*) self, hash );
+#endif
 		break;
 	case DAO_TUPLE :
 		for(i=0; i<self->xTuple.size; i++){
@@ -179,7 +263,6 @@ Default:
 static int DHash_HashIndex( DMap *self, void *key )
 {
 #define HASH_MAX  32
-	DString *s;
 	DList *array;
 	unsigned int hash = 0;
 	void *data;
@@ -189,8 +272,7 @@ static int DHash_HashIndex( DMap *self, void *key )
 		hash = Dao_Hash( key, 2*sizeof(double), self->hashing );
 		break;
 	case DAO_DATA_STRING :
-		s = (DString*)key;
-		hash = Dao_Hash( s->chars, s->size, self->hashing );
+		hash = DString_Hash( (DString*) key, self->hashing );
 		break;
 	case DAO_DATA_VALUE2 :
 	case DAO_DATA_VALUE3 :
@@ -218,55 +300,20 @@ static int DHash_HashIndex( DMap *self, void *key )
 }
 static DNode* DMap_SimpleInsert( DMap *self, DNode *node );
 static void DMap_InsertNode( DMap *self, DNode *node );
-static void DMap_InsertTree( DMap *self, DNode *node )
-{
-	DNode *left = node->left;
-	DNode *right = node->right;
-	size_t tsize = self->tsize2rt * (size_t)self->tsize2rt;
-
-	node->parent = node->left = node->right = NULL;
-	self->root = self->table[ node->hash % tsize ];
-	if( self->root == NULL ){
-		node->color = RB_BLACK;
-		self->table[ node->hash % tsize ] = node;
-		self->size += 1;
-	}else{
-		DMap_SimpleInsert( self, node );
-		DMap_InsertNode( self, node );
-		self->table[ node->hash % tsize ] = self->root;
-	}
-	if( left ) DMap_InsertTree( self, left );
-	if( right ) DMap_InsertTree( self, right );
-}
+static void DHash_EraseNode( DMap *self, DNode *node );
 static int DMap_Lockable( DMap *self )
 {
 	int lockable = self->keytype >= DAO_DATA_VALUE && self->keytype <= DAO_DATA_VALUE3;
 	lockable |= self->valtype >= DAO_DATA_VALUE && self->valtype <= DAO_DATA_VALUE3;
 	return lockable;
 }
-static void DHash_ResetTable( DMap *self )
-{
-	DNode **nodes = self->table;
-	size_t i, tsize = self->tsize2rt * (size_t)self->tsize2rt;
-
-	if( self->hashing ==0 ) return;
-	if( DMap_Lockable( self ) ) DaoGC_LockData();
-	self->tsize2rt = sqrt( 2 * self->size + 1 );
-	self->table = (DNode**)dao_calloc( self->tsize2rt*(size_t)self->tsize2rt, sizeof(DNode*) );
-	self->size = 0;
-	for(i=0; i<tsize; i++) if( nodes[i] ) DMap_InsertTree( self, nodes[i] );
-	if( DMap_Lockable( self ) ) DaoGC_UnlockData();
-	if( nodes ) dao_free( nodes );
-}
 DMap* DMap_Copy( DMap *other )
 {
 	DMap *self = NULL;
 	if( other->hashing ){
-		size_t tsize = other->tsize2rt * (size_t)other->tsize2rt;
 		self = DHash_New( other->keytype, other->valtype );
-		self->tsize2rt = other->tsize2rt;
-		self->table = (DNode**)dao_realloc( self->table, tsize*sizeof(DNode*) );
-		memset( self->table, 0, tsize*sizeof(DNode*) );
+		dao_free( self->table );
+		DHash_InitTable( self, other->tsize );
 	}else{
 		self = DMap_New( other->keytype, other->valtype );
 	}
@@ -283,11 +330,23 @@ void DMap_Assign( DMap *self, DMap *other )
 	}
 }
 static void DMap_DeleteNode( DMap *self, DNode *node );
+static void DMap_DeleteTree( DMap *self, DNode *node );
 void DMap_Delete( DMap *self )
 {
 	DNode *p, *node;
-	DMap_Clear( self );
+	if( self->hashing ){
+		/* Free the nodes and the tables directly, without resetting the table: */
+		node = self->root;
+		while( node ){
+			p = node;
+			node = node->right;
+			DMap_DeleteNode( self, p );
+		}
+	}else{
+		DMap_DeleteTree( self, self->root );
+	}
 	if( self->table ) dao_free( self->table );
+	DHash_FreeTable0( self );
 	node = self->list;
 	while( node ){
 		p = node;
@@ -359,6 +418,14 @@ static void DMap_DeleteItem( void **item, short type )
 	default : break;
 	}
 }
+static void DMap_UpdateValue( DMap *self, DNode *node, void *value )
+{
+	if( self->valtype < DAO_DATA_VALUE || self->valtype > DAO_DATA_VALUE3 ){
+		DMap_DeleteItem( & node->value.pVoid, self->valtype );
+		node->value.pVoid = NULL;
+	}
+	DMap_CopyItem( & node->value.pVoid, value, self->valtype );
+}
 static void DMap_BufferNode( DMap *self, DNode *node )
 {
 	node->parent = node->left = node->right = NULL;
@@ -398,13 +465,18 @@ static void DMap_DeleteTree( DMap *self, DNode *node )
 void DMap_Clear( DMap *self )
 {
 	if( self->hashing ){
-		size_t i, tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		for(i=0; i<tsize; i++) DMap_DeleteTree( self, self->table[i] );
+		DNode *node = self->root;
 		if( DMap_Lockable( self ) ) DaoGC_LockData();
+		self->root = self->last = NULL;
 		if( self->table ) dao_free( self->table );
-		self->tsize2rt = 2;
-		self->table = (DNode**) dao_calloc( self->tsize2rt * self->tsize2rt, sizeof(DNode*) );
+		DHash_FreeTable0( self );
+		DHash_InitTable( self, DHASH_MINSIZE );
 		if( DMap_Lockable( self ) ) DaoGC_UnlockData();
+		while( node ){
+			DNode *next = node->right;
+			DMap_DeleteNode( self, node );
+			node = next;
+		}
 	}else{
 		DMap_DeleteTree( self, self->root );
 	}
@@ -415,9 +487,16 @@ void DMap_Reset( DMap *self )
 {
 	if( DMap_Lockable( self ) ) DaoGC_LockData();
 	if( self->hashing ){
-		size_t i, tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		for(i=0; i<tsize; i++) DMap_BufferTree( self, self->table[i] );
-		memset( self->table, 0, tsize*sizeof(DNode*) );
+		DNode *node = self->root;
+		while( node ){
+			DNode *next = node->right;
+			DMap_BufferNode( self, node );
+			node = next;
+		}
+		memset( self->control, DHASH_EMPTY, self->tsize );
+		DHash_FreeTable0( self );
+		self->used = 0;
+		self->last = NULL;
 	}else{
 		DMap_BufferTree( self, self->root );
 	}
@@ -628,15 +707,7 @@ void DMap_EraseNode( DMap *self, DNode *node )
 {
 	if( node == NULL ) return;
 	if( self->hashing ){
-		size_t tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		int hash = node->hash;
-		self->root = self->table[ hash % tsize ];
-		if( self->root == NULL ) return;
-		if( DMap_Lockable( self ) ) DaoGC_LockData();
-		DMap_EraseChild( self, node );
-		self->table[ hash % tsize ] = self->root;
-		if( DMap_Lockable( self ) ) DaoGC_UnlockData();
-		if( self->size < 0.25*tsize ) DHash_ResetTable( self );
+		DHash_EraseNode( self, node );
 	}else{
 		if( DMap_Lockable( self ) ) DaoGC_LockData();
 		DMap_EraseChild( self, node );
@@ -726,6 +797,230 @@ static daoint DMap_CompareKeys( DMap *self, DNode *n1, DNode *n2 )
 	return cmp;
 }
 
+
+static DHashGroup DHash_LoadGroup( uchar_t *control )
+{
+	DHashGroup group = control[0] | ((DHashGroup)control[1] << 8);
+	group |= ((DHashGroup)control[2] << 16) | ((DHashGroup)control[3] << 24);
+	group |= ((DHashGroup)control[4] << 32) | ((DHashGroup)control[5] << 40);
+	group |= ((DHashGroup)control[6] << 48) | ((DHashGroup)control[7] << 56);
+	return group;
+}
+/*
+// Each of the following returns a mask with the highest bit set in the bytes
+// that match. DHash_MatchHash() may report false positives, which are ruled
+// out by the subsequent key comparison.
+*/
+static DHashGroup DHash_MatchHash( DHashGroup group, uint_t hash )
+{
+	DHashGroup bytes = group ^ (DHASH_LSBS * (hash & 0x7F));
+	return (bytes - DHASH_LSBS) & ~bytes & DHASH_MSBS;
+}
+static DHashGroup DHash_MatchEmpty( DHashGroup group )
+{
+	return group & (~group << 6) & DHASH_MSBS;
+}
+static DHashGroup DHash_MatchFree( DHashGroup group )
+{
+	return group & (~group << 7) & DHASH_MSBS;
+}
+static int DHash_FirstMatch( DHashGroup mask )
+{
+#ifdef __GNUC__
+	return __builtin_ctzll( mask ) >> 3;
+#else
+	int i = 0;
+	while( (mask & 0x80) == 0 ) mask >>= 8, i += 1;
+	return i;
+#endif
+}
+/*
+// Groups are probed quadratically (triangular numbers), which visits every group
+// since the number of groups is a power of two. The table is never full, so the
+// probing always terminates. The control bytes follow the slots of a table.
+*/
+static DNode* DHash_FindSlot( DMap *self, DNode **table, size_t tsize, DNode *query )
+{
+	uchar_t *control = (uchar_t*) (table + tsize);
+	size_t mask = tsize / DHASH_GROUP - 1;
+	size_t k, g = (query->hash >> 7) & mask;
+
+	for(k=1; ; ++k){
+		DHashGroup group = DHash_LoadGroup( control + g * DHASH_GROUP );
+		DHashGroup match = DHash_MatchHash( group, query->hash );
+		while( match ){
+			DNode *node = table[ g * DHASH_GROUP + DHash_FirstMatch( match ) ];
+			if( DMap_CompareKeys( self, query, node ) == 0 ) return node;
+			match &= match - 1;
+		}
+		if( DHash_MatchEmpty( group ) ) return NULL;
+		g = (g + k) & mask;
+	}
+	return NULL;
+}
+/* Return the slot index of the node, or "tsize" if the node is not in the table: */
+static size_t DHash_LocateSlot( DNode **table, size_t tsize, DNode *node )
+{
+	uchar_t *control = (uchar_t*) (table + tsize);
+	size_t mask = tsize / DHASH_GROUP - 1;
+	size_t k, g = (node->hash >> 7) & mask;
+
+	for(k=1; ; ++k){
+		DHashGroup group = DHash_LoadGroup( control + g * DHASH_GROUP );
+		DHashGroup match = DHash_MatchHash( group, node->hash );
+		while( match ){
+			size_t slot = g * DHASH_GROUP + DHash_FirstMatch( match );
+			if( table[slot] == node ) return slot;
+			match &= match - 1;
+		}
+		if( DHash_MatchEmpty( group ) ) return tsize;
+		g = (g + k) & mask;
+	}
+	return tsize;
+}
+static void DHash_InsertSlot( DMap *self, DNode *node )
+{
+	size_t mask = self->tsize / DHASH_GROUP - 1;
+	size_t k, g = (node->hash >> 7) & mask;
+
+	for(k=1; ; ++k){
+		DHashGroup group = DHash_LoadGroup( self->control + g * DHASH_GROUP );
+		DHashGroup match = DHash_MatchFree( group );
+		if( match ){
+			size_t slot = g * DHASH_GROUP + DHash_FirstMatch( match );
+			if( self->control[slot] == DHASH_EMPTY ) self->used += 1;
+			self->control[slot] = node->hash & 0x7F;
+			self->table[slot] = node;
+			return;
+		}
+		g = (g + k) & mask;
+	}
+}
+/*
+// Large tables are resized incrementally: the previous table is kept as "table0",
+// and its slots are moved to the new table a few at a time by each insertion or
+// erasure. Until all of them are moved, lookups check both tables. Lookups never
+// move slots, so concurrent reading of a map remains safe.
+*/
+static void DHash_MoveSlots( DMap *self, size_t count )
+{
+	uchar_t *control = (uchar_t*) (self->table0 + self->tsize0);
+	size_t i, end = self->moved + count;
+
+	if( end > self->tsize0 ) end = self->tsize0;
+	for(i=self->moved; i<end; ++i){
+		if( control[i] & 0x80 ) continue; /* Empty or erased; */
+		control[i] = DHASH_ERASED;
+		DHash_InsertSlot( self, self->table0[i] );
+	}
+	self->moved = end;
+	if( end == self->tsize0 ) DHash_FreeTable0( self );
+}
+/*
+// Resize the table and drop the erased slots. The node chain is not touched,
+// so iterations and the concurrent GC scanning are not affected.
+*/
+static void DHash_ResetTable( DMap *self, size_t tsize )
+{
+	DNode *node, **table;
+	size_t tsize0;
+
+	if( self->table0 ) DHash_MoveSlots( self, self->tsize0 );
+
+	table = self->table;
+	tsize0 = self->tsize;
+	DHash_InitTable( self, tsize );
+	if( tsize0 >= DHASH_MOVING ){
+		self->table0 = table;
+		self->tsize0 = tsize0;
+		self->moved = 0;
+		return;
+	}
+	for(node=self->root; node; node=node->right) DHash_InsertSlot( self, node );
+	dao_free( table );
+}
+static DNode* DHash_FindNode( DMap *self, DNode *query )
+{
+	DNode *node = DHash_FindSlot( self, self->table, self->tsize, query );
+	if( node == NULL && self->table0 ){
+		node = DHash_FindSlot( self, self->table0, self->tsize0, query );
+	}
+	return node;
+}
+static void DHash_EraseNode( DMap *self, DNode *node )
+{
+	DNode **table = self->table;
+	size_t tsize = self->tsize;
+	size_t slot = DHash_LocateSlot( table, tsize, node );
+	uchar_t *control;
+
+	if( slot == tsize ){
+		table = self->table0;
+		tsize = self->tsize0;
+		slot = DHash_LocateSlot( table, tsize, node );
+	}
+	control = (uchar_t*) (table + tsize);
+
+	if( DMap_Lockable( self ) ) DaoGC_LockData();
+	/*
+	// Empty slots are only created by rebuilding the table. So if the group still
+	// has an empty slot, no probing has ever passed through it, and the erased
+	// slot can become empty instead of being marked as erased.
+	*/
+	if( DHash_MatchEmpty( DHash_LoadGroup( control + slot - slot % DHASH_GROUP ) ) ){
+		control[slot] = DHASH_EMPTY;
+		if( table == self->table ) self->used -= 1;
+	}else{
+		control[slot] = DHASH_ERASED;
+	}
+	if( node->left ) node->left->right = node->right; else self->root = node->right;
+	if( node->right ) node->right->left = node->left; else self->last = node->left;
+	self->size -= 1;
+	DMap_BufferNode( self, node );
+	if( DMap_Lockable( self ) ) DaoGC_UnlockData();
+
+	if( self->table0 ){
+		DHash_MoveSlots( self, DHASH_MOVES );
+	}else if( self->tsize > DHASH_MINSIZE && 8*self->size < self->tsize ){
+		DHash_ResetTable( self, self->tsize / 2 );
+	}
+}
+static DNode* DHash_Insert( DMap *self, void *key, void *value )
+{
+	DNode query = {0};
+	DNode *node;
+
+	query.hash = DHash_HashIndex( self, key );
+	query.key.pVoid = key;
+	node = DHash_FindNode( self, & query );
+	if( node != NULL ){
+		DMap_UpdateValue( self, node, value );
+		return node;
+	}
+	if( self->table0 ) DHash_MoveSlots( self, DHASH_MOVES );
+
+	/* Keep the load (including the erased slots) under 7/8: */
+	if( 8*(self->used + 1) > 7*self->tsize ){
+		size_t tsize = self->tsize;
+		if( 16*(self->size + 1) > 7*tsize ) tsize *= 2;
+		DHash_ResetTable( self, tsize );
+	}
+	node = DNode_New( self, self->keytype, self->valtype );
+	node->hash = query.hash;
+	DMap_CopyItem( & node->key.pVoid, key, self->keytype );
+	DMap_CopyItem( & node->value.pVoid, value, self->valtype );
+
+	if( DMap_Lockable( self ) ) DaoGC_LockData();
+	DHash_InsertSlot( self, node );
+	node->left = self->last;
+	node->right = NULL;
+	if( self->last ) self->last->right = node; else self->root = node;
+	self->last = node;
+	self->size += 1;
+	if( DMap_Lockable( self ) ) DaoGC_UnlockData();
+	return node;
+}
+
 static DNode* DMap_FindChild( DMap *self, DNode *root, DNode *query, int type )
 {
 	DNode *p = root;
@@ -750,16 +1045,14 @@ static DNode* DMap_FindChild( DMap *self, DNode *root, DNode *query, int type )
 }
 DNode* DMap_FindNode( DMap *self, void *key, int type )
 {
-	DNode query = {0, 0, NULL, NULL};
+	DNode query = {0};
 	DNode *root = self->root;
 
 	query.key.pVoid = key;
 	if( self->hashing ){
-		size_t tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		int hash = DHash_HashIndex( self, key );
-		query.hash = hash;
-		root = self->table[hash % tsize];
-		if( root == NULL ) return NULL;
+		/* Key ordering is not defined for hash maps, only exact match is done: */
+		query.hash = DHash_HashIndex( self, key );
+		return DHash_FindNode( self, & query );
 	}
 	return DMap_FindChild( self, root, & query, type );
 }
@@ -795,24 +1088,14 @@ static DNode* DMap_SimpleInsert( DMap *self, DNode *node )
 }
 DNode* DMap_Insert( DMap *self, void *key, void *value )
 {
-	DNode *p, *node = DNode_New( self, self->keytype, self->valtype );
-	void *okey = node->key.pVoid;
-	void *ovalue = node->value.pVoid;
-	size_t tsize = self->tsize2rt * (size_t)self->tsize2rt;
-	int locked, id = 0;
-	if( self->hashing ){
-		id = DHash_HashIndex( self, key );
-		node->hash = id;
-		self->root = self->table[id % tsize];
-		if( self->root ==NULL ){
-			self->size += 1;
-			self->table[id % tsize] = node;
-			node->color = RB_BLACK;
-			DMap_CopyItem( & node->key.pVoid, key, self->keytype );
-			DMap_CopyItem( & node->value.pVoid, value, self->valtype );
-			return node;
-		}
-	}
+	DNode *p, *node;
+	void *okey, *ovalue;
+
+	if( self->hashing ) return DHash_Insert( self, key, value );
+
+	node = DNode_New( self, self->keytype, self->valtype );
+	okey = node->key.pVoid;
+	ovalue = node->value.pVoid;
 	node->key.pVoid = key;
 	node->value.pVoid = value;
 	p = DMap_SimpleInsert( self, node );
@@ -824,16 +1107,8 @@ DNode* DMap_Insert( DMap *self, void *key, void *value )
 		if( DMap_Lockable( self ) ) DaoGC_LockData();
 		DMap_InsertNode( self, node );
 		if( DMap_Lockable( self ) ) DaoGC_UnlockData();
-		if( self->hashing ){
-			self->table[id % tsize] = self->root;
-			if( self->size >= tsize ) DHash_ResetTable( self );
-		}
 	}else{
-		if( self->valtype < DAO_DATA_VALUE || self->valtype > DAO_DATA_VALUE3 ){
-			DMap_DeleteItem( & p->value.pVoid, self->valtype );
-			p->value.pVoid = NULL;
-		}
-		DMap_CopyItem( & p->value.pVoid, value, self->valtype );
+		DMap_UpdateValue( self, p, value );
 		DMap_BufferNode( self, node );
 	}
 	return p;
@@ -850,26 +1125,15 @@ DNode* DMap_First( DMap *self )
 {
 	DNode *node = NULL;
 	if( self == NULL ) return NULL;
-	if( self->hashing ){
-		size_t i = 0, tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		while( i < tsize && self->table[i] == NULL ) i += 1;
-		if( i < tsize ) node = DNode_First( self->table[i] );
-	}
-	if( node == NULL && self->root ) node = DNode_First( self->root );
+	if( self->hashing ) return self->root;
+	if( self->root ) node = DNode_First( self->root );
 	return node;
 }
 DNode* DMap_Next( DMap *self, DNode *node )
 {
-	DNode *next;
 	if( node == NULL ) return NULL;
-	next = DNode_Next( node );
-	if( next == NULL && self->hashing ){
-		size_t tsize = self->tsize2rt * (size_t)self->tsize2rt;
-		size_t i = node->hash % tsize + 1;
-		while( i < tsize && self->table[i] == NULL ) i += 1;
-		if( i < tsize ) next = DNode_First( self->table[i] );
-	}
-	return next;
+	if( self->hashing ) return node->right;
+	return DNode_Next( node );
 }
 
 
@@ -79,14 +79,25 @@ struct DNode
 
 typedef DMap DHash;
 
+/*
+// Hash maps (with non-zero hashing seed) store the nodes in an open addressing
+// hash table, and chain them in insertion order through "left" and "right";
+// Ordered maps store the nodes in a red-black tree;
+*/
 struct DMap
 {
-	DNode   **table;        /* Hash table, each entry is a tree; */
-	DNode    *root;         /* Root node; */
+	DNode   **table;        /* Hash table slots; */
+	uchar_t  *control;      /* Control bytes of the hash table slots; */
+	DNode   **table0;       /* Previous hash table being resized incrementally; */
+	DNode    *root;         /* Root node, or the first node of a hash map; */
+	DNode    *last;         /* Last node of a hash map; */
 	DNode    *list;         /* First node of the free list; */
 	size_t    size;         /* Size of the map; */
+	size_t    used;         /* Number of hash table slots in use or erased; */
 	uint_t    hashing;      /* Hashing seed; */
-	uint_t    tsize2rt;     /* Square root of the table size; */
+	uint_t    tsize;        /* Hash table size (power of two); */
+	uint_t    tsize0;       /* Size of the previous hash table; */
+	uint_t    moved;        /* Slots moved from the previous hash table; */
 	uint_t    keytype :  4; /* Key type; */
 	uint_t    valtype :  4; /* Value type; */
 	uint_t    changes : 24; /* Changes that may change the tree structure(s); */
@@ -100,6 +111,7 @@ DAO_DLL void DMap_Assign( DMap *self, DMap *other );
 DAO_DLL void DMap_Delete( DMap *self );
 DAO_DLL void DMap_Clear( DMap *self );
 DAO_DLL void DMap_Reset( DMap *self );
+DAO_DLL void DMap_SetHashing( DMap *self, uint_t hashing );
 DAO_DLL void DMap_Erase( DMap *self, void *key );
 DAO_DLL void DMap_EraseNode( DMap *self, DNode *node );
 
@@ -118,4 +130,7 @@ DAO_DLL DNode* DMap_Next( DMap *self, DNode *node );
 
 DAO_DLL unsigned int Dao_Hash( const void *key, int len, unsigned int seed );
 
+/* Hash value consistent with the hash maps of values: */
+DAO_DLL int DaoValue_Hash( DaoValue *self, unsigned int seed );
+
 #endif
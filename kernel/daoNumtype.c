@@ -183,6 +183,86 @@ DaoArray* DaoArray_New( int etype )
 
 static int DaoArray_DataTypeSize( DaoArray *self );
 
+static dao_integer DaoArray_GetCompactInteger( DaoArray *self, daoint i )
+{
+	switch( self->stype ){
+	case DAO_ARRAY_SINT8   : return self->data.i8[i];
+	case DAO_ARRAY_SINT16  : return self->data.i16[i];
+	case DAO_ARRAY_SINT32  : return self->data.i32[i];
+	case DAO_ARRAY_FLOAT32 : return (dao_integer) self->data.f32[i];
+	default : break;
+	}
+	return 0;
+}
+static dao_float DaoArray_GetCompactFloat( DaoArray *self, daoint i )
+{
+	switch( self->stype ){
+	case DAO_ARRAY_SINT8   : return self->data.i8[i];
+	case DAO_ARRAY_SINT16  : return self->data.i16[i];
+	case DAO_ARRAY_SINT32  : return self->data.i32[i];
+	case DAO_ARRAY_FLOAT32 : return self->data.f32[i];
+	default : break;
+	}
+	return 0;
+}
+/*
+// Element setters for both the default and the compact storages;
+// Values are narrowed (and truncated if necessary) to the storage type:
+*/
+static void DaoArray_SetInteger( DaoArray *self, daoint i, dao_integer value )
+{
+	switch( self->stype ){
+	case DAO_ARRAY_SINT8   : self->data.i8[i]  = (signed char) value; return;
+	case DAO_ARRAY_SINT16  : self->data.i16[i] = (short) value; return;
+	case DAO_ARRAY_SINT32  : self->data.i32[i] = (int) value; return;
+	case DAO_ARRAY_FLOAT32 : self->data.f32[i] = (float) value; return;
+	default : break;
+	}
+	switch( self->etype ){
+	case DAO_BOOLEAN : self->data.b[i] = value != 0; break;
+	case DAO_INTEGER : self->data.i[i] = value; break;
+	case DAO_FLOAT   : self->data.f[i] = value; break;
+	case DAO_COMPLEX : self->data.c[i].real = value; self->data.c[i].imag = 0.0; break;
+	default : break;
+	}
+}
+static void DaoArray_SetFloat( DaoArray *self, daoint i, dao_float value )
+{
+	switch( self->stype ){
+	case DAO_ARRAY_SINT8   :
+	case DAO_ARRAY_SINT16  :
+	case DAO_ARRAY_SINT32  : DaoArray_SetInteger( self, i, (dao_integer) value ); return;
+	case DAO_ARRAY_FLOAT32 : self->data.f32[i] = (float) value; return;
+	default : break;
+	}
+	switch( self->etype ){
+	case DAO_BOOLEAN : self->data.b[i] = value != 0.0; break;
+	case DAO_INTEGER : self->data.i[i] = (dao_integer) value; break;
+	case DAO_FLOAT   : self->data.f[i] = value; break;
+	case DAO_COMPLEX : self->data.c[i].real = value; self->data.c[i].imag = 0.0; break;
+	default : break;
+	}
+}
+static void DaoArray_SetComplex( DaoArray *self, daoint i, dao_complex value )
+{
+	if( self->etype == DAO_COMPLEX ){
+		self->data.c[i] = value;
+	}else{
+		DaoArray_SetFloat( self, i, value.real );
+	}
+}
+/* Copy the j-th element of "other" to the i-th element of "self": */
+static void DaoArray_MoveItem( DaoArray *self, daoint i, DaoArray *other, daoint j )
+{
+	switch( other->etype ){
+	case DAO_BOOLEAN :
+	case DAO_INTEGER : DaoArray_SetInteger( self, i, DaoArray_GetInteger( other, j ) ); break;
+	case DAO_FLOAT   : DaoArray_SetFloat( self, i, DaoArray_GetFloat( other, j ) ); break;
+	case DAO_COMPLEX : DaoArray_SetComplex( self, i, DaoArray_GetComplex( other, j ) ); break;
+	default : break;
+	}
+}
+
 DaoArray* DaoArray_Copy( DaoArray *self, DaoType *type )
 {
 	DaoArray *copy = DaoArray_New( self->etype );
@@ -190,6 +270,7 @@ DaoArray* DaoArray_Copy( DaoArray *self, DaoType *type )
 		int nt = type->args->items.pType[0]->tid;
 		if( nt >= DAO_INTEGER && nt <= DAO_COMPLEX ) copy->etype = nt;
 	}
+	if( copy->etype == self->etype ) copy->stype = self->stype;
 	DaoArray_ResizeArray( copy, self->dims, self->ndim );
 	if( copy->etype == self->etype ){
 		memcpy( copy->data.p, self->data.p, self->size * DaoArray_DataTypeSize( self ) );
@@ -206,6 +287,7 @@ void DaoArray_Delete( DaoArray *self )
 #endif
 	if( self->dims ) dao_free( self->dims );
 	if( self->owner && self->data.p ) dao_free( self->data.p );
+	if( self->mapping ) Dao_UnmapFile( self->mapping );
 	if( self->slices ) DArray_Delete( self->slices );
 	if( self->original ) GC_DecRC( self->original );
 	dao_free( self );
@@ -213,6 +295,12 @@ void DaoArray_Delete( DaoArray *self )
 
 static int DaoArray_DataTypeSize( DaoArray *self )
 {
+	switch( self->stype ){
+	case DAO_ARRAY_SINT8   : return sizeof(signed char);
+	case DAO_ARRAY_SINT16  : return sizeof(short);
+	case DAO_ARRAY_SINT32  : return sizeof(int);
+	case DAO_ARRAY_FLOAT32 : return sizeof(float);
+	}
 	switch( self->etype ){
 	case DAO_BOOLEAN : return sizeof(dao_boolean);
 	case DAO_INTEGER : return sizeof(dao_integer);
@@ -225,8 +313,9 @@ static int DaoArray_DataTypeSize( DaoArray *self )
 void DaoArray_SetNumType( DaoArray *self, short numtype )
 {
 	int k, n, m = DaoArray_DataTypeSize( self );
-	if( self->etype == numtype ) return;
+	if( self->etype == numtype && self->stype == DAO_ARRAY_DEFAULT ) return;
 	self->etype = numtype;
+	self->stype = DAO_ARRAY_DEFAULT;
 	k = DaoArray_DataTypeSize( self );
 	n = self->size * m / (k ? k : 1);
 	DaoArray_ResizeData( self, self->size, n );
@@ -280,7 +369,7 @@ int DaoArray_Reshape( DaoArray *self, daoint *dims, int D )
 	int i, size = 1;
 	for(i=0; i<D; ++i) size *= dims[i];
 
-	if( self->owner && self->size != size ) return 0;
+	if( (self->owner || self->mapping) && self->size != size ) return 0;
 	DaoArray_SetDimCount( self, D );
 	memcpy( self->dims, dims, D*sizeof(daoint) );
 	DaoArray_FinalizeDimData( self );
@@ -291,6 +380,15 @@ void DaoArray_ResizeData( DaoArray *self, daoint size, daoint old )
 {
 	daoint item_size = DaoArray_DataTypeSize( self );
 	daoint diff = size - old;
+	if( self->mapping != NULL ){
+		/* Resizing a file backed array detaches it from the mapped file: */
+		void *data = dao_malloc( size * item_size );
+		memcpy( data, self->data.p, (size < old ? size : old) * item_size );
+		Dao_UnmapFile( self->mapping );
+		self->mapping = NULL;
+		self->data.p = data;
+		self->owner = 1;
+	}
 	if( self->owner ==0 ){
 		self->size = size;
 		return;
@@ -352,10 +450,51 @@ void DaoArray_ResizeArray( DaoArray *self, daoint *dims, int D )
 
 void DaoArray_UseData( DaoArray *self, void *data )
 {
-	if( self->data.p ) dao_free( self->data.p );
+	if( self->owner && self->data.p ) dao_free( self->data.p );
+	if( self->mapping ) Dao_UnmapFile( self->mapping );
+	self->mapping = NULL;
 	self->data.p = data;
 	self->owner = 0;
 }
+/*
+// Use the data from a memory mapped file starting at "offset";
+// The array takes over the ownership of the mapping;
+*/
+void DaoArray_UseMappedData( DaoArray *self, DMappedFile *mapping, daoint offset )
+{
+	DaoArray_UseData( self, (char*) mapping->data + offset );
+	self->mapping = mapping;
+}
+/*
+// Convert the data to a different storage (DaoArrayStorage);
+// Return zero if the storage is not supported by the element type:
+*/
+int DaoArray_SetStorage( DaoArray *self, int stype )
+{
+	DaoArray *copy;
+
+	switch( stype ){
+	case DAO_ARRAY_DEFAULT : break;
+	case DAO_ARRAY_SINT8   :
+	case DAO_ARRAY_SINT16  :
+	case DAO_ARRAY_SINT32  : if( self->etype != DAO_INTEGER ) return 0; break;
+	case DAO_ARRAY_FLOAT32 : if( self->etype != DAO_FLOAT ) return 0; break;
+	default : return 0;
+	}
+	if( self->original ) DaoArray_Sliced( self );
+	if( self->stype == stype ) return 1;
+
+	copy = DaoArray_New( self->etype );
+	copy->stype = stype;
+	DaoArray_ResizeArray( copy, self->dims, self->ndim );
+	DaoArray_CopyArray( copy, self );
+	DaoArray_UseData( self, copy->data.p );
+	self->stype = stype;
+	self->owner = 1;
+	copy->data.p = NULL;
+	DaoArray_Delete( copy );
+	return 1;
+}
 
 void DaoArray_GetSliceShape( DaoArray *self, daoint **dims, short *ndim )
 {
@@ -387,11 +526,24 @@ void DaoArray_GetSliceShape( DaoArray *self, daoint **dims, short *ndim )
 	DList_Delete( shape );
 }
 
+/*
+// Slices take the compact storage of their original arrays;
+// the old data is discarded as it will be overwritten by the slicing:
+*/
+static void DaoArray_SliceStorage( DaoArray *self, DaoArray *original )
+{
+	if( self->etype != original->etype || self->stype == original->stype ) return;
+	if( self->owner == 0 && self->mapping == NULL && self->data.p != NULL ) return;
+	DaoArray_ResizeVector( self, 0 );
+	self->stype = original->stype;
+}
+
 int DaoArray_SliceFrom( DaoArray *self, DaoArray *original, DArray *slices )
 {
 	daoint i, j, k, D = 0, S = 0;
 	daoint size, step, start, len;
 
+	DaoArray_SliceStorage( self, original );
 	if( slices == NULL ){
 		DaoArray_ResizeArray( self, original->dims, original->ndim );
 		DaoArray_CopyArray( self, original );
@@ -420,6 +572,13 @@ int DaoArray_SliceFrom( DaoArray *self, DaoArray *original, DArray *slices )
 	len   = slices->data.daoints[2*original->ndim + DAO_SLICE_LENGTH];
 	size  = slices->data.daoints[2*original->ndim + DAO_SLICE_COUNT] * len;
 	step  = slices->data.daoints[2*original->ndim + DAO_SLICE_STEP];
+	if( self->stype || original->stype ){
+		for(i=0; i<size; ++i){
+			j = start + (i / len) * step + (i % len);
+			DaoArray_MoveItem( self, i, original, j );
+		}
+		return 1;
+	}
 	for(i=0; i<size; ++i){
 		j = start + (i / len) * step + (i % len);
 		switch( self->etype ){
@@ -533,6 +692,18 @@ static int DaoArray_Permute( DaoArray *self, DList *perm )
 		if( min != i ) continue; /* Not a cycle start; */
 
 		k = i;
+		if( self->stype ){
+			fval = DaoArray_GetFloat( self, i );
+			while(1){
+				Array_FlatIndex2MultiIndex( dim, D, k, permIndex );
+				for(j=0; j<D; j++) origIndex[ pm[j] ] = permIndex[j];
+				m = Array_MultIndex2FlatIndex( self->dims + self->ndim, D, origIndex );
+				DaoArray_SetFloat( self, k, (m == min) ? fval : DaoArray_GetFloat( self, m ) );
+				if( m == min ) break;
+				k = m;
+			}
+			continue;
+		}
 		switch( self->etype ){
 		case DAO_BOOLEAN : ival = self->data.b[i]; break;
 		case DAO_INTEGER : ival = self->data.i[i]; break;
@@ -576,7 +747,7 @@ void DaoArray_FinalizeDimData( DaoArray *self )
 
 	prods[ D - 1 ] = 1;
 	for(i=D-2; i>=0; i--) prods[i] = prods[i+1] * self->dims[i+1];
-	self->size = (int)( self->dims[0] * prods[0] );
+	self->size = self->dims[0] * prods[0];
 }
 
 static int Dao_SliceRange( DArray *slices, daoint N, daoint first, daoint end )
@@ -756,6 +927,7 @@ daoint DaoArray_GetWorkIntervalSize( DaoArray *self )
 
 dao_boolean DaoArray_GetBoolean( DaoArray *self, daoint i )
 {
+	if( self->stype ) return DaoArray_GetCompactFloat( self, i ) != 0.0;
 	switch( self->etype ){
 	case DAO_BOOLEAN : return self->data.b[i];
 	case DAO_INTEGER : return self->data.i[i] != 0;
@@ -767,6 +939,7 @@ dao_boolean DaoArray_GetBoolean( DaoArray *self, daoint i )
 }
 dao_integer DaoArray_GetInteger( DaoArray *self, daoint i )
 {
+	if( self->stype ) return DaoArray_GetCompactInteger( self, i );
 	switch( self->etype ){
 	case DAO_BOOLEAN : return self->data.b[i];
 	case DAO_INTEGER : return self->data.i[i];
@@ -778,6 +951,7 @@ dao_integer DaoArray_GetInteger( DaoArray *self, daoint i )
 }
 dao_float DaoArray_GetFloat( DaoArray *self, daoint i )
 {
+	if( self->stype ) return DaoArray_GetCompactFloat( self, i );
 	switch( self->etype ){
 	case DAO_BOOLEAN : return self->data.b[i];
 	case DAO_INTEGER : return self->data.i[i];
@@ -790,6 +964,10 @@ dao_float DaoArray_GetFloat( DaoArray *self, daoint i )
 dao_complex DaoArray_GetComplex( DaoArray *self, daoint i )
 {
 	dao_complex com = {0,0};
+	if( self->stype ){
+		com.real = DaoArray_GetCompactFloat( self, i );
+		return com;
+	}
 	switch( self->etype ){
 	case DAO_BOOLEAN : com.real = self->data.b[i]; break;
 	case DAO_INTEGER : com.real = self->data.i[i]; break;
@@ -802,6 +980,14 @@ dao_complex DaoArray_GetComplex( DaoArray *self, daoint i )
 DaoValue* DaoArray_GetValue( DaoArray *self, daoint i, DaoValue *res )
 {
 	res->type = self->etype;
+	if( self->stype ){
+		if( self->etype == DAO_INTEGER ){
+			res->xInteger.value = DaoArray_GetCompactInteger( self, i );
+		}else{
+			res->xFloat.value = DaoArray_GetCompactFloat( self, i );
+		}
+		return res;
+	}
 	switch( self->etype ){
 	case DAO_BOOLEAN : res->xBoolean.value = self->data.b[i]; break;
 	case DAO_INTEGER : res->xInteger.value = self->data.i[i]; break;
@@ -813,6 +999,14 @@ DaoValue* DaoArray_GetValue( DaoArray *self, daoint i, DaoValue *res )
 }
 void DaoArray_SetValue( DaoArray *self, daoint i, DaoValue *value )
 {
+	if( self->stype ){
+		if( self->etype == DAO_INTEGER ){
+			DaoArray_SetInteger( self, i, DaoValue_GetInteger( value ) );
+		}else{
+			DaoArray_SetFloat( self, i, DaoValue_GetFloat( value ) );
+		}
+		return;
+	}
 	switch( self->etype ){
 	case DAO_BOOLEAN : self->data.b[i] = ! DaoValue_IsZero( value ); break;
 	case DAO_INTEGER : self->data.i[i] = DaoValue_GetInteger( value ); break;
@@ -828,6 +1022,7 @@ dao_float* DaoArray_ToFloat( DaoArray *self )
 	dao_float *buf;
 
 	DaoArray_Sliced( self );
+	DaoArray_SetStorage( self, DAO_ARRAY_DEFAULT );
 	buf = self->data.f;
 	if( self->etype == DAO_FLOAT || self->etype == DAO_COMPLEX ) return buf;
 	switch( self->etype ){
@@ -852,6 +1047,7 @@ dao_integer* DaoArray_ToInteger( DaoArray *self )
 	dao_integer *buf;
 
 	DaoArray_Sliced( self );
+	DaoArray_SetStorage( self, DAO_ARRAY_DEFAULT );
 	buf = self->data.i;
 	if( self->etype == DAO_INTEGER ) return self->data.i;
 	size = self->size;
@@ -877,12 +1073,18 @@ void DaoArray_FromInteger( DaoArray *self )
 	}
 }
 
-#define DefineFunction_DaoArray_To( name, type, cast ) \
+/*
+// Arrays in the compact storage of the requested type are used directly,
+// arrays in other compact storages are converted to the default storage first:
+*/
+#define DefineFunction_DaoArray_To( name, type, cast, storage ) \
 type* name( DaoArray *self ) \
 { \
 	daoint i, size; \
 	type *buf; \
 	DaoArray_Sliced( self ); \
+	if( storage && self->stype == storage ) return (type*) self->data.p; \
+	DaoArray_SetStorage( self, DAO_ARRAY_DEFAULT ); \
 	buf = (type*) self->data.p; \
 	size = self->size; \
 	switch( self->etype ){ \
@@ -899,20 +1101,21 @@ type* name( DaoArray *self ) \
 	} \
 	return buf; \
 }
-DefineFunction_DaoArray_To( DaoArray_ToSInt8, signed char, int );
-DefineFunction_DaoArray_To( DaoArray_ToSInt16, signed short, int );
-DefineFunction_DaoArray_To( DaoArray_ToSInt32, signed int, int );
-DefineFunction_DaoArray_To( DaoArray_ToUInt8, unsigned char, unsigned int );
-DefineFunction_DaoArray_To( DaoArray_ToUInt16, unsigned short, unsigned int );
-DefineFunction_DaoArray_To( DaoArray_ToUInt32, unsigned int, unsigned int );
-static DefineFunction_DaoArray_To( DaoArray_ToFloat32X, float, float );
-static DefineFunction_DaoArray_To( DaoArray_ToFloat64X, double, double );
+DefineFunction_DaoArray_To( DaoArray_ToSInt8, signed char, int, DAO_ARRAY_SINT8 );
+DefineFunction_DaoArray_To( DaoArray_ToSInt16, signed short, int, DAO_ARRAY_SINT16 );
+DefineFunction_DaoArray_To( DaoArray_ToSInt32, signed int, int, DAO_ARRAY_SINT32 );
+DefineFunction_DaoArray_To( DaoArray_ToUInt8, unsigned char, unsigned int, DAO_ARRAY_DEFAULT );
+DefineFunction_DaoArray_To( DaoArray_ToUInt16, unsigned short, unsigned int, DAO_ARRAY_DEFAULT );
+DefineFunction_DaoArray_To( DaoArray_ToUInt32, unsigned int, unsigned int, DAO_ARRAY_DEFAULT );
+static DefineFunction_DaoArray_To( DaoArray_ToFloat32X, float, float, DAO_ARRAY_FLOAT32 );
+static DefineFunction_DaoArray_To( DaoArray_ToFloat64X, double, double, DAO_ARRAY_DEFAULT );
 
-#define DefineFunction_DaoArray_From( name, type ) \
+#define DefineFunction_DaoArray_From( name, type, storage ) \
 void name( DaoArray *self ) \
 { \
 	daoint i, size = self->size; \
 	type *buf = (type*) self->data.p; \
+	if( storage && self->stype == storage ) return; \
 	switch( self->etype ){ \
 	case DAO_BOOLEAN : for(i=size-1; i>=0; i--) self->data.b[i] = buf[i] != 0; break; \
 	case DAO_INTEGER : for(i=size-1; i>=0; i--) self->data.i[i] = buf[i]; break; \
@@ -927,37 +1130,37 @@ void name( DaoArray *self ) \
 	} \
 }
 
-DefineFunction_DaoArray_From( DaoArray_FromSInt8, signed char );
-DefineFunction_DaoArray_From( DaoArray_FromSInt16, signed short );
-DefineFunction_DaoArray_From( DaoArray_FromSInt32, signed int );
-DefineFunction_DaoArray_From( DaoArray_FromUInt8, unsigned char );
-DefineFunction_DaoArray_From( DaoArray_FromUInt16, unsigned short );
-DefineFunction_DaoArray_From( DaoArray_FromUInt32, unsigned int );
-static DefineFunction_DaoArray_From( DaoArray_FromFloat32X, float );
-static DefineFunction_DaoArray_From( DaoArray_FromFloat64X, double );
+DefineFunction_DaoArray_From( DaoArray_FromSInt8, signed char, DAO_ARRAY_SINT8 );
+DefineFunction_DaoArray_From( DaoArray_FromSInt16, signed short, DAO_ARRAY_SINT16 );
+DefineFunction_DaoArray_From( DaoArray_FromSInt32, signed int, DAO_ARRAY_SINT32 );
+DefineFunction_DaoArray_From( DaoArray_FromUInt8, unsigned char, DAO_ARRAY_DEFAULT );
+DefineFunction_DaoArray_From( DaoArray_FromUInt16, unsigned short, DAO_ARRAY_DEFAULT );
+DefineFunction_DaoArray_From( DaoArray_FromUInt32, unsigned int, DAO_ARRAY_DEFAULT );
+static DefineFunction_DaoArray_From( DaoArray_FromFloat32X, float, DAO_ARRAY_FLOAT32 );
+static DefineFunction_DaoArray_From( DaoArray_FromFloat64X, double, DAO_ARRAY_DEFAULT );
 
 float* DaoArray_ToFloat32( DaoArray *self )
 {
-	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(float) ){
+	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(float) && self->stype == 0 ){
 		return (float*) self->data.f;
 	}
 	return DaoArray_ToFloat32X( self );
 }
 void DaoArray_FromFloat32( DaoArray *self )
 {
-	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(float) ) return;
+	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(float) && self->stype == 0 ) return;
 	DaoArray_FromFloat32X( self );
 }
 double* DaoArray_ToFloat64( DaoArray *self )
 {
-	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(double) ){
+	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(double) && self->stype == 0 ){
 		return (double*) self->data.f;
 	}
 	return DaoArray_ToFloat64X( self );
 }
 void DaoArray_FromFloat64( DaoArray *self )
 {
-	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(double) ) return;
+	if( self->etype == DAO_FLOAT && sizeof(dao_float) == sizeof(double) && self->stype == 0 ) return;
 	DaoArray_FromFloat64X( self );
 }
 
@@ -977,6 +1180,10 @@ int DaoArray_CopyArray( DaoArray *self, DaoArray *other )
 	daoint i, N = self->size;
 	assert( self->slices == NULL && other->slices == NULL );
 	if( DaoArray_MatchShape( self, other ) == 0 ) return 0;
+	if( self->stype || other->stype ){
+		for(i=0;i<N;i++) DaoArray_MoveItem( self, i, other, i );
+		return 1;
+	}
 	switch( self->etype | (other->etype << 4) ){
 	case DAO_BOOLEAN | (DAO_BOOLEAN<<4) :
 		for(i=0;i<N;i++) self->data.b[i] = other->data.b[i]; break;
@@ -1027,7 +1234,13 @@ int DaoArray_Compare( DaoArray *x, DaoArray *y )
 	daoint min = x->size < y->size ? x->size : y->size;
 	daoint res = x->size == y->size ? 1 : 100;
 	daoint i = 0;
-	if( x->etype == DAO_BOOLEAN && y->etype == DAO_BOOLEAN ){
+	if( x->stype || y->stype ){
+		if( x->etype == DAO_COMPLEX || y->etype == DAO_COMPLEX ){
+			return (daoint) x < (daoint) y ? -100 : 100;
+		}
+		while( i < min && DaoArray_GetFloat( x, i ) == DaoArray_GetFloat( y, i ) ) i++;
+		if( i < min ) return DaoArray_GetFloat( x, i ) < DaoArray_GetFloat( y, i ) ? -res : res;
+	}else if( x->etype == DAO_BOOLEAN && y->etype == DAO_BOOLEAN ){
 		while( i < min && *xb == *yb ) i++, xb++, yb++;
 		if( i < min ) return *xb < *yb ? -res : res;
 	}else if( x->etype == DAO_INTEGER && y->etype == DAO_INTEGER ){
@@ -1077,7 +1290,16 @@ int DaoArray_FullCompare( DaoArray *x, DaoArray *y )
 
 	if( x->size != y->size ) return x->size < y->size ? -100 : 100;
 
-	if( x->etype == DAO_BOOLEAN && y->etype == DAO_BOOLEAN ){
+	if( (x->stype || y->stype) && x->etype != DAO_COMPLEX && y->etype != DAO_COMPLEX ){
+		for(i=0; i<size; ++i){
+			dao_float e1 = DaoArray_GetFloat( x, i );
+			dao_float e2 = DaoArray_GetFloat( y, i );
+			eq |= e1 == e2;
+			lt |= e1 < e2;
+			gt |= e1 > e2;
+			if( lt & gt ) break;
+		}
+	}else if( x->etype == DAO_BOOLEAN && y->etype == DAO_BOOLEAN ){
 		for(i=0; i<size; ++i, ++xb, ++yb){
 			dao_boolean e1 = *xb;
 			dao_boolean e2 = *yb;
@@ -1140,6 +1362,59 @@ static daoint DaoArray_UpdateShape( DaoArray *C, DaoArray *A )
 	return N;
 }
 
+/*
+// Element-wise operation for arrays in compact storages:
+// The operands are widened to the default element types for the computation,
+// and the result is narrowed to the storage type of the resulting array;
+*/
+static void DaoArray_ComputeItem( DaoArray *C, daoint c, DaoValue *A, DaoValue *B, int op )
+{
+	if( C->etype == DAO_COMPLEX ){
+		dao_complex ac = DaoValue_GetComplex( A );
+		dao_complex bc = DaoValue_GetComplex( B );
+		dao_complex cc = {0.0, 0.0};
+		switch( op ){
+		case DVM_MOVE : cc = bc; break;
+		case DVM_ADD : COM_ADD( cc, ac, bc ); break;
+		case DVM_SUB : COM_SUB( cc, ac, bc ); break;
+		case DVM_MUL : COM_MUL( cc, ac, bc ); break;
+		case DVM_DIV : COM_DIV( cc, ac, bc ); break;
+		default : break;
+		}
+		DaoArray_SetComplex( C, c, cc );
+	}else if( C->etype == DAO_INTEGER && A->type <= DAO_INTEGER && B->type <= DAO_INTEGER ){
+		dao_integer ai = DaoValue_GetInteger( A );
+		dao_integer bi = DaoValue_GetInteger( B );
+		dao_integer ci = 0;
+		switch( op ){
+		case DVM_MOVE : ci = bi; break;
+		case DVM_ADD : ci = ai + bi; break;
+		case DVM_SUB : ci = ai - bi; break;
+		case DVM_MUL : ci = ai * bi; break;
+		case DVM_DIV : ci = ai / bi; break;
+		case DVM_MOD : ci = ai % bi; break;
+		case DVM_POW : ci = dao_powi( ai, bi );break;
+		default : break;
+		}
+		DaoArray_SetInteger( C, c, ci );
+	}else{
+		dao_float af = DaoValue_GetFloat( A );
+		dao_float bf = DaoValue_GetFloat( B );
+		dao_float cf = 0.0;
+		switch( op ){
+		case DVM_MOVE : cf = bf; break;
+		case DVM_ADD : cf = af + bf; break;
+		case DVM_SUB : cf = af - bf; break;
+		case DVM_MUL : cf = af * bf; break;
+		case DVM_DIV : cf = af / bf; break;
+		case DVM_MOD : cf = af - bf*(dao_integer)(af / bf); break;
+		case DVM_POW : cf = pow( af, bf );break;
+		default : break;
+		}
+		DaoArray_SetFloat( C, c, cf );
+	}
+}
+
 int DaoArray_DoBinary_NumberArray( DaoArray *C, DaoValue *A, DaoArray *B, short op, DaoProcess *proc )
 {
 	daoint N = DaoArray_UpdateShape( C, B );
@@ -1167,6 +1442,10 @@ int DaoArray_DoBinary_NumberArray( DaoArray *C, DaoValue *A, DaoArray *B, short
 		int zerob = 0;
 		for(i=0; i<N; ++i){
 			b = start_b + (i / len_b) * step_b + (i % len_b);
+			if( array_b->stype ){
+				zerob |= DaoArray_GetFloat( array_b, b ) == 0.0;
+				continue;
+			}
 			switch( array_b->etype ){
 			case DAO_BOOLEAN : zerob |= data_b->b[b] == 0; break;
 			case DAO_INTEGER : zerob |= data_b->i[b] == 0; break;
@@ -1176,6 +1455,16 @@ int DaoArray_DoBinary_NumberArray( DaoArray *C, DaoValue *A, DaoArray *B, short
 		}
 		if( zerob ) goto ErrorDivByZero;
 	}
+	if( array_b->stype || array_c->stype ){
+		DaoValue item = {DAO_COMPLEX};
+		for(i=0; i<N; ++i){
+			b = start_b + (i / len_b) * step_b + (i % len_b);
+			c = start_c + (i / len_c) * step_c + (i % len_c);
+			DaoArray_GetValue( array_b, b, & item );
+			DaoArray_ComputeItem( array_c, c, A, & item, op );
+		}
+		return 1;
+	}
 	if( array_b->etype == DAO_INTEGER && A->type == DAO_INTEGER ){
 		daoint bi, ci = 0, ai = A->xInteger.value;
 		for(i=0; i<N; ++i){
@@ -1280,6 +1569,16 @@ int DaoArray_DoBinary_ArrayNumber( DaoArray *C, DaoArray *A, DaoValue *B, int op
 			return 0;
 		}
 	}
+	if( array_a->stype || array_c->stype ){
+		DaoValue item = {DAO_COMPLEX};
+		for(i=0; i<N; ++i){
+			a = start_a + (i / len_a) * step_a + (i % len_a);
+			c = start_c + (i / len_c) * step_c + (i % len_c);
+			DaoArray_GetValue( array_a, a, & item );
+			DaoArray_ComputeItem( array_c, c, & item, B, op );
+		}
+		return 1;
+	}
 	if( array_a->etype == DAO_INTEGER && B->type == DAO_INTEGER ){
 		for(i=0; i<N; ++i){
 			a = start_a + (i / len_a) * step_a + (i % len_a);
@@ -1397,6 +1696,10 @@ int DaoArray_DoBinary_ArrayArray( DaoArray *C, DaoArray *A, DaoArray *B, int op,
 		int zerob = 0;
 		for(i=0; i<N; ++i){
 			b = start_b + (i / len_b) * step_b + (i % len_b);
+			if( array_b->stype ){
+				zerob |= DaoArray_GetFloat( array_b, b ) == 0.0;
+				continue;
+			}
 			switch( array_b->etype ){
 			case DAO_BOOLEAN : zerob |= data_b->b[b] == 0; break;
 			case DAO_INTEGER : zerob |= data_b->i[b] == 0; break;
@@ -1415,6 +1718,19 @@ int DaoArray_DoBinary_ArrayArray( DaoArray *C, DaoArray *A, DaoArray *B, int op,
 	start_c = DaoArray_GetWorkStart( C );
 	len_c = DaoArray_GetWorkIntervalSize( C );
 	step_c = DaoArray_GetWorkStep( C );
+	if( array_a->stype || array_b->stype || array_c->stype ){
+		DaoValue item1 = {DAO_COMPLEX};
+		DaoValue item2 = {DAO_COMPLEX};
+		for(i=0; i<N; ++i){
+			a = start_a + (i / len_a) * step_a + (i % len_a);
+			b = start_b + (i / len_b) * step_b + (i % len_b);
+			c = start_c + (i / len_c) * step_c + (i % len_c);
+			DaoArray_GetValue( array_a, a, & item1 );
+			DaoArray_GetValue( array_b, b, & item2 );
+			DaoArray_ComputeItem( array_c, c, & item1, & item2, op );
+		}
+		return 1;
+	}
 	if( C->etype == A->etype && A->etype == B->etype ){
 		for(i=0; i<N; ++i){
 			a = start_a + (i / len_a) * step_a + (i % len_a);
@@ -1593,6 +1909,11 @@ static DaoValue* DaoArray_DoGetItem( DaoValue *selfv, DaoValue *index[], int N,
 			pos = DaoValue_GetInteger( index[0] );
 			pos = Dao_CheckNumberIndex( pos, size, proc );
 			if( pos < 0 ) return NULL;
+			if( self->stype ){
+				DaoValue item = {DAO_COMPLEX};
+				DaoProcess_PutValue( proc, DaoArray_GetValue( self, pos, & item ) );
+				break;
+			}
 			switch( self->etype ){
 			case DAO_BOOLEAN : DaoProcess_PutBoolean( proc, self->data.b[pos] ); break;
 			case DAO_INTEGER : DaoProcess_PutInteger( proc, self->data.i[pos] ); break;
@@ -1609,6 +1930,11 @@ static DaoValue* DaoArray_DoGetItem( DaoValue *selfv, DaoValue *index[], int N,
 				tuple->values[0]->xBoolean.value = (pos + 1) < size;
 				tuple->values[1]->xInteger.value = pos + 1;
 				if( pos < 0 ) return NULL;
+				if( self->stype ){
+					DaoValue item = {DAO_COMPLEX};
+					DaoProcess_PutValue( proc, DaoArray_GetValue( self, pos, & item ) );
+					break;
+				}
 				switch( self->etype ){
 				case DAO_BOOLEAN : DaoProcess_PutBoolean( proc, self->data.b[pos] ); break;
 				case DAO_INTEGER : DaoProcess_PutInteger( proc, self->data.i[pos] ); break;
@@ -1646,7 +1972,11 @@ static DaoValue* DaoArray_DoGetItem( DaoValue *selfv, DaoValue *index[], int N,
 			DaoProcess_RaiseError( proc, "Index::Range", "index out of range" );
 			return NULL;
 		}
-		if( allNumbers ){
+		if( allNumbers && self->stype ){
+			DaoValue item = {DAO_COMPLEX};
+			DaoProcess_PutValue( proc, DaoArray_GetValue( self, vecpos, & item ) );
+			return NULL;
+		}else if( allNumbers ){
 			switch( self->etype ){
 			case DAO_BOOLEAN : DaoProcess_PutBoolean( proc, self->data.b[vecpos] ); break;
 			case DAO_INTEGER : DaoProcess_PutInteger( proc, self->data.i[vecpos] ); break;
@@ -1788,7 +2118,20 @@ static DaoValue* DaoArray_DoUnary( DaoValue *self, DaoVmCode *op, DaoProcess *pr
 	DaoArray_SetNumType( res, array->etype );
 	DaoArray_ResizeArray( res, array->dims, array->ndim );
 
-	if( array->etype == DAO_BOOLEAN ){
+	if( array->stype && array->etype == DAO_INTEGER ){
+		dao_integer *vc = res->data.i;
+		switch( op->code ){
+		case DVM_NOT   : for(i=0,n=array->size; i<n; ++i) vc[i] = ! DaoArray_GetInteger( array, i ); break;
+		case DVM_MINUS : for(i=0,n=array->size; i<n; ++i) vc[i] = - DaoArray_GetInteger( array, i ); break;
+		case DVM_TILDE : for(i=0,n=array->size; i<n; ++i) vc[i] = ~ DaoArray_GetInteger( array, i ); break;
+		}
+	}else if( array->stype ){
+		dao_float *vc = res->data.f;
+		switch( op->code ){
+		case DVM_NOT   : for(i=0,n=array->size; i<n; ++i) vc[i] = ! DaoArray_GetFloat( array, i ); break;
+		case DVM_MINUS : for(i=0,n=array->size; i<n; ++i) vc[i] = - DaoArray_GetFloat( array, i ); break;
+		}
+	}else if( array->etype == DAO_BOOLEAN ){
 		dao_boolean *va = array->data.b;
 		dao_boolean *vc = res->data.b;
 		switch( op->code ){
@@ -2054,6 +2397,14 @@ int DaoArray_DoForEach( DaoValue *self, DaoTuple *iterator, DaoProcess *p )
 
 static void DaoArray_PrintElement( DaoArray *self, DaoStream *stream, daoint i )
 {
+	if( self->stype ){
+		if( self->etype == DAO_INTEGER ){
+			DaoStream_WriteInt( stream, DaoArray_GetInteger( self, i ) );
+		}else{
+			DaoStream_WriteFloat( stream, DaoArray_GetFloat( self, i ) );
+		}
+		return;
+	}
 	switch( self->etype ){
 	case DAO_BOOLEAN :
 		DaoStream_WriteInt( stream, self->data.b[i] );
@@ -2338,7 +2689,7 @@ static void DaoARRAY_Reshape( DaoProcess *proc, DaoValue *par[], int N )
 		dims[i] = par[i+1]->xInteger.value;
 		size *= dims[i];
 	}
-	if( self->owner && self->size != size ){
+	if( (self->owner || self->mapping) && self->size != size ){
 		DArray_Delete( ad );
 		DaoProcess_RaiseError( proc, "Param", "invalid dimension" );
 		return;
@@ -2349,6 +2700,23 @@ static void DaoARRAY_Reshape( DaoProcess *proc, DaoValue *par[], int N )
 	DaoProcess_PutValue( proc, (DaoValue*)self );
 	DArray_Delete( ad );
 }
+static const char* const daoArrayStorageNames[] =
+{
+	"default", "int8", "int16", "int32", "float32"
+};
+static void DaoARRAY_Storage( DaoProcess *proc, DaoValue *par[], int N )
+{
+	DaoArray *self = DaoArray_GetWorkArray( (DaoArray*) par[0] );
+	DaoProcess_PutEnum( proc, daoArrayStorageNames[ self->stype ] );
+}
+static void DaoARRAY_SetStorage( DaoProcess *proc, DaoValue *par[], int N )
+{
+	DaoArray *self = & par[0]->xArray;
+	DaoProcess_PutValue( proc, (DaoValue*)self );
+	if( DaoArray_SetStorage( self, par[1]->xEnum.value ) == 0 ){
+		DaoProcess_RaiseError( proc, "Param", "storage type not supported by the element type" );
+	}
+}
 static void DaoARRAY_Index( DaoProcess *proc, DaoValue *par[], int N )
 {
 	DaoTuple *tup;
@@ -2384,7 +2752,12 @@ static void DaoARRAY_max( DaoProcess *proc, DaoValue *par[], int N )
 
 	tuple = DaoProcess_PutTuple( proc, 2 );
 	if( size ) imax = start;
-	for(i=1; i<size; ++i){
+	for(i=1; i<size && array->stype; ++i){
+		j = start + (i / len) * step + (i % len);
+		cmp = DaoArray_GetFloat( array, imax ) < DaoArray_GetFloat( array, j );
+		if( cmp ) imax = j;
+	}
+	for(i=1; i<size && array->stype == 0; ++i){
 		j = start + (i / len) * step + (i % len);
 		switch( array->etype ){
 		case DAO_BOOLEAN : cmp = array->data.b[imax] < array->data.b[j]; break;
@@ -2398,8 +2771,8 @@ static void DaoARRAY_max( DaoProcess *proc, DaoValue *par[], int N )
 	if( imax < 0 ) return;
 	switch( array->etype ){
 	case DAO_BOOLEAN : tuple->values[0]->xInteger.value = array->data.b[imax]; break;
-	case DAO_INTEGER : tuple->values[0]->xInteger.value = array->data.i[imax]; break;
-	case DAO_FLOAT   : tuple->values[0]->xFloat.value = array->data.f[imax]; break;
+	case DAO_INTEGER : tuple->values[0]->xInteger.value = DaoArray_GetInteger( array, imax ); break;
+	case DAO_FLOAT   : tuple->values[0]->xFloat.value = DaoArray_GetFloat( array, imax ); break;
 	default : break;
 	}
 }
@@ -2420,7 +2793,12 @@ static void DaoARRAY_min( DaoProcess *proc, DaoValue *par[], int N )
 
 	tuple = DaoProcess_PutTuple( proc, 2 );
 	if( size ) imin = start;
-	for(i=1; i<size; ++i){
+	for(i=1; i<size && array->stype; ++i){
+		j = start + (i / len) * step + (i % len);
+		cmp = DaoArray_GetFloat( array, imin ) > DaoArray_GetFloat( array, j );
+		if( cmp ) imin = j;
+	}
+	for(i=1; i<size && array->stype == 0; ++i){
 		j = start + (i / len) * step + (i % len);
 		switch( array->etype ){
 		case DAO_BOOLEAN : cmp = array->data.b[imin] > array->data.b[j]; break;
@@ -2434,8 +2812,8 @@ static void DaoARRAY_min( DaoProcess *proc, DaoValue *par[], int N )
 	if( imin < 0 ) return;
 	switch( array->etype ){
 	case DAO_BOOLEAN : tuple->values[0]->xBoolean.value = array->data.b[imin]; break;
-	case DAO_INTEGER : tuple->values[0]->xInteger.value = array->data.i[imin]; break;
-	case DAO_FLOAT   : tuple->values[0]->xFloat.value = array->data.f[imin]; break;
+	case DAO_INTEGER : tuple->values[0]->xInteger.value = DaoArray_GetInteger( array, imin ); break;
+	case DAO_FLOAT   : tuple->values[0]->xFloat.value = DaoArray_GetFloat( array, imin ); break;
 	default : break;
 	}
 }
@@ -2452,7 +2830,15 @@ static void DaoARRAY_sum( DaoProcess *proc, DaoValue *par[], int N )
 	dao_float fsum = 0;
 	daoint i, j;
 
-	for(i=0; i<size; ++i){
+	for(i=0; i<size && array->stype; ++i){
+		j = start + (i / len) * step + (i % len);
+		if( array->etype == DAO_INTEGER ){
+			isum += DaoArray_GetInteger( array, j );
+		}else{
+			fsum += DaoArray_GetFloat( array, j );
+		}
+	}
+	for(i=0; i<size && array->stype == 0; ++i){
 		j = start + (i / len) * step + (i % len);
 		switch( array->etype ){
 		case DAO_BOOLEAN : isum += array->data.b[j]; break;
@@ -2475,6 +2861,11 @@ static int Compare( DaoArray *array, daoint *slice, daoint i, daoint j )
 {
 	i = slice[i];
 	j = slice[j];
+	if( array->stype ){
+		dao_float a = DaoArray_GetFloat( array, i );
+		dao_float b = DaoArray_GetFloat( array, j );
+		return a == b ? 0 : (a < b ? -1 : 1);
+	}
 	switch( array->etype ){
 	case DAO_BOOLEAN :
 		{
@@ -2502,6 +2893,12 @@ static void Swap( DaoArray *array, daoint *slice, daoint i, daoint j )
 {
 	i = slice[i];
 	j = slice[j];
+	if( array->stype ){
+		dao_float a = DaoArray_GetFloat( array, i );
+		DaoArray_SetFloat( array, i, DaoArray_GetFloat( array, j ) );
+		DaoArray_SetFloat( array, j, a );
+		return;
+	}
 	switch( array->etype ){
 	case DAO_BOOLEAN :
 		{
@@ -2776,6 +3173,22 @@ static DaoFunctionEntry daoArrayMeths[] =
 		// Reshape the array. The size in each dimension is specified in the parameters.
 		*/
 	},
+	{ DaoARRAY_Storage,
+		"storage( invar self: array<@T> ) => enum<default,int8,int16,int32,float32>"
+		/*
+		// Get the storage type of the elements.
+		*/
+	},
+	{ DaoARRAY_SetStorage,
+		"storage( self: array<@T<int|float>>, type: enum<default,int8,int16,int32,float32> )"
+			"=> array<@T>"
+		/*
+		// Convert the elements to a compact storage type to save memory:
+		// "int8", "int16" and "int32" for integer arrays, and "float32"
+		// for float arrays. The element type of the array is not changed,
+		// values that cannot be represented by the storage type are truncated.
+		*/
+	},
 
 	{ DaoARRAY_Permute,
 		"permute( self: array<@T>, index: int, ...: int ) => array<@T>"
@@ -93,6 +93,24 @@ union DaoArrayData
 	dao_integer  *i;
 	dao_float    *f;
 	dao_complex  *c;
+	signed char  *i8;
+	short        *i16;
+	int          *i32;
+	float        *f32;
+};
+
+/*
+// Compact storage for integer and float arrays:
+// The element type (DaoArray::etype) is not affected by the storage,
+// the elements are narrowed when stored and widened when retrieved;
+*/
+enum DaoArrayStorage
+{
+	DAO_ARRAY_DEFAULT ,  /* dao_boolean, dao_integer, dao_float or dao_complex; */
+	DAO_ARRAY_SINT8   ,  /* signed char, integer arrays only; */
+	DAO_ARRAY_SINT16  ,  /* short, integer arrays only; */
+	DAO_ARRAY_SINT32  ,  /* int, integer arrays only; */
+	DAO_ARRAY_FLOAT32    /* float, float arrays only; */
 };
 
 
@@ -103,6 +121,7 @@ struct DaoArray
 
 	uchar_t  etype; /* element type; */
 	uchar_t  owner; /* own the data; */
+	uchar_t  stype; /* storage type: DAO_ARRAY_DEFAULT, DAO_ARRAY_SINT8 etc.; */
 	short    ndim;  /* number of dimensions; */
 	daoint   size;  /* total number of elements; */
 	daoint  *dims;  /* 2*ndim values; the first ndim values: size for each dimension; */
@@ -110,6 +129,8 @@ struct DaoArray
 
 	DaoArrayData data;
 
+	DMappedFile *mapping; /* memory mapped file that backs the data; */
+
 	DaoArray *original; /* original array for an array slicing; */
 	DArray   *slices;
 	/*
@@ -144,12 +165,16 @@ DAO_DLL void DaoArray_ResizeArray( DaoArray *self, daoint *dims, int D );
 
 DAO_DLL int DaoArray_Sliced( DaoArray *self );
 DAO_DLL void DaoArray_UseData( DaoArray *self, void *data );
+DAO_DLL void DaoArray_UseMappedData( DaoArray *self, DMappedFile *mapping, daoint offset );
 
 DAO_DLL dao_boolean DaoArray_GetBoolean( DaoArray *self, daoint i );
 DAO_DLL dao_integer DaoArray_GetInteger( DaoArray *na, daoint i );
 DAO_DLL dao_float   DaoArray_GetFloat( DaoArray *na, daoint i );
 DAO_DLL dao_complex DaoArray_GetComplex( DaoArray *na, daoint i );
 DAO_DLL DaoValue* DaoArray_GetValue( DaoArray *self, daoint i, DaoValue *res );
+DAO_DLL void DaoArray_SetValue( DaoArray *self, daoint i, DaoValue *value );
+
+DAO_DLL int DaoArray_SetStorage( DaoArray *self, int stype );
 
 DAO_DLL DaoArray* DaoArray_GetWorkArray( DaoArray *self );
 DAO_DLL daoint DaoArray_GetWorkSize( DaoArray *self );
@@ -40,18 +40,116 @@
 #include"daoValue.h"
 
 
+/*
+// Instance variables of primitive types are stored inline after the value
+// pointers, so that no separate allocation is needed for them. They are
+// accessed through the value pointers like the boxed values, but they are
+// owned by the object and are never freed by the GC (DAO_VALUE_INLINE).
+*/
+static int DaoObject_InlineSize( DaoType *type )
+{
+	if( type == NULL || type->valtype ) return 0;
+	switch( type->tid ){
+	case DAO_BOOLEAN : return (sizeof(DaoBoolean) + 7) & ~7;
+	case DAO_INTEGER : return (sizeof(DaoInteger) + 7) & ~7;
+	case DAO_FLOAT   : return (sizeof(DaoFloat) + 7) & ~7;
+	case DAO_COMPLEX : return (sizeof(DaoComplex) + 7) & ~7;
+	default : break;
+	}
+	return 0;
+}
+
+/*
+// Store the default value of an inline instance variable, return zero if
+// the value cannot be stored inline:
+*/
+static int DaoObject_SetInlineDefault( DaoValue *value, DaoValue *deft )
+{
+	if( deft == NULL ) return 1;
+	if( deft->type < DAO_BOOLEAN || deft->type > DAO_COMPLEX ) return 0;
+	switch( value->type ){
+	case DAO_BOOLEAN : value->xBoolean.value = DaoValue_GetInteger( deft ) != 0; break;
+	case DAO_INTEGER : value->xInteger.value = DaoValue_GetInteger( deft ); break;
+	case DAO_FLOAT   : value->xFloat.value = DaoValue_GetFloat( deft ); break;
+	case DAO_COMPLEX : value->xComplex.value = DaoValue_GetComplex( deft ); break;
+	}
+	return 1;
+}
+
+DaoObjectProto* DaoObjectProto_New( DaoClass *klass )
+{
+	DaoObjectProto *self = (DaoObjectProto*) dao_calloc( 1, sizeof(DaoObjectProto) );
+	DaoVariable **vars = klass->instvars->items.pVar;
+	int i, count = klass->instvars->size;
+
+	self->inlines = DArray_New( sizeof(uint_t) );
+	self->boxed = DArray_New( sizeof(ushort_t) );
+	self->data = DArray_New( sizeof(char) );
+
+	for(i=1; i<count; ++i){
+		DaoVariable *var = vars[i];
+		DaoValue *deft = var->value;
+		DaoValue *value;
+		int size = DaoObject_InlineSize( var->dtype );
+
+		if( deft == NULL && var->dtype != NULL ) deft = var->dtype->value;
+		if( size ){
+			daoint offset = self->data->size;
+			DArray_Resize( self->data, offset + size );
+			value = (DaoValue*) (self->data->data.chars + offset);
+			memset( value, 0, size );
+			value->xBase.type = value->xBase.subtype = var->dtype->tid;
+			value->xBase.trait = DAO_VALUE_INLINE;
+			value->xBase.refCount = 1;
+			if( DaoObject_SetInlineDefault( value, deft ) ){
+				*(uint_t*) DArray_Push( self->inlines ) = i;
+				*(uint_t*) DArray_Push( self->inlines ) = offset;
+				continue;
+			}
+			DArray_Resize( self->data, offset );
+		}
+		if( deft != NULL ) DArray_PushUshort( self->boxed, i );
+	}
+	self->size = sizeof(DaoObject) + count*sizeof(DaoValue*) + self->data->size;
+	return self;
+}
+void DaoObjectProto_Delete( DaoObjectProto *self )
+{
+	DArray_Delete( self->inlines );
+	DArray_Delete( self->boxed );
+	DArray_Delete( self->data );
+	dao_free( self );
+}
+
 DaoObject* DaoObject_Allocate( DaoClass *klass, int value_count )
 {
-	int extra = value_count * sizeof(DaoValue*);
-	DaoObject *self = (DaoObject*) dao_calloc( 1, sizeof(DaoObject) + extra );
+	DaoObjectProto *proto = NULL;
+	int i, size = sizeof(DaoObject) + value_count * sizeof(DaoValue*);
+	DaoObject *self;
+
+	if( value_count && value_count == klass->instvars->size ) proto = klass->objProto;
+	if( proto == NULL ){
+		self = (DaoObject*) dao_calloc( 1, size );
+	}else{
+		uint_t *inlines = proto->inlines->data.uints;
+		char *data;
+
+		self = (DaoObject*) dao_malloc( proto->size );
+		memset( self, 0, size );
+		data = ((char*) self) + size;
+		memcpy( data, proto->data->data.chars, proto->data->size );
+		for(i=0; i<proto->inlines->size; i+=2){
+			((DaoValue**) (self + 1))[inlines[i]] = (DaoValue*) (data + inlines[i+1]);
+		}
+	}
 
 	DaoValue_Init( self, DAO_OBJECT );
 	GC_IncRC( klass );
 	self->defClass = klass;
 	self->isRoot = 1;
+	self->hasProto = proto != NULL;
 	self->valueCount = value_count;
 	self->objValues = (DaoValue**) (self + 1);
-	memset( self->objValues, 0, value_count*sizeof(DaoValue*) );
 #ifdef DAO_USE_GC_LOGGER
 	DaoObjectLogger_LogNew( (DaoValue*) self );
 #endif
@@ -67,9 +165,23 @@ DaoObject* DaoObject_New( DaoClass *klass )
 	return self;
 }
 
+static void DaoObject_InitValue( DaoObject *self, int i )
+{
+	DaoVariable *var = self->defClass->instvars->items.pVar[i];
+	DaoValue **value = self->objValues + i;
+	/* for data type such as list/map/array,
+	 * its .ctype may need to be set properaly */
+	if( var->value ){
+		DaoValue_Move( var->value, value, var->dtype );
+	}else if( *value == NULL && var->dtype && var->dtype->value ){
+		DaoValue_Copy( var->dtype->value, value );
+	}
+}
+
 void DaoObject_Init( DaoObject *self, DaoObject *that, int offset )
 {
 	DaoClass *klass = self->defClass;
+	DaoObjectProto *proto = klass->objProto;
 	daoint i;
 
 	self->isAsync = (klass->attribs & DAO_CLS_ASYNCHRONOUS) != 0;
@@ -97,17 +209,13 @@ void DaoObject_Init( DaoObject *self, DaoObject *that, int offset )
 	}
 	GC_Assign( & self->objValues[0], self );
 	if( self->isRoot == 0 ) return;
-	for(i=1; i<klass->instvars->size; i++){
-		DaoVariable *var = klass->instvars->items.pVar[i];
-		DaoValue **value = self->objValues + i;
-		/* for data type such as list/map/array,
-		 * its .ctype may need to be set properaly */
-		if( var->value ){
-			DaoValue_Move( var->value, value, var->dtype );
-		}else if( *value == NULL && var->dtype && var->dtype->value ){
-			DaoValue_Copy( var->dtype->value, value );
-		}
+	if( self->hasProto && self->objValues == (DaoValue**) (self + 1) ){
+		/* Inline values were initialized from the prototype by DaoObject_Allocate(): */
+		ushort_t *boxed = proto->boxed->data.ushorts;
+		for(i=0; i<proto->boxed->size; i++) DaoObject_InitValue( self, boxed[i] );
+		return;
 	}
+	for(i=1; i<klass->instvars->size; i++) DaoObject_InitValue( self, i );
 }
 
 void DaoObject_Delete( DaoObject *self )
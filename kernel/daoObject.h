@@ -39,7 +39,8 @@ struct DaoObject
 	ushort_t    isNull    : 1;
 	ushort_t    isAsync   : 1;
 	ushort_t    isInited  : 1;
-	ushort_t    unused    : 12;
+	ushort_t    hasProto  : 1;
+	ushort_t    unused    : 11;
 	ushort_t    valueCount;
 
 	DaoClass   *defClass;   /* definition class; */
@@ -48,6 +49,28 @@ struct DaoObject
 	DaoValue  **objValues;  /* instance variable values; */
 };
 
+/*
+// Construction prototype of class instances:
+// It is computed once for each class when the class definition is finalized,
+// before the class can be used from other threads; instances created while
+// the class is being compiled are initialized without it. Instances
+// are created with one allocation that also holds the inline primitive values
+// (see DaoObject_Allocate()), and one copy of the prototype data block that
+// holds these values initialized to their defaults. Only the remaining
+// instance variables with default values are initialized individually.
+*/
+struct DaoObjectProto
+{
+	uint_t   size;     /* allocation size of the root object; */
+	DArray  *inlines;  /* pairs of the index and data offset of the inline values; */
+	DArray  *boxed;    /* indices of the other instance variables with default values; */
+	DArray  *data;     /* inline values holding the default values; */
+};
+
+DAO_DLL DaoObjectProto* DaoObjectProto_New( DaoClass *klass );
+DAO_DLL void DaoObjectProto_Delete( DaoObjectProto *self );
+
+
 DAO_DLL DaoObject* DaoObject_Allocate( DaoClass *klass, int value_count );
 DAO_DLL DaoObject* DaoObject_New( DaoClass *klass );
 DAO_DLL void DaoObject_Init( DaoObject *self, DaoObject *that, int offset );
@@ -59,6 +82,7 @@ DAO_DLL DaoValue* DaoObject_CastToBase( DaoObject *self, DaoType *host );
 DAO_DLL void DaoObject_SetParentCstruct( DaoObject *self, DaoCstruct *parent );
 
 DAO_DLL int DaoObject_SetData( DaoObject *self, DString *name, DaoValue *value, DaoObject *objThis );
+/* "data" is borrowed (it may be stored inline in the object); */
 DAO_DLL int DaoObject_GetData( DaoObject *self, DString *name, DaoValue **data, DaoObject *objThis );
 
 #endif
@@ -371,7 +371,7 @@ static DString* DaoParser_GetString( DaoParser *self )
 	if( self->usedString >= self->strings->size )
 		DList_Append( self->strings, self->strings->items.pString[0] );
 	self->usedString += 1;
-	self->strings->items.pString[ self->usedString - 1 ]->size = 0;
+	DString_Reset( self->strings->items.pString[ self->usedString - 1 ], 0 );
 	return self->strings->items.pString[ self->usedString - 1 ];
 }
 static DList* DaoParser_GetArray( DaoParser *self )
@@ -3348,6 +3348,7 @@ static int DaoParser_ParseClassDefinition( DaoParser *self, int start, int to, i
 	DaoVmSpace_ReleaseParser( self->vmSpace, parser );
 	DaoClass_UpdateMixinConstructors( klass );
 	DaoClass_UpdateVirtualMethods( klass );
+	DaoClass_UpdateObjectProto( klass );
 	if( error ) return -1;
 
 	return right + 1;
@@ -5842,7 +5843,9 @@ static int DaoParser_AddFieldConst( DaoParser *self, DString *field )
 	DString_Append( self->string, field );
 	if( MAP_Find( self->allConsts, self->string )==NULL ){
 		DaoString str = {DAO_STRING,0,0,0,0,NULL};
-		str.value = field;
+		DString_Assign( self->str, field );
+		DaoVmSpace_InternString( self->vmSpace, self->str );
+		str.value = self->str;
 		MAP_Insert( self->allConsts, self->string, self->routine->routConsts->value->size );
 		DaoRoutine_AddConstant( self->routine, (DaoValue*) & str );
 	}
@@ -5973,6 +5976,9 @@ static int DaoParser_ParseAtomicExpression( DaoParser *self, int start, int *cst
 			}else{
 				DString_SetBytes( self->str, tok + 1, str->size-2 );
 			}
+			if( self->str->size <= DAO_STRING_INTERN ){
+				DaoVmSpace_InternString( self->vmSpace, self->str );
+			}
 			node = MAP_Insert( self->allConsts, str, routine->routConsts->value->size );
 			DaoRoutine_AddConstant( routine, (DaoValue*) & dummy );
 		}
@@ -6188,8 +6194,7 @@ int DaoParser_GetOperPrecedence( DaoParser *self )
 			}
 			if( newtok ){
 				DString_Insert( & t2->string, & t1->string, 0, 0, 1 );
-				t1->string.chars[0] = '\0';
-				t1->string.size = 0;
+				DString_Reset( & t1->string, 0 );
 				t1->type = t1->name = DTOK_SPACE;
 				t2->type = t2->name = newtok;
 				t2->cpos = t1->cpos;
@@ -6198,8 +6203,7 @@ int DaoParser_GetOperPrecedence( DaoParser *self )
 		}else if( t1->name == DKEY_NOT && t2->name == DKEY_IN ){
 			DString_AppendChar( & t1->string, ' ' );
 			DString_Insert( & t2->string, & t1->string, 0, 0, 4 );
-			t1->string.chars[0] = '\0';
-			t1->string.size = 0;
+			DString_Reset( & t1->string, 0 );
 			t1->type = t1->name = DTOK_SPACE;
 			t2->type = t2->name = DTOK_NOTIN;
 			t2->cpos = t1->cpos;
@@ -187,6 +187,95 @@ int Dao_IsDir( const char *file )
 
 
 
+#if defined(UNIX)
+
+#include<fcntl.h>
+#include<sys/mman.h>
+
+DMappedFile* Dao_MapFile( const char *file, int shared )
+{
+	DMappedFile *self = NULL;
+	struct stat st;
+	void *data;
+	int fd = open( file, shared ? O_RDWR : O_RDONLY );
+
+	if( fd < 0 ) return NULL;
+	if( fstat( fd, & st ) != 0 || st.st_size == 0 ){
+		close( fd );
+		return NULL;
+	}
+	/* Private mappings are writable, with copy-on-write pages: */
+	data = mmap( NULL, st.st_size, PROT_READ | PROT_WRITE,
+			shared ? MAP_SHARED : MAP_PRIVATE, fd, 0 );
+	close( fd ); /* The mapping keeps a reference to the file; */
+	if( data == MAP_FAILED ) return NULL;
+
+	self = (DMappedFile*) dao_calloc( 1, sizeof(DMappedFile) );
+	self->data = data;
+	self->size = st.st_size;
+	return self;
+}
+void Dao_UnmapFile( DMappedFile *self )
+{
+	if( self == NULL ) return;
+	munmap( self->data, self->size );
+	dao_free( self );
+}
+
+#elif defined(WIN32)
+
+DMappedFile* Dao_MapFile( const char *file, int shared )
+{
+	DMappedFile *self = NULL;
+	DString file2 = DString_WrapChars( file );
+	DArray *file3 = DArray_New( sizeof(wchar_t) );
+	DWORD access = shared ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ;
+	DWORD protect = shared ? PAGE_READWRITE : PAGE_WRITECOPY;
+	DWORD view = shared ? FILE_MAP_WRITE : FILE_MAP_COPY;
+	HANDLE fh = INVALID_HANDLE_VALUE, mh = NULL;
+	LARGE_INTEGER size;
+	void *data = NULL;
+
+	if( DString_DecodeUTF8( & file2, file3 ) ){
+		fh = CreateFileW( file3->data.wchars, access, FILE_SHARE_READ | FILE_SHARE_WRITE,
+				NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	}
+	DArray_Delete( file3 );
+	if( fh == INVALID_HANDLE_VALUE ) return NULL;
+	if( GetFileSizeEx( fh, & size ) && size.QuadPart > 0 ){
+		mh = CreateFileMapping( fh, NULL, protect, 0, 0, NULL );
+	}
+	CloseHandle( fh );
+	if( mh == NULL ) return NULL;
+	data = MapViewOfFile( mh, view, 0, 0, 0 );
+	if( data == NULL ){
+		CloseHandle( mh );
+		return NULL;
+	}
+	self = (DMappedFile*) dao_calloc( 1, sizeof(DMappedFile) );
+	self->data = data;
+	self->size = (size_t) size.QuadPart;
+	self->aux = mh;
+	return self;
+}
+void Dao_UnmapFile( DMappedFile *self )
+{
+	if( self == NULL ) return;
+	UnmapViewOfFile( self->data );
+	CloseHandle( (HANDLE) self->aux );
+	dao_free( self );
+}
+
+#else
+
+DMappedFile* Dao_MapFile( const char *file, int shared ){ return NULL; }
+void Dao_UnmapFile( DMappedFile *self ){}
+
+#endif
+
+
+
+
 #ifndef DAO_WITHOUT_COLORPRINT
 
 FILE* DaoStream_GetFileHandle( DaoStream *self )
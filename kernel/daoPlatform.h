@@ -107,6 +107,24 @@ DAO_DLL size_t Dao_FileChangedTime( const char *file );
 
 DAO_DLL double Dao_GetCurrentTime();
 
+typedef struct DMappedFile DMappedFile;
+
+/*
+// Memory mapped file:
+// A shared mapping writes modifications back to the file;
+// A private mapping is copy-on-write, the pages remain shared
+// with the page cache until they are modified.
+*/
+struct DMappedFile
+{
+	void    *data;  /* starting address of the mapped region; */
+	size_t   size;  /* size of the mapped region in bytes; */
+	void    *aux;   /* platform specific handle; */
+};
+
+DAO_DLL DMappedFile* Dao_MapFile( const char *file, int shared );
+DAO_DLL void Dao_UnmapFile( DMappedFile *self );
+
 DAO_DLL void* Dao_OpenDLL( const char *name );
 DAO_DLL void* Dao_GetSymbolAddress( void *handle, const char *name );
 
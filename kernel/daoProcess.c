@@ -1112,12 +1112,50 @@ int DaoCallServer_MarkActiveProcess( DaoProcess *process, int active );
 #endif
 
 
+#ifdef DAO_WITH_VMSTATS
+
+static DaoVmStats dao_vmstats;
+
+DaoVmStats* DaoVmStats_Get()
+{
+	return & dao_vmstats;
+}
+void DaoVmStats_Reset()
+{
+	memset( & dao_vmstats, 0, sizeof(DaoVmStats) );
+}
+
+#if defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+static inline dao_integer DaoVmStats_Clock()
+{
+	unsigned int lo, hi;
+	__asm__ __volatile__ ( "rdtsc" : "=a" (lo), "=d" (hi) );
+	return ((dao_integer) hi << 32) | lo;
+}
+#else
+#define DaoVmStats_Clock()  0
+#endif
+
+#define DAO_VMSTATS_COUNT() { \
+	dao_integer vmnow = DaoVmStats_Clock(); \
+	vmstats->cycles[vmcode] += vmnow - vmclock; \
+	vmstats->counts[vmc->code] += 1; \
+	vmstats->pairs[vmcode][vmc->code] += 1; \
+	vmcode = vmc->code; \
+	vmclock = vmnow; \
+}
+
+#else
+#define DAO_VMSTATS_COUNT()
+#endif
+
+
 #ifndef WITHOUT_DIRECT_THREADING
 
-#define OPBEGIN() goto *labels[ vmc->code ];
+#define OPBEGIN() { DAO_VMSTATS_COUNT() goto *labels[ vmc->code ]; }
 #define OPCASE( name ) LAB_##name :
-#define OPNEXT() goto *labels[ (++vmc)->code ];
-#define OPJUMP() goto *labels[ vmc->code ];
+#define OPNEXT() { ++vmc; DAO_VMSTATS_COUNT() goto *labels[ vmc->code ]; }
+#define OPJUMP() { DAO_VMSTATS_COUNT() goto *labels[ vmc->code ]; }
 #define OPDEFAULT()
 #define OPEND()
 
@@ -1144,7 +1182,7 @@ int DaoCallServer_MarkActiveProcess( DaoProcess *process, int active );
 #define HANDLE_BREAK_POINT()
 #endif
 
-#define OPBEGIN() for(;;){ HANDLE_BREAK_POINT() switch( vmc->code )
+#define OPBEGIN() for(;;){ HANDLE_BREAK_POINT() DAO_VMSTATS_COUNT() switch( vmc->code )
 #define OPCASE( name ) case DVM_##name :
 #define OPNEXT() break;
 #define OPJUMP() continue;
@@ -1209,6 +1247,14 @@ int DaoProcess_Start( DaoProcess *self )
 	daoint i, j, id, size;
 	daoint inum=0;
 	float fnum=0;
+#ifdef DAO_WITH_THREAD
+	DaoProcess *thdProcess = NULL;
+#endif
+#ifdef DAO_WITH_VMSTATS
+	DaoVmStats *vmstats = & dao_vmstats;
+	dao_integer vmclock = DaoVmStats_Clock();
+	int vmcode = DVM_NULL;
+#endif
 
 #ifndef WITHOUT_DIRECT_THREADING
 	static void *labels[] = {
@@ -1346,6 +1392,8 @@ int DaoProcess_Start( DaoProcess *self )
 	self->thread = DThread_GetCurrent();
 	self->thread->vmpause = 0;
 	self->thread->vmstop = 0;
+	thdProcess = self->thread->process;
+	self->thread->process = self;
 #endif
 
 	self->startFrame = self->topFrame;
@@ -1484,6 +1532,9 @@ CallEntry:
 			DaoTuple_SetItem( tuple, future->message ? future->message : dao_none_value, 1 );
 			tuple->values[2]->xEnum.value = future->aux1 ? 2 : future->timeout != 0;
 			break;
+		case DAO_PAUSE_IO_WAIT :
+			DaoProcess_PutBoolean( self, future->timeout == 0 );
+			break;
 		default: break;
 		}
 		vmc ++;
@@ -2311,6 +2362,10 @@ CallEntry:
 			if( array->original && DaoArray_Sliced( array ) == 0 ) goto RaiseErrorSlicing;
 			if( id <0 ) id += array->size;
 			if( id <0 || id >= array->size ) goto RaiseErrorIndexOutOfRange;
+			if( array->stype ){
+				DaoArray_GetValue( array, id, locVars[vmc->c] );
+				OPNEXT()
+			}
 			switch( vmc->code ){
 			case DVM_GETI_ABI : LocalBool(vmc->c) = array->data.b[id]; break;
 			case DVM_GETI_AII : LocalInt(vmc->c) = array->data.i[id]; break;
@@ -2324,6 +2379,10 @@ CallEntry:
 			if( array->original && DaoArray_Sliced( array ) == 0 ) goto RaiseErrorSlicing;
 			if( id <0 ) id += array->size;
 			if( id <0 || id >= array->size ) goto RaiseErrorIndexOutOfRange;
+			if( array->stype ){
+				DaoArray_SetValue( array, id, locVars[vmc->a] );
+				OPNEXT()
+			}
 			switch( vmc->code ){
 			case DVM_SETI_ABIB : array->data.b[id] = locVars[vmc->a]->xBoolean.value; break;
 			case DVM_SETI_AIII : array->data.i[id] = locVars[vmc->a]->xInteger.value; break;
@@ -2336,6 +2395,10 @@ CallEntry:
 			if( array->original && DaoArray_Sliced( array ) == 0 ) goto RaiseErrorSlicing;
 			id = DaoArray_ComputeIndex( array, locVars + vmc->a + 1, vmc->b );
 			if( id < 0 ) goto RaiseErrorIndexOutOfRange;
+			if( array->stype ){
+				DaoArray_GetValue( array, id, locVars[vmc->c] );
+				OPNEXT()
+			}
 			switch( vmc->code ){
 			case DVM_GETMI_ABI: locVars[vmc->c]->xBoolean.value = array->data.b[id]; break;
 			case DVM_GETMI_AII: locVars[vmc->c]->xInteger.value = array->data.i[id]; break;
@@ -2348,6 +2411,10 @@ CallEntry:
 			if( array->original && DaoArray_Sliced( array ) == 0 ) goto RaiseErrorSlicing;
 			id = DaoArray_ComputeIndex( array, locVars + vmc->c + 1, vmc->b  );
 			if( id < 0 ) goto RaiseErrorIndexOutOfRange;
+			if( array->stype ){
+				DaoArray_SetValue( array, id, locVars[vmc->a] );
+				OPNEXT()
+			}
 			switch( vmc->code ){
 			case DVM_SETMI_ABIB: array->data.b[id] = locVars[vmc->a]->xBoolean.value; break;
 			case DVM_SETMI_AIII: array->data.i[id] = locVars[vmc->a]->xInteger.value; break;
@@ -2448,7 +2515,11 @@ CallEntry:
 			object = & locVars[vmc->a]->xObject;
 			if( object->isNull ) goto AccessNullInstance;
 			value = object->objValues[vmc->b];
-			GC_Assign( & locVars[vmc->c], value );
+			if( value && (value->xBase.trait & DAO_VALUE_INLINE) ){
+				DaoProcess_CopyMove( value, & locVars[vmc->c] );
+			}else{
+				GC_Assign( & locVars[vmc->c], value );
+			}
 		}OPNEXT() OPCASE( GETF_KCB ){
 			value = locVars[vmc->a]->xClass.constants->items.pConst[vmc->b]->value;
 			locVars[vmc->c]->xBoolean.value = value->xBoolean.value;
@@ -2821,6 +2892,9 @@ ReturnFalse:
 	DaoGC_TryInvoke( self );
 	self->startFrame = startFrame;
 	self->depth -= 1;
+#ifdef DAO_WITH_THREAD
+	self->thread->process = thdProcess;
+#endif
 	return 0;
 
 ReturnTrue:
@@ -2831,6 +2905,9 @@ ReturnTrue:
 	DaoGC_TryInvoke( self );
 	self->startFrame = startFrame;
 	self->depth -= 1;
+#ifdef DAO_WITH_THREAD
+	self->thread->process = thdProcess;
+#endif
 	return 1;
 }
 int DaoProcess_Execute( DaoProcess *self )
@@ -3273,7 +3350,7 @@ DaoArray* DaoProcess_GetArrayByType( DaoProcess *self, DaoVmCode *vmc, DaoType *
 		type = tp->args->items.pType[0]->tid;
 		if( type > DAO_COMPLEX ) type = DAO_NONE;
 	}
-	if( type && array && array->type == DAO_ARRAY && array->etype == type ){
+	if( type && array && array->type == DAO_ARRAY && array->etype == type && array->stype == 0 ){
 		if( array->refCount == 1 ) return array;
 		if( array->refCount == 2 && !(self->trait & DAO_VALUE_CONST) ){
 			DaoVmCode *vmc2 = vmc + 1;
@@ -3284,7 +3361,7 @@ DaoArray* DaoProcess_GetArrayByType( DaoProcess *self, DaoVmCode *vmc, DaoType *
 			}
 		}
 	}
-	if( dC && dC->type == DAO_ARRAY && dC->xArray.refCount == 1 ){
+	if( dC && dC->type == DAO_ARRAY && dC->xArray.refCount == 1 && dC->xArray.stype == 0 ){
 		GC_DecRC( dC->xArray.original );
 		dC->xArray.original = NULL;
 		DaoArray_SetNumType( (DaoArray*) dC, type );
@@ -5815,6 +5892,14 @@ void DaoProcess_FreeRegexCaches( DMap *regexCaches )
 	DMap_Delete( regexCaches );
 }
 
+/*
+// The compiled patterns are owned by the process, which keeps at most
+// DAO_REGEX_PROCESS_CACHE of them and evicts the least recently used one.
+// So a returned pattern stays valid until DAO_REGEX_PROCESS_CACHE - 1 other
+// patterns are made by the same process, in particular until the next call.
+// Callers that run scripts while holding a pattern must use a duplicate of it.
+// The patterns are copied from the VM space cache when available:
+*/
 DaoRegex* DaoProcess_MakeRegex( DaoProcess *self, DString *src )
 {
 	DMap *regexCaches = NULL;
@@ -5834,17 +5919,34 @@ DaoRegex* DaoProcess_MakeRegex( DaoProcess *self, DString *src )
 		DaoProcess_SetAuxData( self, DaoProcess_FreeRegexCaches, regexCaches );
 	}
 	node = DMap_Find( regexCaches, src );
-	if( node ) return (DaoRegex*) node->value.pVoid;
-
-	pat = DaoRegex_New( src );
-	for( i=0; i<pat->count; i++ ){
-		DaoRgxItem *it = pat->items + i;
-		if( it->type ==0 ){
-			sprintf( buf, "incorrect pattern, at char %i.", it->length );
-			if( self->activeRoutine ) DaoProcess_RaiseError( self, NULL, buf );
-			DaoRegex_Delete( pat );
-			return NULL;
+	if( node ){
+		pat = (DaoRegex*) node->value.pVoid;
+		/* Move to the end of the insertion order as the most recently used: */
+		if( node != regexCaches->last ){
+			DMap_EraseNode( regexCaches, node );
+			DMap_Insert( regexCaches, src, pat );
+		}
+		return pat;
+	}
+
+	pat = DaoVmSpace_FindRegex( self->vmSpace, src );
+	if( pat == NULL ){
+		pat = DaoRegex_New( src );
+		for( i=0; i<pat->count; i++ ){
+			DaoRgxItem *it = pat->items + i;
+			if( it->type ==0 ){
+				sprintf( buf, "incorrect pattern, at char %i.", it->length );
+				if( self->activeRoutine ) DaoProcess_RaiseError( self, NULL, buf );
+				DaoRegex_Delete( pat );
+				return NULL;
+			}
 		}
+		DaoVmSpace_AddRegex( self->vmSpace, src, pat );
+	}
+	while( regexCaches->size >= DAO_REGEX_PROCESS_CACHE ){
+		node = DMap_First( regexCaches );
+		DaoRegex_Delete( (DaoRegex*) node->value.pVoid );
+		DMap_EraseNode( regexCaches, node );
 	}
 	DMap_Insert( regexCaches, src, pat );
 	return pat;
@@ -216,6 +216,30 @@ DAO_DLL void* DaoProcess_GetAuxData( DaoProcess *self, void *key );
 DAO_DLL void* DaoProcess_SetAuxData( DaoProcess *self, void *key, void *value );
 
 
+#ifdef DAO_WITH_VMSTATS
+/*
+// Execution statistics of the virtual machine instructions (build option VMSTATS).
+// The counters are shared by all processes and updated without synchronization,
+// so they are approximate when multiple processes run concurrently.
+// The cycles (from the time stamp counter where it is available) spent between
+// two instruction dispatches are attributed to the first of them, so calls and
+// native functions are included in the cycles of the calling instructions.
+// Row DVM_NULL of @pairs counts the first instruction of each execution;
+*/
+typedef struct DaoVmStats DaoVmStats;
+
+struct DaoVmStats
+{
+	dao_integer  counts[DVM_NULL+1];
+	dao_integer  cycles[DVM_NULL+1];
+	dao_integer  pairs[DVM_NULL+1][DVM_NULL+1];
+};
+
+DAO_DLL DaoVmStats* DaoVmStats_Get();
+DAO_DLL void DaoVmStats_Reset();
+#endif
+
+
 
 typedef struct DaoJIT         DaoJIT;
 typedef struct DaoJitCallData DaoJitCallData;
@@ -511,6 +511,45 @@ static int MakeRegex( DaoRegex *self, DString *ds, void *spatt,
 	return self->count;
 }
 
+/*
+// Find the literal words that can be used to skip the starting positions
+// that cannot match, or to reject the source without trying any position.
+// Items with alternatives are not considered, except that the prefix can be
+// found before them. Groups cannot be repeated, so a group without
+// alternatives is entered unconditionally.
+*/
+static void InitPrefilter( DaoRegex *self )
+{
+	DaoRgxItem *patt;
+	int i, alts = 0, length = 0;
+
+	self->prefix = self->required = 0;
+	for(i=1; i<self->count && self->items[i].type == PAT_SPLIT; ++i){
+		if( self->items[i].jump ) break;
+	}
+	patt = self->items + i;
+	if( patt->type == PAT_WORD && patt->min > 0 && !(patt->config & PAT_CONFIG_CASEINS) ){
+		self->prefix = i;
+	}
+	for(i=1; i<self->count; ++i){
+		patt = self->items + i;
+		if( patt->type == PAT_PATPAIR || (patt->type == PAT_SPLIT && patt->jump) ) alts = 1;
+		if( patt->type != PAT_WORD || patt->min == 0 ) continue;
+		if( patt->config & PAT_CONFIG_CASEINS ) continue;
+		if( patt->length > length ){
+			self->required = i;
+			length = patt->length;
+		}
+	}
+	if( alts || self->required == self->prefix ) self->required = 0;
+}
+static daoint FindWord( DaoRegex *self, DaoRgxItem *patt, void *src, daoint from, daoint to )
+{
+	DString source = DString_WrapBytes( (char*) src, to );
+	DString word = DString_WrapBytes( self->wordbuf + patt->word, patt->length );
+	return DString_Find( & source, & word, from );
+}
+
 static const int sizepat = sizeof(DaoRegex);
 static const int sizeitm = sizeof(DaoRgxItem);
 static const int sizewch = sizeof(wchar_t);
@@ -560,6 +599,7 @@ static int InitRegex( DaoRegex *self, DString *ds )
 		self->group = max; /*  restrict capture exporting */
 	}
 	if( fixed ) self->attrib |= PAT_ALL_FIXED;
+	InitPrefilter( self );
 	memmove( self->items + self->count, self->wordbuf, self->wordlen );
 	self->wordbuf = (char*)(self->items + self->count);
 	self->itemlen = self->count * sizeitm;
@@ -916,9 +956,12 @@ static int DaoRegex_Search( DaoRegex *self, DaoRgxItem *patts, int npatt,
 	daoint pos, sum, max = 0, min = 0x7fffffff, from = 0, to = size;
 	daoint oldstart = self->start, oldend = self->end;
 	int bl, expand, matched, minmode = ((self->config & PAT_CONFIG_MIN) !=0);
+	DaoRgxItem *prefix = NULL, *required = NULL;
 	if( patts == NULL ){
 		patts = self->items;
 		npatt = self->count;
+		if( self->prefix && fixed == 0 ) prefix = patts + self->prefix;
+		if( self->required ) required = patts + self->required;
 	}
 #if 0
 	int i;
@@ -931,10 +974,12 @@ static int DaoRegex_Search( DaoRegex *self, DaoRgxItem *patts, int npatt,
 	if( start ) from = *start; else start = & s1;
 	if( end ) to = *end; else end = & s2;
 	if( to > size ) to = size;
+	if( required && FindWord( self, required, src, from, to ) == DAO_NULLPOS ) return 0;
+	pos = prefix ? FindWord( self, prefix, src, from, to ) : from;
+	if( pos == DAO_NULLPOS ) return 0;
 	self->source = src;
 	self->start = from;
 	self->end = to;
-	pos = from;
 	patt = patts;
 	patt->pos = 0;
 	patt->from = 0;
@@ -956,6 +1001,10 @@ static int DaoRegex_Search( DaoRegex *self, DaoRgxItem *patts, int npatt,
 			if( patt == patts ){
 				pos += 1;
 				if( fixed ) break;
+				if( prefix ){
+					pos = FindWord( self, prefix, src, pos, to );
+					if( pos == DAO_NULLPOS ) break;
+				}
 			}else{
 				pos = patt->pos;
 				patt2 = patt - patt->from;
@@ -1084,6 +1133,12 @@ void DaoRegex_Copy( DaoRegex *self, DaoRegex *src )
 	self->items = (DaoRgxItem*)(((char*)self) + sizepat);
 	self->wordbuf = ((char*)self) + sizepat + self->itemlen;
 }
+DaoRegex* DaoRegex_Duplicate( DaoRegex *src )
+{
+	DaoRegex *self = (DaoRegex*) dao_malloc( src->length );
+	DaoRegex_Copy( self, src );
+	return self;
+}
 int DaoRegex_Match( DaoRegex *self, DString *src, daoint *start, daoint *end )
 {
 	return DaoRegex_Search( self, 0,0, src->chars, src->size, start, end, 0 );
@@ -31,6 +31,12 @@
 
 #include"daoType.h"
 
+/* Maximum number of compiled patterns kept in the VM space cache: */
+#define DAO_REGEX_CACHE  256
+
+/* Maximum number of compiled patterns kept by each process: */
+#define DAO_REGEX_PROCESS_CACHE  32
+
 typedef struct DaoRgxItem DaoRgxItem;
 
 struct DaoRgxItem
@@ -63,6 +69,8 @@ struct DaoRegex
 	short  attrib;
 	short  group;
 	short  indexed;
+	short  prefix;   /* item of the literal word every match starts with; */
+	short  required; /* item of a literal word every match contains; */
 	char  *wordbuf;
 	int    itemlen; /* in bytes */
 	int    wordlen; /* in bytes */
@@ -72,6 +80,7 @@ struct DaoRegex
 DAO_DLL DaoRegex* DaoRegex_New( DString *src );
 #define DaoRegex_Delete( self ) dao_free( self )
 DAO_DLL void DaoRegex_Copy( DaoRegex *self, DaoRegex *src );
+DAO_DLL DaoRegex* DaoRegex_Duplicate( DaoRegex *src );
 
 /* compute the number of bytes needed for storing the compiled pattern */
 DAO_DLL int DaoRegex_CheckSize( DString *src );
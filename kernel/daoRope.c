@@ -0,0 +1,538 @@
+/*
+// Dao Virtual Machine
+// http://daoscript.org
+//
+// Copyright (c) 2006-2017, Limin Fu
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED  BY THE COPYRIGHT HOLDERS AND  CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED  WARRANTIES,  INCLUDING,  BUT NOT LIMITED TO,  THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL  THE COPYRIGHT HOLDER OR CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,
+// INDIRECT,  INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSEQUENTIAL  DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO,  PROCUREMENT OF  SUBSTITUTE  GOODS OR  SERVICES;  LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY OF
+// LIABILITY,  WHETHER IN CONTRACT,  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include<string.h>
+#include"daoRope.h"
+#include"daoStream.h"
+#include"daoValue.h"
+#include"daoProcess.h"
+#include"daoVmspace.h"
+#include"daoThread.h"
+
+
+static DRopeNode* DRopeNode_New( DString *chunk )
+{
+	DRopeNode *self = (DRopeNode*) dao_calloc( 1, sizeof(DRopeNode) );
+	self->chunk = chunk;
+	self->size = chunk->size;
+	self->count = 1;
+	self->refCount = 1;
+	return self;
+}
+static void DRopeNode_Delete( DRopeNode *self )
+{
+	if( self == NULL ) return;
+	if( DAtomic_Add( & self->refCount, -1 ) > 0 ) return;
+	DRopeNode_Delete( self->left );
+	DRopeNode_Delete( self->right );
+	DString_Delete( self->chunk );
+	dao_free( self );
+}
+static DRopeNode* DRopeNode_Share( DRopeNode *self )
+{
+	if( self != NULL ) DAtomic_Add( & self->refCount, 1 );
+	return self;
+}
+/*
+// Return a node that can be updated in place: a shared node is replaced by
+// a copy sharing its children and chunk buffer, and the caller's reference
+// to it is transferred to the copy;
+*/
+static DRopeNode* DRopeNode_Unshare( DRopeNode *self )
+{
+	DRopeNode *copy;
+	if( self->refCount == 1 ) return self;
+	copy = DRopeNode_New( DString_Copy( self->chunk ) );
+	copy->left = DRopeNode_Share( self->left );
+	copy->right = DRopeNode_Share( self->right );
+	copy->size = self->size;
+	copy->count = self->count;
+	DRopeNode_Delete( self ); /* the node may have been released by the other owners; */
+	return copy;
+}
+static daoint DRopeNode_Size( DRopeNode *self )
+{
+	return self ? self->size : 0;
+}
+static daoint DRopeNode_Count( DRopeNode *self )
+{
+	return self ? self->count : 0;
+}
+static void DRopeNode_Update( DRopeNode *self )
+{
+	self->size = DRopeNode_Size( self->left ) + self->chunk->size + DRopeNode_Size( self->right );
+	self->count = DRopeNode_Count( self->left ) + 1 + DRopeNode_Count( self->right );
+}
+static uint_t DRopeNode_Random( uint_t *seed )
+{
+	/* Xorshift: */
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+/*
+// Merge two trees with the root of either tree chosen at random with the
+// probability proportional to its number of nodes. This keeps the expected
+// depth logarithmic without per node priorities, which could not be kept
+// in heap order when subtrees are shared and merged repeatedly.
+*/
+static DRopeNode* DRopeNode_Merge( DRopeNode *left, DRopeNode *right, uint_t *seed )
+{
+	if( left == NULL ) return right;
+	if( right == NULL ) return left;
+	if( DRopeNode_Random( seed ) % (left->count + right->count) < left->count ){
+		left = DRopeNode_Unshare( left );
+		left->right = DRopeNode_Merge( left->right, right, seed );
+		DRopeNode_Update( left );
+		return left;
+	}
+	right = DRopeNode_Unshare( right );
+	right->left = DRopeNode_Merge( left, right->left, seed );
+	DRopeNode_Update( right );
+	return right;
+}
+/*
+// Split the tree such that the left part holds the first "pos" bytes.
+// A chunk across the split position is divided, and the divided tail
+// takes the right subtree of the original node.
+*/
+static void DRopeNode_Split( DRopeNode *self, daoint pos, DRopeNode **left, DRopeNode **right )
+{
+	DRopeNode *tail;
+	daoint lsize, offset;
+
+	if( self == NULL ){
+		*left = *right = NULL;
+		return;
+	}else if( pos <= 0 ){
+		*left = NULL;
+		*right = self;
+		return;
+	}else if( pos >= self->size ){
+		*left = self;
+		*right = NULL;
+		return;
+	}
+	self = DRopeNode_Unshare( self );
+	lsize = DRopeNode_Size( self->left );
+	if( pos <= lsize ){
+		DRopeNode_Split( self->left, pos, left, & self->left );
+		DRopeNode_Update( self );
+		*right = self;
+		return;
+	}else if( pos >= lsize + self->chunk->size ){
+		DRopeNode_Split( self->right, pos - lsize - self->chunk->size, & self->right, right );
+		DRopeNode_Update( self );
+		*left = self;
+		return;
+	}
+	offset = pos - lsize;
+	tail = DRopeNode_New( DString_New() );
+	DString_SubString( self->chunk, tail->chunk, offset, -1 );
+	DString_Reset( self->chunk, offset );
+	tail->right = self->right;
+	self->right = NULL;
+	DRopeNode_Update( tail );
+	DRopeNode_Update( self );
+	*left = self;
+	*right = tail;
+}
+/*
+// Find the node whose chunk receives the bytes inserted at the position:
+*/
+static DRopeNode* DRopeNode_Locate( DRopeNode *self, daoint pos )
+{
+	while( self != NULL ){
+		daoint lsize = DRopeNode_Size( self->left );
+		if( pos < lsize ){
+			self = self->left;
+		}else if( pos <= lsize + self->chunk->size ){
+			return self;
+		}else{
+			pos -= lsize + self->chunk->size;
+			self = self->right;
+		}
+	}
+	return NULL;
+}
+static DRopeNode* DRopeNode_InsertBytes( DRopeNode *self, daoint pos, const char *bytes, daoint count )
+{
+	daoint lsize;
+
+	self = DRopeNode_Unshare( self );
+	lsize = DRopeNode_Size( self->left );
+	if( pos < lsize ){
+		self->left = DRopeNode_InsertBytes( self->left, pos, bytes, count );
+	}else if( pos == lsize + self->chunk->size ){
+		DString_AppendBytes( self->chunk, bytes, count );
+	}else if( pos <= lsize + self->chunk->size ){
+		DString_InsertChars( self->chunk, bytes, pos - lsize, 0, count );
+	}else{
+		self->right = DRopeNode_InsertBytes( self->right, pos - lsize - self->chunk->size, bytes, count );
+	}
+	self->size += count;
+	return self;
+}
+/*
+// Insert small pieces directly into the chunk at the position,
+// if it has room for them:
+*/
+static int DRopeNode_TryInsert( DRopeNode **self, daoint pos, const char *bytes, daoint count )
+{
+	DRopeNode *node = DRopeNode_Locate( *self, pos );
+
+	if( node == NULL || node->chunk->size + count > DAO_ROPE_CHUNK ) return 0;
+	*self = DRopeNode_InsertBytes( *self, pos, bytes, count );
+	return 1;
+}
+/*
+// Remove the first chunk from the tree, and move its bytes to "bytes":
+*/
+static DRopeNode* DRopeNode_PopFirst( DRopeNode *self, DString *bytes )
+{
+	DRopeNode *right;
+
+	self = DRopeNode_Unshare( self );
+	if( self->left != NULL ){
+		self->left = DRopeNode_PopFirst( self->left, bytes );
+		DRopeNode_Update( self );
+		return self;
+	}
+	DString_Assign( bytes, self->chunk );
+	right = self->right;
+	self->right = NULL;
+	DRopeNode_Delete( self );
+	return right;
+}
+static DRopeNode* DRopeNode_AppendLast( DRopeNode *self, DString *bytes )
+{
+	self = DRopeNode_Unshare( self );
+	if( self->right != NULL ){
+		self->right = DRopeNode_AppendLast( self->right, bytes );
+	}else{
+		DString_AppendBytes( self->chunk, bytes->chars, bytes->size );
+	}
+	self->size += bytes->size;
+	return self;
+}
+/*
+// Merge two trees, and merge the chunks at the seam if they are small
+// enough to fit in one chunk, so that repeated splitting, erasing and
+// appending do not leave behind many small fragments:
+*/
+static DRopeNode* DRopeNode_Join( DRopeNode *left, DRopeNode *right, uint_t *seed )
+{
+	DRopeNode *last = left, *first = right;
+
+	while( last != NULL && last->right != NULL ) last = last->right;
+	while( first != NULL && first->left != NULL ) first = first->left;
+	if( last != NULL && first != NULL ){
+		if( last->chunk->size + first->chunk->size <= DAO_ROPE_CHUNK ){
+			DString *bytes = DString_New();
+			right = DRopeNode_PopFirst( right, bytes );
+			left = DRopeNode_AppendLast( left, bytes );
+			DString_Delete( bytes );
+		}
+	}
+	return DRopeNode_Merge( left, right, seed );
+}
+static void DRopeNode_Flatten( DRopeNode *self, DString *output )
+{
+	while( self != NULL ){
+		DRopeNode_Flatten( self->left, output );
+		DString_AppendBytes( output, self->chunk->chars, self->chunk->size );
+		self = self->right;
+	}
+}
+static void DRopeNode_Write( DRopeNode *self, DaoStream *stream )
+{
+	while( self != NULL ){
+		DRopeNode_Write( self->left, stream );
+		DaoStream_WriteString( stream, self->chunk );
+		self = self->right;
+	}
+}
+
+
+
+DaoRope* DaoRope_New( DaoType *type )
+{
+	DaoRope *self = (DaoRope*) dao_calloc( 1, sizeof(DaoRope) );
+	DaoCstruct_Init( (DaoCstruct*) self, type );
+	self->seed = 0x9E3779B9;
+	return self;
+}
+void DaoRope_Delete( DaoRope *self )
+{
+	DRopeNode_Delete( self->root );
+	DaoCstruct_Free( (DaoCstruct*) self );
+	dao_free( self );
+}
+
+daoint DaoRope_Size( DaoRope *self )
+{
+	return DRopeNode_Size( self->root );
+}
+void DaoRope_Clear( DaoRope *self )
+{
+	DRopeNode_Delete( self->root );
+	self->root = NULL;
+}
+
+static DRopeNode* DaoRope_MakeNode( DaoRope *self, DString *text, const char *bytes, daoint count )
+{
+	DString *chunk = NULL;
+	if( text != NULL && count >= DAO_ROPE_CHUNK ){
+		chunk = DString_Copy( text ); /* Share the buffer of large pieces; */
+	}else{
+		chunk = DString_New();
+		DString_AppendBytes( chunk, bytes, count );
+	}
+	return DRopeNode_New( chunk );
+}
+static void DaoRope_InsertBytes( DaoRope *self, DString *text, const char *bytes, daoint count, daoint pos )
+{
+	DRopeNode *left, *right, *node;
+
+	if( count <= 0 ) return;
+	if( DRopeNode_TryInsert( & self->root, pos, bytes, count ) ) return;
+
+	node = DaoRope_MakeNode( self, text, bytes, count );
+	if( pos >= DaoRope_Size( self ) ){
+		self->root = DRopeNode_Join( self->root, node, & self->seed );
+		return;
+	}
+	DRopeNode_Split( self->root, pos, & left, & right );
+	left = DRopeNode_Join( left, node, & self->seed );
+	self->root = DRopeNode_Join( left, right, & self->seed );
+}
+void DaoRope_AppendBytes( DaoRope *self, const char *bytes, daoint count )
+{
+	DaoRope_InsertBytes( self, NULL, bytes, count, DaoRope_Size( self ) );
+}
+void DaoRope_Append( DaoRope *self, DString *text )
+{
+	DaoRope_InsertBytes( self, text, text->chars, text->size, DaoRope_Size( self ) );
+}
+void DaoRope_AppendRope( DaoRope *self, DaoRope *other )
+{
+	self->root = DRopeNode_Join( self->root, DRopeNode_Share( other->root ), & self->seed );
+}
+void DaoRope_Insert( DaoRope *self, DString *text, daoint pos )
+{
+	DaoRope_InsertBytes( self, text, text->chars, text->size, pos );
+}
+void DaoRope_Erase( DaoRope *self, daoint pos, daoint count )
+{
+	DRopeNode *left, *middle, *right;
+	daoint size = DaoRope_Size( self );
+
+	if( pos >= size || count == 0 ) return;
+	if( count < 0 || count > size - pos ) count = size - pos;
+
+	DRopeNode_Split( self->root, pos, & left, & right );
+	DRopeNode_Split( right, count, & middle, & right );
+	DRopeNode_Delete( middle );
+	self->root = DRopeNode_Join( left, right, & self->seed );
+}
+void DaoRope_Flatten( DaoRope *self, DString *output )
+{
+	DString_Reserve( output, output->size + DaoRope_Size( self ) );
+	DRopeNode_Flatten( self->root, output );
+}
+void DaoRope_Write( DaoRope *self, DaoStream *stream )
+{
+	DRopeNode_Write( self->root, stream );
+}
+
+
+
+static void ROPE_New( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = DaoRope_New( proc->vmSpace->typeRope );
+	DaoRope_Append( self, p[0]->xString.value );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+}
+static void ROPE_Size( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	DaoProcess_PutInteger( proc, DaoRope_Size( self ) );
+}
+static void ROPE_Clear( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope_Clear( (DaoRope*) p[0] );
+}
+static void ROPE_Append( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	DaoRope_Append( self, p[1]->xString.value );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+}
+static void ROPE_Append2( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	DaoRope_AppendRope( self, (DaoRope*) p[1] );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+}
+static void ROPE_Insert( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	daoint size = DaoRope_Size( self );
+	daoint pos = p[2]->xInteger.value;
+	if( pos < 0 ) pos += size;
+	if( pos < 0 || pos > size ){
+		DaoProcess_RaiseError( proc, "Index::Range", NULL );
+		return;
+	}
+	DaoRope_Insert( self, p[1]->xString.value, pos );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+}
+static void ROPE_Erase( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	daoint size = DaoRope_Size( self );
+	daoint pos = p[1]->xInteger.value;
+	if( pos < 0 ) pos += size;
+	if( pos < 0 || pos > size ){
+		DaoProcess_RaiseError( proc, "Index::Range", NULL );
+		return;
+	}
+	DaoRope_Erase( self, pos, p[2]->xInteger.value );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+}
+static void ROPE_Write( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoRope *self = (DaoRope*) p[0];
+	DaoStream *stream = (DaoStream*) p[1];
+	if( DaoStream_IsWritable( stream ) == 0 ){
+		DaoProcess_RaiseError( proc, NULL, "stream is not writable" );
+		return;
+	}
+	DaoRope_Write( self, stream );
+}
+
+static DaoFunctionEntry daoRopeMeths[] =
+{
+	{ ROPE_New,
+		"Rope( text = \"\" ) => Rope"
+		/*
+		// Create a rope with "text" as the initial content;
+		*/
+	},
+	{ ROPE_Size,
+		"size( invar self: Rope ) => int"
+		/*
+		// Return the number of bytes in the rope;
+		*/
+	},
+	{ ROPE_Clear,
+		"clear( self: Rope )"
+	},
+	{ ROPE_Append,
+		"append( self: Rope, text: string ) => Rope"
+		/*
+		// Append "text" to the end of the rope;
+		// Return the rope itself;
+		*/
+	},
+	{ ROPE_Append2,
+		"append( self: Rope, other: invar<Rope> ) => Rope"
+		/*
+		// Append the content of "other" to the end of the rope;
+		// The nodes of "other" are shared (copy on write) instead of being copied;
+		*/
+	},
+	{ ROPE_Insert,
+		"insert( self: Rope, text: string, pos = 0 ) => Rope"
+		/*
+		// Insert "text" at byte position "pos";
+		// Return the rope itself;
+		*/
+	},
+	{ ROPE_Erase,
+		"erase( self: Rope, pos = 0, count = -1 ) => Rope"
+		/*
+		// Erase "count" bytes starting from "pos";
+		// Return the rope itself;
+		*/
+	},
+	{ ROPE_Write,
+		"write( invar self: Rope, stream: io::Stream )"
+		/*
+		// Write the content chunk by chunk to "stream" without flattening;
+		*/
+	},
+	{ NULL, NULL }
+};
+
+
+static DaoType* DaoRope_CheckConversion( DaoType *self, DaoType *type, DaoRoutine *ctx )
+{
+	if( type->tid == DAO_STRING ) return type;
+	return NULL;
+}
+static DaoValue* DaoRope_DoConversion( DaoValue *self, DaoType *type, int copy, DaoProcess *proc )
+{
+	DaoValue *res;
+	if( type->tid != DAO_STRING ) return NULL;
+	res = DaoValue_SimpleCopy( type->value );
+	DaoProcess_CacheValue( proc, res );
+	DString_Reset( res->xString.value, 0 );
+	DaoRope_Flatten( (DaoRope*) self, res->xString.value );
+	return res;
+}
+static void DaoRope_Print( DaoValue *self, DaoStream *stream, DMap *cycmap, DaoProcess *proc )
+{
+	DaoRope_Write( (DaoRope*) self, stream );
+}
+DaoTypeCore daoRopeCore =
+{
+	"Rope",                                            /* name */
+	sizeof(DaoRope),                                   /* size */
+	{ NULL },                                          /* bases */
+	{ NULL },                                          /* casts */
+	NULL,                                              /* numbers */
+	daoRopeMeths,                                      /* methods */
+	DaoCstruct_CheckGetField,  DaoCstruct_DoGetField,  /* GetField */
+	NULL,                      NULL,                   /* SetField */
+	NULL,                      NULL,                   /* GetItem */
+	NULL,                      NULL,                   /* SetItem */
+	NULL,                      NULL,                   /* Unary */
+	NULL,                      NULL,                   /* Binary */
+	DaoRope_CheckConversion,   DaoRope_DoConversion,   /* Conversion */
+	NULL,                      NULL,                   /* ForEach */
+	DaoRope_Print,                                     /* Print */
+	NULL,                                              /* Slice */
+	NULL,                                              /* Compare */
+	NULL,                                              /* Hash */
+	NULL,                                              /* Create */
+	NULL,                                              /* Copy */
+	(DaoDeleteFunction) DaoRope_Delete,                /* Delete */
+	NULL                                               /* HandleGC */
+};
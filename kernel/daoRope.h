@@ -0,0 +1,95 @@
+/*
+// Dao Virtual Machine
+// http://daoscript.org
+//
+// Copyright (c) 2006-2017, Limin Fu
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED  BY THE COPYRIGHT HOLDERS AND  CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED  WARRANTIES,  INCLUDING,  BUT NOT LIMITED TO,  THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL  THE COPYRIGHT HOLDER OR CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,
+// INDIRECT,  INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSEQUENTIAL  DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO,  PROCUREMENT OF  SUBSTITUTE  GOODS OR  SERVICES;  LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY OF
+// LIABILITY,  WHETHER IN CONTRACT,  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DAO_ROPE_H
+#define DAO_ROPE_H
+
+#include"daoType.h"
+
+/*
+// Byte size up to which small pieces are appended or inserted in place
+// into an existing chunk, instead of being stored in a new chunk node:
+*/
+#define DAO_ROPE_CHUNK  4096
+
+
+typedef struct DRopeNode  DRopeNode;
+
+/*
+// Rope node:
+// The nodes form a randomized binary search tree ordered by text position,
+// each node holding one chunk of the text. The subtree size is the number of
+// bytes of the chunks in the subtree, and is used to locate positions. The
+// subtree count is the number of nodes, and is used to balance the tree.
+// Chunks of large pieces are shared with the source strings (copy on write).
+//
+// Nodes are reference counted, so that subtrees can be shared between ropes;
+// a shared node is copied (sharing its children and chunk) before any update.
+// The counts are updated atomically, since the ropes sharing nodes may be
+// updated and freed in different threads.
+*/
+struct DRopeNode
+{
+	DRopeNode  *left;
+	DRopeNode  *right;
+	DString    *chunk;
+	daoint      size;
+	daoint      count;
+	uint_t      refCount;
+};
+
+
+/*
+// Rope for building large texts incrementally:
+// Appending (strings or ropes), inserting and erasing take logarithmic time
+// in the number of chunks (plus the size of the affected chunks), instead of
+// copying the whole text as string concatenation does. Adjacent small chunks
+// are merged when they are joined by these operations.
+*/
+struct DaoRope
+{
+	DAO_CSTRUCT_COMMON;
+
+	DRopeNode  *root;
+	uint_t      seed;
+};
+
+DAO_DLL DaoRope* DaoRope_New( DaoType *type );
+DAO_DLL void DaoRope_Delete( DaoRope *self );
+
+DAO_DLL daoint DaoRope_Size( DaoRope *self );
+DAO_DLL void DaoRope_Clear( DaoRope *self );
+DAO_DLL void DaoRope_AppendBytes( DaoRope *self, const char *bytes, daoint count );
+DAO_DLL void DaoRope_Append( DaoRope *self, DString *text );
+DAO_DLL void DaoRope_AppendRope( DaoRope *self, DaoRope *other );
+DAO_DLL void DaoRope_Insert( DaoRope *self, DString *text, daoint pos );
+DAO_DLL void DaoRope_Erase( DaoRope *self, daoint pos, daoint count );
+DAO_DLL void DaoRope_Flatten( DaoRope *self, DString *output );
+DAO_DLL void DaoRope_Write( DaoRope *self, DaoStream *stream );
+
+#endif
@@ -385,6 +385,67 @@ static void DaoSTD_ProcData( DaoProcess *proc, DaoValue *p[], int n )
 	if( n == 0 ) return;
 	DaoValue_Move( p[0], & proc->stackValues[1], NULL );
 }
+static void DaoSTD_VmStats( DaoProcess *proc, DaoValue *p[], int n )
+{
+#ifdef DAO_WITH_VMSTATS
+	DaoVmStats *stats = DaoVmStats_Get();
+	DaoTuple *res = DaoProcess_PutTuple( proc, 0 );
+	DaoType *opstype = res->ctype->args->items.pType[0];
+	DaoType *pairstype = res->ctype->args->items.pType[1];
+	DaoType *itemtype;
+	DaoMap *opcodes, *pairs;
+	DaoTuple *item;
+	DaoInteger count = {DAO_INTEGER,0,0,0,0,0};
+	char key[64];
+	int i, j;
+
+	if( opstype->tid == DAO_PAR_NAMED ) opstype = & opstype->aux->xType;
+	if( pairstype->tid == DAO_PAR_NAMED ) pairstype = & pairstype->aux->xType;
+	itemtype = opstype->args->items.pType[1];
+
+	opcodes = DaoMap_New(1);
+	pairs = DaoMap_New(1);
+	opcodes->ctype = opstype;
+	pairs->ctype = pairstype;
+	GC_IncRC( opstype );
+	GC_IncRC( pairstype );
+	DaoTuple_SetItem( res, (DaoValue*) opcodes, 0 );
+	DaoTuple_SetItem( res, (DaoValue*) pairs, 1 );
+	opcodes = (DaoMap*) res->values[0];
+	pairs = (DaoMap*) res->values[1];
+
+	for(i=0; i<DVM_NULL; ++i){
+		if( stats->counts[i] == 0 ) continue;
+		item = DaoTuple_Create( itemtype, 2, 1 );
+		item->values[0]->xInteger.value = stats->counts[i];
+		item->values[1]->xInteger.value = stats->cycles[i];
+		DaoMap_InsertChars( opcodes, DaoVmCode_GetOpcodeName( i ), (DaoValue*) item );
+	}
+	for(i=0; i<DVM_NULL; ++i){
+		for(j=0; j<DVM_NULL; ++j){
+			if( stats->pairs[i][j] == 0 ) continue;
+			snprintf( key, sizeof(key), "%s,%s", DaoVmCode_GetOpcodeName(i), DaoVmCode_GetOpcodeName(j) );
+			count.value = stats->pairs[i][j];
+			DaoMap_InsertChars( pairs, key, (DaoValue*) & count );
+		}
+	}
+	if( n && p[0]->xBoolean.value ) DaoVmStats_Reset();
+#else
+	DaoProcess_RaiseError( proc, NULL, "not built with VM statistics (build option VMSTATS)" );
+#endif
+}
+static void DaoSTD_RegexStats( DaoProcess *proc, DaoValue *p[], int n )
+{
+	DaoVmSpace *vmspace = proc->vmSpace;
+	DaoTuple *res = DaoProcess_PutTuple( proc, 0 );
+
+	DaoVmSpace_LockCache( vmspace );
+	res->values[0]->xInteger.value = vmspace->regexHits;
+	res->values[1]->xInteger.value = vmspace->regexMisses;
+	res->values[2]->xInteger.value = vmspace->regexCache->size;
+	if( n && p[0]->xBoolean.value ) vmspace->regexHits = vmspace->regexMisses = 0;
+	DaoVmSpace_UnlockCache( vmspace );
+}
 static void DaoSTD_Test( DaoProcess *proc, DaoValue *p[], int n )
 {
 	printf( "%i\n", p[0]->type );
@@ -437,6 +498,28 @@ DaoFunctionEntry dao_std_methods[] =
 	{ DaoSTD_ProcData,  "procdata( ) => any" },
 	{ DaoSTD_ProcData,  "procdata( data: any ) => any" },
 
+	{ DaoSTD_VmStats,
+		"vmstats( reset = false )"
+		"=> tuple<opcodes: map<string,tuple<count:int,cycles:int>>, pairs: map<string,int>>"
+		/*
+		// Return the execution statistics of the virtual machine instructions,
+		// if the virtual machine is built with the VMSTATS option:
+		// the number of executions and the cycles spent per opcode,
+		// and the number of executions per pair of consecutive opcodes
+		// (keyed by "PREV,NEXT"). Reset the statistics if "reset" is true.
+		*/
+	},
+	{ DaoSTD_RegexStats,
+		"regexstats( reset = false ) => tuple<hits: int, misses: int, cached: int>"
+		/*
+		// Return the number of lookups of patterns found and not found in the
+		// cache of compiled regular expressions shared by the processes,
+		// and the number of patterns in the cache (at most 256).
+		// Patterns found in the own cache of a process are not counted.
+		// Reset the counters if "reset" is true.
+		*/
+	},
+
 	{ DaoSTD_Warn,
 		"warn( info: string )"
 		/*
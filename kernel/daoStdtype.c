@@ -59,6 +59,7 @@ void DaoValue_Init( void *value, char type )
 	self->trait = self->marks = 0;
 	self->refCount = 0;
 	if( type >= DAO_ENUM ) ((DaoValue*)self)->xGC.cycRefCount = 0;
+	if( dao_gc_profiling ) DaoGC_ProfileNew( (DaoValue*) self );
 }
 
 static int DaoType_CheckTypeRange( DaoType *self, int min, int max )
@@ -1425,6 +1426,7 @@ static int DaoString_DoSetItem( DaoValue *self, DaoValue *index[], int N, DaoVal
 		pos = Dao_CheckNumberIndex( pos, size, proc );
 		if( pos < 0 ) return DAO_ERROR_INDEX;
 		if( value->type > DAO_FLOAT ) return DAO_ERROR_VALUE;
+		DString_Detach( self->xString.value, size );
 		self->xString.value->chars[pos] = DaoValue_GetInteger( value );
 		break;
 	case DAO_TUPLE :
@@ -1686,6 +1688,27 @@ static void DaoSTR_Find( DaoProcess *proc, DaoValue *p[], int N )
 	DaoProcess_PutInteger( proc, pos );
 }
 
+static void DaoSTR_Find2( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DString *self = p[0]->xString.value;
+	DaoList *keywords = (DaoList*) p[1];
+	daoint i, from = p[2]->xInteger.value;
+	daoint pos, count = keywords->value->size;
+	DString **keys = (DString**) dao_malloc( (count + 1) * sizeof(DString*) );
+	int which = -1;
+
+	for(i=0; i<count; ++i) keys[i] = keywords->value->items.pValue[i]->xString.value;
+	pos = DString_FindAny( self, keys, count, from, & which );
+	dao_free( keys );
+	if( pos != DAO_NULLPOS ){
+		DaoTuple *tuple = DaoProcess_PutTuple( proc, 2 );
+		tuple->values[0]->xInteger.value = pos;
+		tuple->values[1]->xInteger.value = which;
+	}else{
+		DaoProcess_PutNone( proc );
+	}
+}
+
 static void DaoSTR_Contains( DaoProcess *proc, DaoValue *p[], int N )
 {
 	DString *self = p[0]->xString.value;
@@ -1857,8 +1880,7 @@ static void DaoSTR_Split( DaoProcess *proc, DaoValue *p[], int N )
 		uchar_t *bytes = (unsigned char*) self->chars;
 		daoint i = 0;
 		while( i < size ){
-			daoint pos = DString_LocateChar( self, i, 0 );
-			int w = pos == DAO_NULLPOS ? 1 : DString_UTF8CharSize( bytes[i] );
+			int w = DString_DecodeChar( (char*) bytes + i, self->chars + size ).width;
 			DString_SetBytes( str, (char*) bytes + i, w );
 			DList_Append( list->value, value );
 			i += w;
@@ -2037,6 +2059,12 @@ static void DaoSTR_Scan( DaoProcess *proc, DaoValue *p[], int N )
 	sect = DaoProcess_InitCodeSection( proc, 3 );
 	if( sect == NULL ) return;
 
+	/*
+	// The code section may match with the same pattern of this process,
+	// which would overwrite the matching states stored in the pattern:
+	*/
+	patt = DaoRegex_Duplicate( patt );
+
 	denum.etype = DaoNamespace_MakeEnumType( proc->activeNamespace, "unmatched,matched" );
 	denum.subtype = DAO_ENUM_STATE;
 	entry = proc->topFrame->entry;
@@ -2076,9 +2104,16 @@ static void DaoSTR_Scan( DaoProcess *proc, DaoValue *p[], int N )
 		start = offset = end;
 		end = to;
 	}
+	DaoRegex_Delete( patt );
 	DaoProcess_PopFrame( proc );
 }
 
+static void DaoSTR_Intern( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DString *res = DaoProcess_PutString( proc, p[0]->xString.value );
+	DaoVmSpace_InternString( proc->vmSpace, res );
+}
+
 static void DaoSTR_Convert( DaoProcess *proc, DaoValue *p[], int N )
 {
 	DString *res = DaoProcess_PutString( proc, p[0]->xString.value );
@@ -2234,6 +2269,17 @@ static DaoFunctionEntry daoStringMeths[] =
 		// Return the index of the last byte of the found substring for backward searching;
 		*/
 	},
+	{ DaoSTR_Find2,
+		"find( invar self: string, keywords: list<string>, from = 0 )"
+			"=> tuple<pos:int,index:int>|none"
+		/*
+		// Find the first occurrence of any of the "keywords" in this string,
+		// searching forward from "from";
+		// Return the index of the first byte of the found keyword and the index
+		// of the keyword in "keywords"; or "none" if none of them is found.
+		// If several keywords occur at the same position, the first listed is taken.
+		*/
+	},
 	{ DaoSTR_Contains,
 		"contains( invar self: string, "
 			"...: tuple<pos:int|enum<prefix,suffix>,keyword:string> ) => bool"
@@ -2252,6 +2298,16 @@ static DaoFunctionEntry daoStringMeths[] =
 		// -- To upper cases;
 		*/
 	},
+	{ DaoSTR_Intern,
+		"intern( invar self: string ) => string"
+		/*
+		// Return the canonical instance of the string from the VM space;
+		// Interned strings that are equal share the same buffer, so that they
+		// can be compared by pointer. String literals up to 64 bytes are
+		// interned by the parser; At most 65536 strings are interned in a VM
+		// space, and once the limit is reached, the string is returned as it is;
+		*/
+	},
 	{ DaoSTR_Replace,
 		"replace( invar self: string, str1: string, str2: string, index = 0 ) => string"
 		/*
@@ -4268,23 +4324,10 @@ void DaoMap_Clear( DaoMap *self )
 
 void DaoMap_Reset( DaoMap *self, unsigned int hashing )
 {
-	DMap *map = self->value;
-
 	DMap_Reset( self->value );
 	if( hashing == 1 ) return;
 
-	if( hashing == 0 ){
-		map->hashing = 0;
-		if( map->table ) dao_free( map->table );
-		map->table = NULL;
-		map->tsize2rt = 0;
-	}else{
-		if( map->hashing == 0 ){
-			map->tsize2rt = 2;
-			map->table = (DNode**) dao_calloc( map->tsize2rt * map->tsize2rt, sizeof(DNode*) );
-		}
-		map->hashing = hashing;
-	}
+	DMap_SetHashing( self->value, hashing );
 }
 
 DaoType* DaoMap_GetType( DaoMap *self )
@@ -5202,20 +5245,12 @@ DaoTypeCore daoMapCore =
 // Tuple:
 */
 
-#define DAO_TUPLE_MINSIZE 2
-/*
-// 2 is used instead of 1, for two reasons:
-// A. most often used tuples have at least two items;
-// B. some builtin tuples have at least two items, and are accessed by
-//    constant sub-index, compilers such Clang may complain if 1 is used.
-*/
-
 DaoTuple* DaoTuple_New( int size )
 {
 	int extra = size > DAO_TUPLE_MINSIZE ? size - DAO_TUPLE_MINSIZE : 0;
 	DaoTuple *self = (DaoTuple*) dao_calloc( 1, sizeof(DaoTuple) + extra*sizeof(DaoValue*) );
+	self->size = size; /* Set before initialization for allocation profiling; */
 	DaoValue_Init( self, DAO_TUPLE );
-	self->size = size;
 	self->ctype = NULL;
 #ifdef DAO_USE_GC_LOGGER
 	DaoObjectLogger_LogNew( (DaoValue*) self );
@@ -5252,9 +5287,9 @@ DaoTuple* DaoTuple_Create( DaoType *type, int N, int init )
 	DaoTuple *self = (DaoTuple*) dao_calloc( 1, sizeof(DaoTuple) + extit*sizeof(DaoValue*) );
 	DaoType **types;
 
+	self->size = size;
 	DaoValue_Init( self, DAO_TUPLE );
 	GC_IncRC( type );
-	self->size = size;
 	self->ctype = type;
 	self->subtype = type->subtid;
 #ifdef DAO_USE_GC_LOGGER
@@ -193,6 +193,14 @@ DAO_DLL int DaoMap_Insert( DaoMap *self, DaoValue *key, DaoValue *value );
 DAO_DLL void DaoMap_Erase( DaoMap *self, DaoValue *key );
 
 
+/*
+// Number of items allocated inline with the tuple structure;
+// 2 is used instead of 1, for two reasons:
+// A. most often used tuples have at least two items;
+// B. some builtin tuples have at least two items, and are accessed by
+//    constant sub-index, compilers such Clang may complain if 1 is used.
+*/
+#define DAO_TUPLE_MINSIZE 2
 
 struct DaoTuple
 {
@@ -200,7 +208,7 @@ struct DaoTuple
 
 	int        size;      /* Packed with the previous field in 64-bits system; */
 	DaoType   *ctype;
-	DaoValue  *values[2]; /* The actual number of items is in ::size; */
+	DaoValue  *values[DAO_TUPLE_MINSIZE]; /* The actual number of items is in ::size; */
 };
 
 DAO_DLL DaoTuple* DaoTuple_Create( DaoType *type, int size, int init );
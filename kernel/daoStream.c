@@ -370,19 +370,40 @@ void DaoStream_PrintHL( DaoStream *self, int tag, const char *text )
 
 
 
+/*
+// Read the line in chunks with fgets(), which scans the stdio buffer in blocks.
+// Each chunk is prefilled with '\n', so that the number of read bytes can be
+// located with memchr() even for lines containing null bytes: the first '\n'
+// is either the line break followed by the terminating null, or a fill byte
+// right after the terminating null.
+*/
 int DaoFile_ReadLine( FILE *fin, DString *line )
 {
-	int ch;
+	daoint chunk = 128;
 
 	DString_Reset( line, 0 );
 	if( feof( fin ) ) return 0;
 
-	while( (ch = fgetc(fin)) != EOF ){
-		if( line->size == line->bufSize ) DString_Reserve( line, (daoint)(5 + 1.2*line->size) );
-		line->chars[ line->size ++ ] = ch;
-		line->chars[ line->size ] = '\0';
-		if( ch == '\n' ) break;
+	while(1){
+		char *buf, *pos;
+		if( line->size + chunk > line->bufSize ) DString_Reserve( line, line->size + chunk );
+		buf = line->chars + line->size;
+		memset( buf, '\n', chunk );
+		if( fgets( buf, chunk, fin ) == NULL ) break;
+		pos = (char*) memchr( buf, '\n', chunk );
+		if( pos == NULL ){ /* Full chunk without line break: */
+			line->size += chunk - 1;
+			if( chunk < IO_BUF_SIZE ) chunk *= 2;
+			continue;
+		}
+		if( (pos + 1) < (buf + chunk) && pos[1] == '\0' ){
+			line->size += pos - buf + 1;
+		}else{
+			line->size += pos - buf - 1;
+		}
+		break;
 	}
+	line->chars[ line->size ] = '\0';
 	return 1;
 }
 int DaoFile_ReadAll( FILE *fin, DString *output, int close )
@@ -803,6 +824,43 @@ static void DaoIO_ReadLines( DaoProcess *proc, DaoValue *p[], int N )
 	if( DaoIO_CheckMode( (DaoStream*) p[0], proc, DAO_STREAM_READABLE ) == 0 ) return;
 	DaoStream_ReadLines( (DaoStream*) p[0], list, proc, count, chop );
 }
+/*
+// Iterate over the lines without collecting them. The lines are read into
+// the string of the section parameter in place, so a line is copied only
+// when the code section retains it.
+*/
+static void DaoIO_Lines( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoStream *self = (DaoStream*) p[0];
+	DaoString tmp = {DAO_STRING,0,0,0,1,NULL};
+	DString tmp2 = DString_WrapChars( "" );
+	DString *line = & tmp2;
+	DaoVmCode *sect;
+	ushort_t entry;
+	int chop = p[1]->xBoolean.value;
+
+	if( DaoIO_CheckMode( self, proc, DAO_STREAM_READABLE ) == 0 ) return;
+
+	sect = DaoProcess_InitCodeSection( proc, 1 );
+	if( sect == NULL ) return;
+
+	entry = proc->topFrame->entry;
+	if( sect->b ){
+		tmp.value = & tmp2;
+		line = DaoProcess_SetValue( proc, sect->a, (DaoValue*)(void*) &tmp )->xString.value;
+	}else{
+		line = DString_New();
+	}
+	while( DaoStream_ReadLine( self, line ) ){
+		if( line->size == 0 && self->AtEnd != NULL && self->AtEnd( self ) ) break;
+		if( chop ) DString_Chop( line, 0 );
+		proc->topFrame->entry = entry;
+		DaoProcess_Execute( proc );
+		if( proc->status == DAO_PROCESS_ABORTED ) break;
+	}
+	if( sect->b == 0 ) DString_Delete( line );
+	DaoProcess_PopFrame( proc );
+}
 
 
 DaoFunctionEntry dao_io_methods[] =
@@ -823,6 +881,7 @@ static DaoFunctionEntry daoStreamMeths[] =
 	{ DaoIO_Read,      "read( self: Stream, count = -1 )=>string" },
 	{ DaoIO_Read,      "read( self: Stream, amount: enum<line,all> = $all )=>string" },
 	{ DaoIO_ReadLines, "readlines( self: Stream, numline=0, chop = false )[line: string=>none|@T]=>list<@T>" },
+	{ DaoIO_Lines,     "lines( self: Stream, chop = false )[line: invar<string>]" },
 
 	{ DaoIO_Flush,     "flush( self: Stream )" },
 	{ DaoIO_Enable,    "enable( self: Stream, what: enum<auto_conversion>, state: bool )" },
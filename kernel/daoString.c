@@ -28,6 +28,7 @@
 
 #include<stdio.h>
 #include<stdlib.h>
+#include<stddef.h>
 #include<string.h>
 #include<ctype.h>
 #include<wctype.h>
@@ -35,109 +36,162 @@
 
 #include"daoString.h"
 #include"daoThread.h"
+#include"daoMap.h"
 
+/*
+// Buffers are shared by copy-on-write, with the number of sharing strings
+// stored before the chars and updated atomically. The mutex only guards
+// the creation of the auxiliary data of the strings;
+*/
 #ifdef DAO_WITH_THREAD
-DMutex  mutex_string_sharing;
+DMutex  mutex_string_aux;
 #endif
 
 
-typedef struct DCounter DCounter;
+/*
+// The char index caches the byte offset of every DAO_STRING_CHARSTEP-th char,
+// so that a char is located by walking at most that many chars from the nearest
+// cached offset. Pure ASCII strings need no offsets. The index depends only on
+// the chars, so a large string shares it with the strings taking a share of its
+// buffer. The index may be shared before it is built, so that it is built once
+// for all such strings, no matter which of them is indexed first;
+*/
+#define DAO_STRING_CHARSTEP  64
+
+typedef struct DCharIndex DCharIndex;
 
-struct DCounter
+struct DCharIndex
 {
-	daoint  width : 4;             /* char width; */
-	daoint  count : DAOINT_BITS-4; /* char count with this width; */
-	daoint  chars;                 /* char index for this counter; */
-	daoint  bytes;                 /* byte index for this counter; */
+	int        refs;      /* number of sharing strings; */
+	int        ready;     /* the index is built; */
+	daoint     chars;     /* total number of chars in the string; */
+	daoint     size;      /* offset number; */
+	daoint     cap;       /* buffer size; */
+	daoint    *offsets;   /* byte offsets of every DAO_STRING_CHARSTEP-th char; */
 };
 
 struct DStringAux
 {
-	DCounter  *counters;  /* counter list; */
-	daoint     visit;     /* index of the last visited counter; */
-	daoint     chars;     /* total number of chars in the string; */
-	daoint     size;      /* counter number; */
-	daoint     cap;       /* buffer size; */
+	DCharIndex  *index;  /* char index, possibly not built yet; */
+
+	unsigned long long  hash;    /* cached hash (lower 32 bits) and its seed; */
+	int                 hashed;  /* cached hash is valid; */
 };
 
-static DStringAux* DStringAux_New()
+static int DString_CharWidth( uchar_t *chs, uchar_t *end );
+static daoint DString_SkipASCII( uchar_t *chs, uchar_t *end, daoint max );
+
+static void DCharIndex_Release( DCharIndex *self )
 {
-	DStringAux *self = (DStringAux*) dao_calloc(1,sizeof(DStringAux));
-	return self;
+	if( DAtomic_Add( & self->refs, -1 ) ) return;
+	if( self->offsets ) dao_free( self->offsets );
+	dao_free( self );
 }
-static void DStringAux_Delete( DStringAux *self )
+static DCharIndex* DCharIndex_New()
 {
-	if( self->counters ) dao_free( self->counters );
-	dao_free( self );
+	DCharIndex *self = (DCharIndex*) dao_calloc( 1, sizeof(DCharIndex) );
+	self->refs = 1;
+	return self;
 }
-static void DStringAux_Update( DStringAux *self, DString *string )
+static void DCharIndex_Build( DCharIndex *self, DString *string )
 {
-	daoint size = 0;
-	DCounter dummy = {7, 0, 0, 0};
-	DCounter *last = & dummy;
-	uchar_t *bytes = (unsigned char*) string->chars;
-	daoint i = 0;
+	uchar_t *start = (uchar_t*) string->chars;
+	uchar_t *end = start + string->size;
+	uchar_t *chs = start;
 
-	self->size = 0;
-	self->chars = 0;
-	self->visit = 0;
-	while( i < string->size ){
-		daoint pos = DString_LocateChar( string, i, 0 );
-		int width = pos == DAO_NULLPOS ? 1 : DString_UTF8CharSize( bytes[i] );
-		if( width == last->width ){
-			last->count += 1;
-		}else{
-			daoint chars = last->chars + last->count;
-			daoint bytes = last->bytes + last->count * last->width;
-			if( size == self->cap ){
-				self->cap += 1.25 * self->cap + 5;
-				self->counters = (DCounter*) dao_realloc( self->counters, self->cap*sizeof(DCounter) );
+	if( DString_SkipASCII( start, end, string->size ) == string->size ){
+		self->chars = string->size;
+		self->ready = 1;
+		return;
+	}
+	while( chs < end ){
+		daoint skip, step = self->chars % DAO_STRING_CHARSTEP;
+		if( step == 0 ){
+			if( self->size == self->cap ){
+				self->cap += 0.25 * self->cap + 8;
+				self->offsets = (daoint*) dao_realloc( self->offsets, self->cap*sizeof(daoint) );
 			}
-			last = self->counters + (size++);
-			last->width = width;
-			last->count = 1;
-			last->chars = chars;
-			last->bytes = bytes;
+			self->offsets[self->size++] = chs - start;
 		}
+		skip = DString_SkipASCII( chs, end, DAO_STRING_CHARSTEP - step );
+		if( skip ){
+			chs += skip;
+			self->chars += skip;
+			continue;
+		}
+		chs += DString_CharWidth( chs, end );
 		self->chars += 1;
-		i += width;
-	}
-	self->size = size; /* set after done, for thread safety; */
-
-#if 0
-	printf( "counters: %i;  chars: %i;  bytes: %i\n", (int) size, self->chars, string->size );
-	for(i=0; i<self->size; ++i){
-		DCounter *c = self->counters + i;
-		printf( "%5i: %2i %5i %5i %5i\n", i, c->width, c->count, c->chars, c->bytes );
 	}
-#endif
+	self->ready = 1; /* set after done, for thread safety; */
 }
-static daoint DStringAux_GetByteIndex( DStringAux *self, DString *string, daoint chindex )
+static daoint DCharIndex_GetByteIndex( DCharIndex *self, DString *string, daoint chindex )
 {
-	uchar_t *bytes = (uchar_t*) string->chars;
-	DCounter *start = self->counters;
-	DCounter *visit = start + self->visit;
-	DCounter *end = start + self->size;
+	uchar_t *start = (uchar_t*) string->chars;
+	uchar_t *end = start + string->size;
+	uchar_t *chs;
+	daoint count;
 
 	if( chindex < 0 ) chindex += self->chars;
 	if( chindex < 0 || chindex >= self->chars ) return DAO_NULLPOS;
-	while( visit >= start && chindex < visit->chars ) visit -= 1;
-	while( visit < end && chindex > visit->chars + visit->count ) visit += 1;
-	if( visit < start || visit >= end ) return DAO_NULLPOS;
-	self->visit = visit - start;
-	return visit->bytes + visit->width * (chindex - visit->chars);
+	if( self->chars == string->size ) return chindex;
+
+	chs = start + self->offsets[ chindex / DAO_STRING_CHARSTEP ];
+	count = chindex % DAO_STRING_CHARSTEP;
+	while( count > 0 ){
+		daoint skip = DString_SkipASCII( chs, end, count );
+		if( skip ){
+			chs += skip;
+			count -= skip;
+			continue;
+		}
+		chs += DString_CharWidth( chs, end );
+		count -= 1;
+	}
+	return chs - start;
+}
+
+static DStringAux* DStringAux_New()
+{
+	DStringAux *self = (DStringAux*) dao_calloc(1,sizeof(DStringAux));
+	return self;
+}
+static void DStringAux_Reset( DStringAux *self )
+{
+	if( self->index ) DCharIndex_Release( self->index );
+	self->index = NULL;
+	self->hashed = 0;
+}
+static void DStringAux_Delete( DStringAux *self )
+{
+	DStringAux_Reset( self );
+	dao_free( self );
 }
 
 
 
 static int dao_string[4] = {1,0,0,0};
 
+/*
+// Strings shorter than DAO_STRING_INLINE are stored in the inline buffer
+// without heap allocation. Such strings never share their buffers, and the
+// sharing flag only tells if the buffer will be shared once the string grows
+// out of the inline buffer or is moved by DString_MakeShareable();
+*/
+#define DString_IsInline( self )  ((self)->chars == (self)->bytes)
+
+static int* DString_Buffer( DString *self )
+{
+	if( DString_IsInline( self ) ) return NULL;
+	return (int*)self->chars - self->sharing;
+}
+
 /**/
 void DString_Init( DString *self )
 {
 	self->chars = (char*)(dao_string + 1);
 	self->detached = 1;
 	self->sharing = 1;
+	self->hashed = 0;
 	self->size = 0;
 	self->bufSize = 0;
 	self->aux = NULL;
@@ -157,7 +211,7 @@ DString* DString_NewChars( const char *mbs )
 
 void DString_DeleteData( DString *self )
 {
-	int *data = (int*)self->chars - self->sharing;
+	int *data = DString_Buffer( self );
 
 	if( self->aux ){
 		DStringAux_Delete( self->aux );
@@ -167,16 +221,7 @@ void DString_DeleteData( DString *self )
 	if( data == NULL || data == dao_string ) return;
 
 	if( self->sharing ){
-#ifdef DAO_WITH_THREAD
-		DMutex_Lock( & mutex_string_sharing );
-#endif
-		if( self->sharing ){
-			data[0] -= 1;
-			if( data[0] ==0 ) dao_free( data );
-		}
-#ifdef DAO_WITH_THREAD
-		DMutex_Unlock( & mutex_string_sharing );
-#endif
+		if( DAtomic_Add( data, -1 ) == 0 ) dao_free( data );
 	}else{
 		dao_free( data );
 	}
@@ -192,31 +237,78 @@ void DString_Delete( DString *self )
 void DString_Detach( DString *self, daoint bufsize )
 {
 	daoint size;
-	int *data2, *data = (int*)self->chars - self->sharing;
-
-	if( self->aux ) self->aux->size = 0;
-	if( self->sharing == 0 ) return;
-#ifdef DAO_WITH_THREAD
-	DMutex_Lock( & mutex_string_sharing );
-#endif
-	if( data[0] >1 || data == dao_string ){
+	int *data2, *data = DString_Buffer( self );
+
+	if( self->aux ) DStringAux_Reset( self->aux );
+	self->hashed = 0;
+	if( data == NULL || self->sharing == 0 ) return;
+	if( data == dao_string || *(volatile int*)data > 1 ){
+		/*
+		// The buffer is still referenced by this string while being copied.
+		// Releasing the reference afterwards frees the buffer if the other
+		// strings have released theirs in the mean time:
+		*/
 		if( bufsize < self->size ) bufsize = self->size;
-		data[0] -= 1;
+		if( bufsize < DAO_STRING_INLINE ){
+			memcpy( self->bytes, self->chars, (self->size + 1)*sizeof(char) );
+			self->chars = self->bytes;
+			self->bufSize = DAO_STRING_INLINE - 1;
+			if( data != dao_string && DAtomic_Add( data, -1 ) == 0 ) dao_free( data );
+			return;
+		}
 		self->bufSize = bufsize + 1;
 		data2 = (int*) dao_malloc( (self->bufSize + 1)*sizeof(char) + sizeof(int) );
 		data2[0] = 1;
 		memcpy( data2+1, data+1, (self->size + 1)*sizeof(char) );
 		self->chars = (char*)(data2 + 1);
+		if( data != dao_string && DAtomic_Add( data, -1 ) == 0 ) dao_free( data );
 	}
-#ifdef DAO_WITH_THREAD
-	DMutex_Unlock( & mutex_string_sharing );
-#endif
+}
+/*
+// Move a short string out of the inline buffer into a shared heap buffer,
+// so that the copies of the string will share the buffer with it:
+*/
+void DString_MakeShareable( DString *self )
+{
+	int *data;
+
+	DString_SetSharing( self, 1 );
+	if( DString_IsInline( self ) == 0 ) return;
+	if( self->aux ) DStringAux_Reset( self->aux );
+	self->hashed = 0;
+	data = (int*) dao_malloc( (self->size + 1)*sizeof(char) + sizeof(int) );
+	data[0] = 1;
+	memcpy( data + 1, self->bytes, (self->size + 1)*sizeof(char) );
+	self->chars = (char*)(data + 1);
+	self->bufSize = self->size;
 }
 static int* DString_Realloc( DString *self, daoint bufsize )
 {
 	daoint bsize = (bufsize + 1)*sizeof(char) + self->sharing*sizeof(int);
 	int *data, *data2;
 
+	if( bufsize < DAO_STRING_INLINE ){
+		/* Move into the inline buffer, the bytes beyond bufsize are truncated: */
+		data = DString_Buffer( self );
+		if( data == dao_string ){
+			self->bytes[0] = '\0';
+		}else if( data != NULL ){
+			daoint size = self->size < bufsize ? self->size : bufsize;
+			memcpy( self->bytes, self->chars, size*sizeof(char) );
+			self->bytes[size] = '\0';
+			dao_free( data );
+		}
+		self->chars = self->bytes;
+		self->bufSize = DAO_STRING_INLINE - 1;
+		return NULL;
+	}else if( DString_IsInline( self ) ){
+		data = (int*)dao_malloc( bsize );
+		if( self->sharing ) data[0] = 1;
+		self->chars = (char*)(data + self->sharing);
+		memcpy( self->chars, self->bytes, (self->size + 1)*sizeof(char) );
+		return data;
+	}
+
 	data = data2 = (int*)self->chars - self->sharing;
 	if( data == dao_string ) data = NULL;
 
@@ -228,21 +320,20 @@ static int* DString_Realloc( DString *self, daoint bufsize )
 }
 void DString_SetSharing( DString *self, int sharing )
 {
-	int *data = (int*)self->chars - self->sharing;
+	int *data = DString_Buffer( self );
 	if( (self->sharing == 0) == (sharing == 0) ) return;
 
-	if( sharing && data == dao_string ){
-		self->sharing = 1;
+	if( data == NULL || (sharing && data == dao_string) ){
+		self->sharing = sharing != 0;
 		return; /* OK for sharing; */
 	}
 
 	DString_Detach( self, self->bufSize );
-	data = (int*)self->chars - self->sharing;
+	data = DString_Buffer( self );
 	self->sharing = sharing != 0;
+	if( data == NULL ) return;
 
-#ifdef DAO_WITH_THREAD
-	DMutex_Lock( & mutex_string_sharing );
-#endif
+	/* The buffer is owned exclusively after detaching: */
 	if( sharing ==0 ){
 		memmove( data, self->chars, self->size*sizeof(char) );
 		self->bufSize += sizeof(int)/sizeof(char);
@@ -260,9 +351,6 @@ void DString_SetSharing( DString *self, int sharing )
 		self->chars[ self->size ] = 0;
 		data[0] = 1;
 	}
-#ifdef DAO_WITH_THREAD
-	DMutex_Unlock( & mutex_string_sharing );
-#endif
 }
 
 char*  DString_GetData( DString *self )
@@ -281,7 +369,6 @@ void DString_SetChars( DString *self, const char *chs )
 }
 void DString_Reserve( DString *self, daoint size )
 {
-	int *data = (int*)self->chars - self->sharing;
 	daoint bufsize = size >= self->bufSize ? (1.2*size + 4) : self->bufSize;
 
 	DString_Detach( self, bufsize );
@@ -289,6 +376,19 @@ void DString_Reserve( DString *self, daoint size )
 	self->bufSize = bufsize;
 	DString_Realloc( self, self->bufSize );
 }
+
+/*
+// Compute the hash value of the string in advance, so that the strings sharing
+// its buffer can reuse it. Only strings that are long enough for caching their
+// hash values are hashed in advance:
+*/
+void DString_CacheHash( DString *self, uint_t seed )
+{
+	if( self->size < DAO_STRING_HASHING || self->detached == 0 ) return;
+	self->hashed = 1;
+	DString_Hash( self, seed );
+}
+
 int DString_IsASCII( DString *self );
 void DString_ToLower( DString *self )
 {
@@ -364,7 +464,7 @@ void DString_Resize( DString *self, daoint size )
 void DString_Clear( DString *self )
 {
 	int share = self->sharing;
-	if( ((int*)self->chars - self->sharing) == dao_string ) return;
+	if( DString_Buffer( self ) == dao_string ) return;
 	DString_Detach( self, 0 );
 	DString_DeleteData( self );
 	DString_Init( self );
@@ -425,9 +525,12 @@ void DString_InsertChar( DString *self, const char ch, daoint at )
 }
 void DString_AppendBytes( DString *self, const char *chs, daoint n )
 {
-	daoint i;
+	/* The bytes may come from the string itself, whose buffer may be reallocated: */
+	daoint offset = chs - self->chars;
+	int inside = self->chars != NULL && offset >= 0 && offset <= self->size;
 	DString_Reserve( self, self->size + n );
-	memcpy( self->chars + self->size, chs, n * sizeof(char) );
+	if( inside ) chs = self->chars + offset;
+	memmove( self->chars + self->size, chs, n * sizeof(char) );
 	self->size += n;
 	self->chars[ self->size ] = 0;
 }
@@ -478,30 +581,163 @@ void DString_SubString( DString *self, DString *sub, daoint from, daoint n )
 	DString_Reset( sub, n );
 	memcpy( sub->chars, self->chars + from, n * sizeof(char) );
 }
-/* TODO: better string searching algorithm */
+/*
+// Needles shorter than DAO_STRING_TWOWAY are located by scanning for their
+// first (or last) byte with memchr() and verifying the candidates; longer
+// needles are searched with the Two-Way algorithm (Crochemore and Perrin),
+// which skips by a bad-character table and never backtracks in the haystack.
+*/
+#define DAO_STRING_TWOWAY  16
+
+static daoint DString_TwoWay( const uchar_t *h, daoint N, const uchar_t *n, daoint M )
+{
+	const uchar_t *z = h + N, *h0 = h;
+	daoint i, ip, jp, k, p, ms, p0, mem, mem0;
+	daoint shift[256];
+	uint_t byteset[256/32];
+
+	memset( byteset, 0, sizeof(byteset) );
+	for(i=0; i<M; ++i){
+		byteset[n[i]>>5] |= 1U << (n[i]&31);
+		shift[n[i]] = i + 1;
+	}
+
+	/* Maximal suffix for the critical factorization: */
+	ip = -1;  jp = 0;  k = p = 1;
+	while( jp + k < M ){
+		if( n[ip+k] == n[jp+k] ){
+			if( k == p ){
+				jp += p;
+				k = 1;
+			}else{
+				k += 1;
+			}
+		}else if( n[ip+k] > n[jp+k] ){
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		}else{
+			ip = jp++;
+			k = p = 1;
+		}
+	}
+	ms = ip;
+	p0 = p;
+
+	/* The same with the opposite ordering: */
+	ip = -1;  jp = 0;  k = p = 1;
+	while( jp + k < M ){
+		if( n[ip+k] == n[jp+k] ){
+			if( k == p ){
+				jp += p;
+				k = 1;
+			}else{
+				k += 1;
+			}
+		}else if( n[ip+k] < n[jp+k] ){
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		}else{
+			ip = jp++;
+			k = p = 1;
+		}
+	}
+	if( ip > ms ){
+		ms = ip;
+	}else{
+		p = p0;
+	}
+
+	if( memcmp( n, n + p, ms + 1 ) != 0 ){ /* Non-periodic needle: */
+		mem0 = 0;
+		p = (ms > M - ms - 1 ? ms : M - ms - 1) + 1;
+	}else{
+		mem0 = M - p;
+	}
+	mem = 0;
+
+	while( z - h >= M ){
+		/* Check the last byte of the window first: */
+		if( byteset[h[M-1]>>5] & (1U << (h[M-1]&31)) ){
+			k = M - shift[h[M-1]];
+			if( k ){
+				if( k < mem ) k = mem;
+				h += k;
+				mem = 0;
+				continue;
+			}
+		}else{
+			h += M;
+			mem = 0;
+			continue;
+		}
+		/* Compare the right half: */
+		for(k=(ms+1 > mem ? ms+1 : mem); k<M && n[k] == h[k]; ++k);
+		if( k < M ){
+			h += k - ms;
+			mem = 0;
+			continue;
+		}
+		/* Compare the left half: */
+		for(k=ms+1; k>mem && n[k-1] == h[k-1]; --k);
+		if( k <= mem ) return h - h0;
+		h += p;
+		mem = mem0;
+	}
+	return DAO_NULLPOS;
+}
 static daoint DMBString_Find( DString *self, daoint S, const char *chs, daoint M )
 {
-	daoint i, j;
+	const char *p, *end;
 
+	if( S < 0 ) S += self->size;
+	if( S < 0 ) S = 0;
 	if( M == 0 ) return DAO_NULLPOS;
 	if( M+S > self->size ) return DAO_NULLPOS;
-	for(i=S; i<self->size-M+1; i++){
-		int found = memcmp( self->chars + i, chs, M ) == 0;
-		if( found ) return i;
+	if( M >= DAO_STRING_TWOWAY ){
+		daoint pos = DString_TwoWay( (uchar_t*) self->chars + S, self->size - S, (uchar_t*) chs, M );
+		return pos == DAO_NULLPOS ? pos : S + pos;
+	}
+	p = self->chars + S;
+	end = self->chars + self->size - M + 1;
+	while( p < end ){
+		p = (const char*) memchr( p, chs[0], end - p );
+		if( p == NULL ) break;
+		if( memcmp( p + 1, chs + 1, M - 1 ) == 0 ) return p - self->chars;
+		p += 1;
 	}
 	return DAO_NULLPOS;
 }
+/*
+// Backward searching checks the last byte of the needle first;
+// for long needles, the window is shifted by a bad-character table
+// indexed by the first byte of the window (Horspool in reverse).
+*/
 static daoint DMBString_RFind( DString *self, daoint S, const char* chs, daoint M )
 {
-	daoint i, j;
+	const uchar_t *h = (const uchar_t*) self->chars;
+	const uchar_t *n = (const uchar_t*) chs;
+	daoint i;
 
 	if( S < 0 ) S += self->size;
 	if( M == 0 || self->size == 0 ) return DAO_NULLPOS;
 	if( S >= self->size ) S = self->size-1;
 	if( (S+1) < M || M > self->size ) return DAO_NULLPOS;
-	for( i=S; i>=M-1; i--){
-		int found = memcmp( self->chars + i - M + 1, chs, M ) == 0;
-		if( found ) return i;
+	if( M >= DAO_STRING_TWOWAY ){
+		daoint shift[256];
+		for(i=0; i<256; ++i) shift[i] = M;
+		for(i=M-1; i>0; --i) shift[n[i]] = i;
+		i = S - M + 1; /* Start of the window; */
+		while( i >= 0 ){
+			if( h[i+M-1] == n[M-1] && memcmp( h + i, n, M - 1 ) == 0 ) return i + M - 1;
+			i -= shift[h[i]];
+		}
+		return DAO_NULLPOS;
+	}
+	for(i=S; i>=M-1; i--){
+		if( h[i] != n[M-1] ) continue;
+		if( memcmp( h + i - M + 1, n, M - 1 ) == 0 ) return i;
 	}
 	return DAO_NULLPOS;
 }
@@ -521,6 +757,71 @@ daoint DString_RFind( DString *self, DString *chs, daoint start )
 {
 	return DMBString_RFind( self, start, chs->chars, chs->size );
 }
+/*
+// Find the first occurrence of any of the keys, the keys are bucketed
+// by their first bytes, so that each byte of the string is examined once
+// against a byte set, and only keys starting with that byte are compared.
+// For keys occurring at the same position, the one listed first is taken.
+*/
+daoint DString_FindAny( DString *self, DString **keys, int count, daoint start, int *which )
+{
+	uint_t byteset[256/32];
+	int heads[256];
+	int *next;
+	int i, firsts = 0, first = 0;
+	daoint pos, end, minlen = DAO_NULLPOS;
+
+	*which = -1;
+	if( start < 0 ) start += self->size;
+	if( start < 0 ) start = 0;
+	if( count == 1 ){
+		pos = DString_Find( self, keys[0], start );
+		if( pos != DAO_NULLPOS ) *which = 0;
+		return pos;
+	}
+
+	next = (int*) dao_malloc( count * sizeof(int) );
+	memset( byteset, 0, sizeof(byteset) );
+	for(i=0; i<256; ++i) heads[i] = -1;
+	for(i=count-1; i>=0; --i){
+		uchar_t ch;
+		if( keys[i]->size == 0 ) continue;
+		ch = keys[i]->chars[0];
+		if( heads[ch] < 0 ) firsts += 1;
+		if( keys[i]->size < minlen || minlen == DAO_NULLPOS ) minlen = keys[i]->size;
+		next[i] = heads[ch];
+		heads[ch] = i;
+		first = ch;
+		byteset[ch>>5] |= 1U << (ch&31);
+	}
+	pos = DAO_NULLPOS;
+	if( minlen == DAO_NULLPOS || start + minlen > self->size ) goto Done;
+
+	end = self->size - minlen + 1;
+	for(pos=start; pos<end; ++pos){
+		uchar_t ch = self->chars[pos];
+		if( firsts == 1 ){
+			const char *p = (const char*) memchr( self->chars + pos, first, end - pos );
+			if( p == NULL ) break;
+			pos = p - self->chars;
+			ch = first;
+		}else if( (byteset[ch>>5] & (1U << (ch&31))) == 0 ){
+			continue;
+		}
+		for(i=heads[ch]; i>=0; i=next[i]){
+			DString *key = keys[i];
+			if( pos + key->size > self->size ) continue;
+			if( memcmp( self->chars + pos + 1, key->chars + 1, key->size - 1 ) == 0 ){
+				*which = i;
+				goto Done;
+			}
+		}
+	}
+	pos = DAO_NULLPOS;
+Done:
+	dao_free( next );
+	return pos;
+}
 daoint DString_FindChar( DString *self, char ch, daoint start )
 {
 	daoint i;
@@ -552,40 +853,71 @@ DString* DString_DeepCopy( DString *self )
 	memcpy( copy->chars, self->chars, self->size *sizeof(char) );
 	return copy;
 }
+/* Called when self has just taken a share of the buffer of chs: */
+static void DString_ShareIndex( DString *self, DString *chs )
+{
+	DCharIndex *index;
+
+	if( chs->size < DAO_STRING_INDEXING ) return;
+#   ifdef DAO_WITH_THREAD
+	DMutex_Lock( & mutex_string_aux );
+#   endif
+	if( chs->aux == NULL ) chs->aux = DStringAux_New();
+	if( chs->aux->index == NULL ) chs->aux->index = DCharIndex_New();
+	index = chs->aux->index;
+	DAtomic_Add( & index->refs, 1 );
+#   ifdef DAO_WITH_THREAD
+	DMutex_Unlock( & mutex_string_aux );
+#   endif
+	if( self->aux == NULL ) self->aux = DStringAux_New();
+	self->aux->index = index;
+}
+/* Called when self has just taken a share of the buffer of chs: */
+static void DString_ShareHash( DString *self, DString *chs )
+{
+	if( chs->size < DAO_STRING_HASHING || chs->aux == NULL || chs->aux->hashed == 0 ) return;
+	if( self->aux == NULL ) self->aux = DStringAux_New();
+	self->aux->hash = chs->aux->hash;
+	self->aux->hashed = 1;
+}
 void DString_Assign( DString *self, DString *chs )
 {
-	int *data1 = (int*)self->chars - self->sharing;
-	int *data2 = (int*)chs->chars - chs->sharing;
+	int *data1 = DString_Buffer( self );
+	int *data2 = DString_Buffer( chs );
 	int assigned = 0;
 	if( self == chs ) return;
-	if( data1 == data2 ) return;
+	if( data1 == data2 && data2 != NULL ) return;
 
-	if( data2 != dao_string ){
-#ifdef DAO_WITH_THREAD
-		DMutex_Lock( & mutex_string_sharing );
-#endif
-		if( self->aux ) self->aux->size = 0;
+	if( data2 != NULL && data2 != dao_string ){
+		if( self->aux ) DStringAux_Reset( self->aux );
 		if( self->sharing && chs->sharing ){
-			if( data1 != dao_string ){
-				data1[0] -= 1;
-				if( data1[0] ==0 ) dao_free( data1 );
+			/* Acquire the new buffer before releasing the old one: */
+			DAtomic_Add( data2, 1 );
+			if( data1 != NULL && data1 != dao_string && DAtomic_Add( data1, -1 ) == 0 ){
+				dao_free( data1 );
 			}
-			memcpy( self, chs, sizeof(DString) - sizeof(DStringAux*) );
-			data2[0] += 1;
+			memcpy( self, chs, offsetof( DString, aux ) );
+			DString_ShareIndex( self, chs );
+			DString_ShareHash( self, chs );
 			assigned = 1;
-		}else if( data1 == NULL && chs->sharing ){
-			memcpy( self, chs, sizeof(DString) - sizeof(DStringAux*) );
-			data2[0] += 1;
+		}else if( self->chars == NULL && chs->sharing ){
+			DAtomic_Add( data2, 1 );
+			memcpy( self, chs, offsetof( DString, aux ) );
+			DString_ShareIndex( self, chs );
+			DString_ShareHash( self, chs );
 			assigned = 1;
 		}
-#ifdef DAO_WITH_THREAD
-		DMutex_Unlock( & mutex_string_sharing );
-#endif
 
 		if( assigned ) return;
 	}
 
-	if( self->chars == NULL ){
+	if( self->chars == NULL && chs->size < DAO_STRING_INLINE ){
+		self->chars = self->bytes;
+		self->size = chs->size;
+		self->bufSize = DAO_STRING_INLINE - 1;
+		memcpy( self->chars, chs->chars, chs->size*sizeof(char) );
+		self->chars[ self->size ] = 0;
+	}else if( self->chars == NULL ){
 		self->size = self->bufSize = chs->size;
 		self->chars = (char*) dao_malloc( (chs->size + 1)*sizeof(char) );
 		memcpy( self->chars, chs->chars, chs->size*sizeof(char) );
@@ -599,7 +931,7 @@ int DString_Compare( DString *self, DString *chs )
 {
 	daoint min = self->size > chs->size ? chs->size : self->size;
 	int cmp;
-	if( self->chars == chs->chars ) return 0;
+	if( self->chars == chs->chars && self->size == chs->size ) return 0;
 	cmp = memcmp( self->chars, chs->chars, min );
 	if( cmp != 0 || self->size == chs->size ) return cmp;
 	return self->size < chs->size ? -1 : 1;
@@ -650,7 +982,8 @@ static char empty_bytes[] = "";
 
 DString DString_WrapBytes( const char *bytes, int n )
 {
-	DString str = { NULL, 0, 0, 0, 0 };
+	DString str;
+	memset( & str, 0, sizeof(DString) );
 	str.chars = empty_bytes;
 	if( bytes == NULL ) return str;
 	str.chars = (char*) bytes;
@@ -742,6 +1075,41 @@ const char utf8_markers[128] =
 #define U8TrailGet(ch,shift)     (((uint_t)(ch) & 0x3F) << 6*shift)
 #define U8TrailMake(ch,shift)    ((((ch) >> 6*(shift)) & 0x3F) | (0x1 << 7))
 
+/*
+// ASCII bytes are scanned a machine word at a time: a word holds only ASCII
+// bytes if none of its bytes has the high bit set;
+*/
+#define U8WordMask  (((size_t)-1 / 0xFF) * 0x80)
+
+static daoint DString_SkipASCII( uchar_t *chs, uchar_t *end, daoint max )
+{
+	uchar_t *start = chs;
+	size_t word;
+
+	if( (end - chs) < max ) max = end - chs;
+	end = chs + max;
+	while( (chs + sizeof(size_t)) <= end ){
+		memcpy( & word, chs, sizeof(size_t) );
+		if( word & U8WordMask ) break;
+		chs += sizeof(size_t);
+	}
+	while( chs < end && *chs < 0x80 ) chs += 1;
+	return chs - start;
+}
+/* Width of a valid char, or one for an invalid byte: */
+static int DString_CharWidth( uchar_t *chs, uchar_t *end )
+{
+	uchar_t ch = *chs;
+
+	if( ch < 0x80 || (chs + U8CharSize(ch)) > end ) return 1;
+	switch( U8CodeType( ch ) ){
+	case 2 : return U8TrailCheck( chs[1] ) ? 2 : 1;
+	case 3 : return U8TrailCheck2( chs[1], chs[2] ) ? 3 : 1;
+	case 4 : return U8TrailCheck3( chs[1], chs[2], chs[3] ) ? 4 : 1;
+	}
+	return 1;
+}
+
 int DString_UTF8CharSize( uchar_t ch )
 {
 	return U8CharSize( ch );
@@ -848,38 +1216,67 @@ daoint DString_LocateChar( DString *self, daoint start, daoint count )
 }
 static void DString_UpdateAux( DString *self )
 {
-	if( self->aux != NULL && self->aux->size != 0 ) return;
+	if( self->aux != NULL && self->aux->index != NULL && self->aux->index->ready ) return;
 #   ifdef DAO_WITH_THREAD
-	DMutex_Lock( & mutex_string_sharing );
+	DMutex_Lock( & mutex_string_aux );
 #   endif
 	if( self->aux == NULL ) self->aux = DStringAux_New();
-	if( self->aux->size == 0 ) DStringAux_Update( self->aux, self );
+	if( self->aux->index == NULL ) self->aux->index = DCharIndex_New();
+	if( self->aux->index->ready == 0 ) DCharIndex_Build( self->aux->index, self );
 #   ifdef DAO_WITH_THREAD
-	DMutex_Unlock( & mutex_string_sharing );
+	DMutex_Unlock( & mutex_string_aux );
 #   endif
 }
 daoint DString_GetByteIndex( DString *self, daoint chindex )
 {
 	if( self->size == 0 ) return DAO_NULLPOS;
 	DString_UpdateAux( self );
-	return DStringAux_GetByteIndex( self->aux, self, chindex );
+	return DCharIndex_GetByteIndex( self->aux->index, self, chindex );
 }
 daoint DString_GetCharCount( DString *self )
 {
 	if( self->size == 0 ) return 0;
 	DString_UpdateAux( self );
-	return self->aux->chars;
+	return self->aux->index->chars;
+}
+/*
+// Hash values are cached only for longer strings that are hashed repeatedly,
+// so that hashing temporary strings and short strings does not pay for the
+// allocation of the auxiliary data. Wrapped strings (not detached) are never
+// cached. The cache is invalidated by detaching, which is required before
+// modifying a string in place.
+*/
+uint_t DString_Hash( DString *self, uint_t seed )
+{
+	unsigned long long hash;
+
+	if( self->aux == NULL ){
+		if( self->size < DAO_STRING_HASHING || self->detached == 0 || self->hashed == 0 ){
+			if( self->detached ) self->hashed = 1;
+			return Dao_Hash( self->chars, self->size, seed );
+		}
+	}
+	if( self->aux != NULL && self->aux->hashed ){
+		hash = self->aux->hash;
+		if( (hash >> 32) == seed ) return (uint_t) hash;
+	}
+	hash = Dao_Hash( self->chars, self->size, seed );
+#   ifdef DAO_WITH_THREAD
+	DMutex_Lock( & mutex_string_aux );
+#   endif
+	if( self->aux == NULL ) self->aux = DStringAux_New();
+	self->aux->hash = ((unsigned long long) seed << 32) | hash;
+	self->aux->hashed = 1; /* set after done, for thread safety; */
+#   ifdef DAO_WITH_THREAD
+	DMutex_Unlock( & mutex_string_aux );
+#   endif
+	return (uint_t) hash;
 }
 
 int DString_IsASCII( DString *self )
 {
-	daoint i, count = 0;
 	uchar_t *bytes = (uchar_t*) self->chars;
-	uchar_t *end = (uchar_t*) self->chars + self->size;
-	for(; bytes < end; ++bytes){
-		if( U8CodeType( *bytes ) != 0 ) return 0;
-	}
-	return 1;
+	return DString_SkipASCII( bytes, bytes + self->size, self->size ) == self->size;
 }
 
 /*
@@ -893,23 +1290,17 @@ int DString_CheckUTF8( DString *self )
 	daoint valid = 0, invalid = 0;
 
 	while( chs < end ){
-		uchar_t ch = *chs;
-		int len = U8CharSize( ch );
-		if( (chs + len) > end ) goto InvalidByte;
-		switch( U8CodeType( ch ) ){
-		case 0 : break;
-		case 1 : goto InvalidByte;
-		case 2 : if( U8TrailCheck( chs[1] ) ) break; goto InvalidByte;
-		case 3 : if( U8TrailCheck2( chs[1], chs[2] ) ) break; goto InvalidByte;
-		case 4 : if( U8TrailCheck3( chs[1], chs[2], chs[3] ) ) break; goto InvalidByte;
-		default: goto InvalidByte;
+		int len;
+		chs += DString_SkipASCII( chs, end, end - chs );
+		if( chs == end ) break;
+		len = DString_CharWidth( chs, end );
+		/* Do not count ASCII, as they are the same for all encodings; */
+		if( len > 1 ){
+			valid += 1;
+		}else{
+			invalid += 1;
 		}
-		valid += len > 1; /* Do not count ASCII, as they are the same for all encodings; */
 		chs += len;
-		continue;
-InvalidByte:
-		invalid += 1;
-		chs += 1;
 	}
 	return valid >= 10*invalid;
 }
@@ -972,7 +1363,7 @@ int DString_CompareUTF8( DString *self, DString *chs )
 	DCharState state1 = { 1, 1, 0 };
 	DCharState state2 = { 1, 1, 0 };
 
-	if( self->chars == chs->chars ) return 0;
+	if( self->chars == chs->chars && self->size == chs->size ) return 0;
 	for(i1=0,i2=0; i1<n1 && i2<n2; c1+=1, c2+=1, i1+=state1.width, i2+=state2.width){
 		state1 = DString_DecodeChar( chs1 + i1, chs1 + n1 );
 		state2 = DString_DecodeChar( chs2 + i2, chs2 + n2 );
@@ -1003,9 +1394,23 @@ int DString_DecodeUTF8( DString *self, DArray *wcs )
 
 	if( wcs->stride != sizeof(wchar_t) && wcs->stride != 4 ) return 0;
 
-	DArray_Reserve( wcs, self->size + 1 );
+	DArray_Reserve( wcs, wcs->size + self->size + 1 );
 	while( chs < end ){
-		DCharState state = DString_DecodeChar( chs, end );
+		DCharState state;
+		daoint i, skip = DString_SkipASCII( (uchar_t*) chs, (uchar_t*) end, end - chs );
+		if( skip ){ /* ASCII run, one code unit per byte: */
+			if( wcs->stride == 4 ){
+				uint_t *dest = wcs->data.uints + wcs->size;
+				for(i=0; i<skip; ++i) dest[i] = chs[i];
+			}else{
+				wchar_t *dest = wcs->data.wchars + wcs->size;
+				for(i=0; i<skip; ++i) dest[i] = chs[i];
+			}
+			wcs->size += skip;
+			chs += skip;
+			continue;
+		}
+		state = DString_DecodeChar( chs, end );
 		if( state.type == 0 ) goto InvalidByte;
 		chs += state.width;
         if( wcs->stride == 4 ){ /* UTF-32 */
@@ -35,6 +35,21 @@
 #define DAO_NULLPOS ((daoint)(-1))
 #define DAOINT_BITS CHAR_BIT*sizeof(daoint)
 
+/* Minimum string size for caching its hash value; */
+#define DAO_STRING_HASHING  16
+
+/* Minimum string size for sharing its char index along with its buffer; */
+#define DAO_STRING_INDEXING  1024
+
+/* Maximum size of string literals to be interned by the parser; */
+#define DAO_STRING_INTERN  64
+
+/* Maximum number of strings in the intern table of a VM space; */
+#define DAO_STRING_INTERN_LIMIT  (1<<16)
+
+/* Size of the inline buffer for short strings (including the terminating null); */
+#define DAO_STRING_INLINE  16
+
 typedef struct DCharState DCharState;
 typedef struct DStringAux DStringAux;
 
@@ -51,9 +66,11 @@ struct DString
 	char        *chars;
 	daoint       size     : DAOINT_BITS-1;
 	size_t       detached : 1;
-	daoint       bufSize  : DAOINT_BITS-1;
+	daoint       bufSize  : DAOINT_BITS-2;
 	size_t       sharing  : 1;
+	size_t       hashed   : 1;  /* hashed before (the hash is cached from the 2nd time); */
 	DStringAux  *aux;
+	char         bytes[DAO_STRING_INLINE];  /* inline buffer for short strings; */
 };
 
 DAO_DLL DString* DString_New();
@@ -63,6 +80,7 @@ DAO_DLL void DString_Delete( DString *self );
 DAO_DLL void DString_Detach( DString *self, daoint bufsize );
 
 DAO_DLL void DString_SetSharing( DString *self, int sharing );
+DAO_DLL void DString_MakeShareable( DString *self );
 
 DAO_DLL char* DString_GetData( DString *self );
 DAO_DLL void DString_SetChars( DString *self, const char *chs );
@@ -94,6 +112,7 @@ DAO_DLL daoint DString_Find( DString *self, DString *chs, daoint start );
 DAO_DLL daoint DString_RFind( DString *self, DString *chs, daoint start );
 DAO_DLL daoint DString_FindChars( DString *self, const char *ch, daoint start );
 DAO_DLL daoint DString_RFindChars( DString *self, const char *ch, daoint start );
+DAO_DLL daoint DString_FindAny( DString *self, DString **keys, int count, daoint start, int *which );
 DAO_DLL daoint DString_FindChar( DString *self, char ch, daoint start );
 DAO_DLL daoint DString_RFindChar( DString *self, char ch, daoint start );
 
@@ -121,6 +140,8 @@ DAO_DLL DCharState DString_DecodeChar( char *start, char *end );
 DAO_DLL daoint DString_LocateChar( DString *self, daoint start, daoint count );
 DAO_DLL daoint DString_GetByteIndex( DString *self, daoint chindex );
 DAO_DLL daoint DString_GetCharCount( DString *self );
+DAO_DLL uint_t DString_Hash( DString *self, uint_t seed );
+DAO_DLL void DString_CacheHash( DString *self, uint_t seed );
 DAO_DLL void DString_AppendWChar( DString *self, size_t ch );
 DAO_DLL void DString_Chop( DString *self, int utf8 );
 DAO_DLL void DString_Trim( DString *self, int head, int tail, int utf8 );
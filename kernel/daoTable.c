@@ -0,0 +1,828 @@
+/*
+// Dao Virtual Machine
+// http://daoscript.org
+//
+// Copyright (c) 2006-2017, Limin Fu
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED  BY THE COPYRIGHT HOLDERS AND  CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED  WARRANTIES,  INCLUDING,  BUT NOT LIMITED TO,  THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL  THE COPYRIGHT HOLDER OR CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,
+// INDIRECT,  INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSEQUENTIAL  DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO,  PROCUREMENT OF  SUBSTITUTE  GOODS OR  SERVICES;  LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY OF
+// LIABILITY,  WHETHER IN CONTRACT,  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include<string.h>
+#include"daoTable.h"
+#include"daoNumtype.h"
+#include"daoStream.h"
+#include"daoValue.h"
+#include"daoProcess.h"
+#include"daoNamespace.h"
+#include"daoClass.h"
+#include"daoObject.h"
+#include"daoVmspace.h"
+#include"daoGC.h"
+
+
+int DaoType_CheckNumberIndex( DaoType *self );
+daoint Dao_CheckNumberIndex( daoint index, daoint size, DaoProcess *proc );
+
+
+/* The class of the row objects, or NULL for tuple rows: */
+static DaoClass* DaoTable_RowClass( DaoType *rowType )
+{
+	if( rowType->tid != DAO_OBJECT ) return NULL;
+	return (DaoClass*) rowType->aux;
+}
+/*
+// Objects are stored in columns only for simple classes: classes without
+// parent or mixin classes, and with only public instance variables:
+*/
+static int DaoTable_CheckClass( DaoClass *klass )
+{
+	int attribs = DAO_CLS_PRIVATE_VAR | DAO_CLS_PROTECTED_VAR | DAO_CLS_ASYNCHRONOUS;
+	if( klass->parent != NULL || klass->allBases->size != 0 ) return 0;
+	if( klass->attribs & attribs ) return 0;
+	return klass->instvars->size > 1;
+}
+static int DaoTable_FieldCount( DaoType *rowType )
+{
+	DaoClass *klass = DaoTable_RowClass( rowType );
+	if( klass != NULL ) return klass->instvars->size - 1; /* skip "self"; */
+	return rowType->args->size;
+}
+static DaoType* DaoTable_FieldType( DaoType *rowType, int i )
+{
+	DaoClass *klass = DaoTable_RowClass( rowType );
+	DaoType *type;
+	if( klass != NULL ) return klass->instvars->items.pVar[i+1]->dtype;
+	type = rowType->args->items.pType[i];
+	if( type->tid == DAO_PAR_NAMED ) type = (DaoType*) type->aux;
+	return type;
+}
+static DaoValue* DaoTable_MakeColumn( DaoType *type, DaoNamespace *ns )
+{
+	DaoList *list;
+	if( type == NULL ) type = ns->vmSpace->typeAny;
+#ifdef DAO_WITH_NUMARRAY
+	if( type->tid >= DAO_BOOLEAN && type->tid <= DAO_COMPLEX ){
+		return (DaoValue*) DaoArray_New( type->tid );
+	}
+#endif
+	list = DaoList_New();
+	type = DaoNamespace_MakeType( ns, "list", DAO_LIST, NULL, & type, 1 );
+	GC_Assign( & list->ctype, type );
+	return (DaoValue*) list;
+}
+/* Create a new empty column of the same type and storage as "column": */
+static DaoValue* DaoTable_CloneColumn( DaoValue *column )
+{
+	DaoList *list;
+#ifdef DAO_WITH_NUMARRAY
+	if( column->type == DAO_ARRAY ){
+		DaoArray *array = DaoArray_New( column->xArray.etype );
+		DaoArray_SetStorage( array, column->xArray.stype );
+		return (DaoValue*) array;
+	}
+#endif
+	list = DaoList_New();
+	GC_Assign( & list->ctype, column->xList.ctype );
+	return (DaoValue*) list;
+}
+static daoint DaoTable_ColumnSize( DaoValue *column )
+{
+#ifdef DAO_WITH_NUMARRAY
+	if( column->type == DAO_ARRAY ) return column->xArray.size;
+#endif
+	return column->xList.value->size;
+}
+static void DaoTable_ResizeColumn( DaoValue *column, daoint size )
+{
+#ifdef DAO_WITH_NUMARRAY
+	if( column->type == DAO_ARRAY ){
+		DaoArray_ResizeVector( (DaoArray*) column, size );
+		return;
+	}
+#endif
+	DList_Resize( column->xList.value, size, NULL );
+}
+
+static DaoTable* DaoTable_Alloc( DaoType *type, DaoType *rowType )
+{
+	DaoTable *self = (DaoTable*) dao_calloc( 1, sizeof(DaoTable) );
+	DaoCstruct_Init( (DaoCstruct*) self, type );
+	self->rowType = rowType;
+	self->columns = DList_New( DAO_DATA_VALUE );
+	self->size = 0;
+	return self;
+}
+
+DaoTable* DaoTable_New( DaoType *type, DaoNamespace *ns )
+{
+	DaoTable *self;
+	DaoType *rowType = type->args->size ? type->args->items.pType[0] : NULL;
+	int i;
+
+	if( rowType == NULL ) return NULL;
+	if( rowType->tid == DAO_OBJECT ){
+		if( DaoTable_CheckClass( (DaoClass*) rowType->aux ) == 0 ) return NULL;
+	}else if( rowType->tid != DAO_TUPLE || rowType->variadic || rowType->args->size == 0 ){
+		return NULL;
+	}
+
+	self = DaoTable_Alloc( type, rowType );
+	for(i=0; i<DaoTable_FieldCount( rowType ); ++i){
+		DaoType *itype = DaoTable_FieldType( rowType, i );
+		DList_Append( self->columns, DaoTable_MakeColumn( itype, ns ) );
+	}
+	return self;
+}
+void DaoTable_Delete( DaoTable *self )
+{
+	DaoCstruct_Free( (DaoCstruct*) self );
+	DList_Delete( self->columns );
+	dao_free( self );
+}
+
+daoint DaoTable_Size( DaoTable *self )
+{
+	return self->size;
+}
+int DaoTable_FindColumn( DaoTable *self, DString *name )
+{
+	DaoClass *klass = DaoTable_RowClass( self->rowType );
+	DNode *node;
+	if( klass != NULL ){
+		node = DMap_Find( klass->lookupTable, name );
+		if( node == NULL || LOOKUP_ST( node->value.pInt ) != DAO_OBJECT_VARIABLE ) return -1;
+		return LOOKUP_ID( node->value.pInt ) - 1; /* -1 for "self"; */
+	}
+	if( self->rowType->mapNames == NULL ) return -1;
+	node = DMap_Find( self->rowType->mapNames, name );
+	if( node == NULL ) return -1;
+	return node->value.pInt;
+}
+
+/*
+// The columns are exposed to scripts and may be resized there,
+// check that they still have the same number of rows:
+*/
+static int DaoTable_Check( DaoTable *self, DaoProcess *proc )
+{
+	daoint i;
+	for(i=0; i<self->columns->size; ++i){
+		if( DaoTable_ColumnSize( self->columns->items.pValue[i] ) != self->size ){
+			if( proc ) DaoProcess_RaiseError( proc, NULL, "inconsistent table column sizes" );
+			return 0;
+		}
+	}
+	return 1;
+}
+static void DaoTable_Resize( DaoTable *self, daoint size )
+{
+	daoint i;
+	for(i=0; i<self->columns->size; ++i){
+		DaoTable_ResizeColumn( self->columns->items.pValue[i], size );
+	}
+	self->size = size;
+}
+
+/* Get the field values of a row tuple or a row object (or an object of a derived class): */
+static DaoValue** DaoTable_RowValues( DaoTable *self, DaoValue *row )
+{
+	DaoClass *klass = DaoTable_RowClass( self->rowType );
+
+	if( klass == NULL ){
+		if( row->type != DAO_TUPLE || row->xTuple.size < self->columns->size ) return NULL;
+		return row->xTuple.values;
+	}
+	if( row->type != DAO_OBJECT ) return NULL;
+	row = DaoObject_CastToBase( (DaoObject*) row, klass->objType );
+	if( row == NULL ) return NULL;
+	return row->xObject.objValues + 1; /* skip "self"; */
+}
+/*
+// All the fields are checked before any column is updated,
+// so that an invalid row leaves the table unchanged:
+*/
+int DaoTable_SetRow( DaoTable *self, DaoValue *row, daoint index )
+{
+	DaoValue **columns = self->columns->items.pValue;
+	DaoValue **values = DaoTable_RowValues( self, row );
+	daoint i, N = self->columns->size;
+
+	if( values == NULL ) return 0;
+	for(i=0; i<N; ++i){
+		DaoValue *value = values[i];
+		if( value == NULL ) return 0;
+#ifdef DAO_WITH_NUMARRAY
+		if( columns[i]->type == DAO_ARRAY ){
+			/* Numbers may be widened to the element type, but not narrowed: */
+			int etype = columns[i]->xArray.etype;
+			if( value->type < DAO_BOOLEAN || value->type > etype ) return 0;
+			continue;
+		}
+#endif
+		if( DaoType_MatchValue( columns[i]->xList.ctype->args->items.pType[0], value, NULL ) == 0 ){
+			return 0;
+		}
+	}
+	for(i=0; i<N; ++i){
+#ifdef DAO_WITH_NUMARRAY
+		if( columns[i]->type == DAO_ARRAY ){
+			DaoArray_SetValue( (DaoArray*) columns[i], index, values[i] );
+			continue;
+		}
+#endif
+		DaoList_SetItem( (DaoList*) columns[i], values[i], index );
+	}
+	return 1;
+}
+int DaoTable_AppendRow( DaoTable *self, DaoValue *row )
+{
+	daoint size = self->size;
+	DaoTable_Resize( self, size + 1 );
+	if( DaoTable_SetRow( self, row, size ) ) return 1;
+	DaoTable_Resize( self, size );
+	return 0;
+}
+static void DaoTable_SetField( DaoTable *self, DaoValue *row, DaoValue *value, int i )
+{
+	DaoClass *klass = DaoTable_RowClass( self->rowType );
+	if( klass != NULL ){
+		DaoType *type = klass->instvars->items.pVar[i+1]->dtype;
+		DaoValue_Move( value, row->xObject.objValues + i + 1, type );
+		return;
+	}
+	DaoTuple_SetItem( (DaoTuple*) row, value, i );
+}
+DaoValue* DaoTable_GetRow( DaoTable *self, daoint index )
+{
+	DaoValue **columns = self->columns->items.pValue;
+	DaoClass *klass = DaoTable_RowClass( self->rowType );
+	DaoValue *row;
+	daoint i;
+
+	if( klass != NULL ){
+		row = (DaoValue*) DaoObject_New( klass );
+	}else{
+		row = (DaoValue*) DaoTuple_Create( self->rowType, self->rowType->args->size, 1 );
+	}
+	for(i=0; i<self->columns->size; ++i){
+#ifdef DAO_WITH_NUMARRAY
+		if( columns[i]->type == DAO_ARRAY ){
+			DaoValue item = {DAO_COMPLEX};
+			DaoArray_GetValue( (DaoArray*) columns[i], index, & item );
+			DaoTable_SetField( self, row, & item, i );
+			continue;
+		}
+#endif
+		DaoTable_SetField( self, row, columns[i]->xList.value->items.pValue[index], i );
+	}
+	return row;
+}
+
+
+static int DaoTable_CompareRows( DaoValue *column, daoint i, daoint j )
+{
+#ifdef DAO_WITH_NUMARRAY
+	if( column->type == DAO_ARRAY ){
+		DaoArray *array = (DaoArray*) column;
+		dao_complex a, b;
+		dao_integer x, y;
+		switch( array->etype ){
+		case DAO_BOOLEAN :
+		case DAO_INTEGER :
+			x = DaoArray_GetInteger( array, i );
+			y = DaoArray_GetInteger( array, j );
+			return x < y ? -1 : (x > y);
+		case DAO_FLOAT :
+			a.real = DaoArray_GetFloat( array, i );
+			b.real = DaoArray_GetFloat( array, j );
+			return a.real < b.real ? -1 : (a.real > b.real);
+		case DAO_COMPLEX :
+			a = DaoArray_GetComplex( array, i );
+			b = DaoArray_GetComplex( array, j );
+			if( a.real != b.real ) return a.real < b.real ? -1 : 1;
+			return a.imag < b.imag ? -1 : (a.imag > b.imag);
+		}
+		return 0;
+	}
+#endif
+	return DaoValue_Compare( column->xList.value->items.pValue[i], column->xList.value->items.pValue[j] );
+}
+
+/* Stable bottom-up merge sort of row indices by the values in "column": */
+static void DaoTable_SortRows( DaoValue *column, daoint *rows, daoint count, int descend )
+{
+	daoint *buffer = (daoint*) dao_malloc( count * sizeof(daoint) );
+	daoint *source = rows, *target = buffer, *swap;
+	daoint width, start, i, j, k, mid, end;
+
+	for(width=1; width<count; width*=2){
+		for(start=0; start<count; start+=2*width){
+			mid = start + width < count ? start + width : count;
+			end = start + 2*width < count ? start + 2*width : count;
+			i = start;
+			j = mid;
+			for(k=start; k<end; ++k){
+				int cmp = 0;
+				if( i < mid && j < end ){
+					cmp = DaoTable_CompareRows( column, source[i], source[j] );
+					if( descend ) cmp = - cmp;
+				}
+				if( j >= end || (i < mid && cmp <= 0) ){
+					target[k] = source[i++];
+				}else{
+					target[k] = source[j++];
+				}
+			}
+		}
+		swap = source;
+		source = target;
+		target = swap;
+	}
+	if( source != rows ) memcpy( rows, source, count * sizeof(daoint) );
+	dao_free( buffer );
+}
+
+/* Fill "target" with the values of "source" at the rows "rows": */
+static void DaoTable_GatherColumn( DaoValue *target, DaoValue *source, daoint *rows, daoint count )
+{
+	daoint i;
+#ifdef DAO_WITH_NUMARRAY
+	if( source->type == DAO_ARRAY ){
+		DaoValue item = {DAO_COMPLEX};
+		for(i=0; i<count; ++i){
+			DaoArray_GetValue( (DaoArray*) source, rows[i], & item );
+			DaoArray_SetValue( (DaoArray*) target, i, & item );
+		}
+		return;
+	}
+#endif
+	for(i=0; i<count; ++i){
+		DaoValue *item = source->xList.value->items.pValue[rows[i]];
+		GC_Assign( target->xList.value->items.pValue + i, item );
+	}
+}
+
+void DaoTable_Sort( DaoTable *self, int column, int descend )
+{
+	daoint i, j, *rows, *order;
+
+	if( self->size <= 1 ) return;
+
+	rows = (daoint*) dao_malloc( 2 * self->size * sizeof(daoint) );
+	order = rows + self->size;
+	for(i=0; i<self->size; ++i) rows[i] = order[i] = i;
+	DaoTable_SortRows( self->columns->items.pValue[column], order, self->size, descend );
+
+	/* Permute in place, since the columns may be referenced elsewhere: */
+	for(j=0; j<self->columns->size; ++j){
+		DaoValue *col = self->columns->items.pValue[j];
+		DaoValue *copy = DaoTable_CloneColumn( col );
+		GC_IncRC( copy );
+		DaoTable_ResizeColumn( copy, self->size );
+		DaoTable_GatherColumn( copy, col, rows, self->size );
+		DaoTable_GatherColumn( col, copy, order, self->size );
+		GC_DecRC( copy );
+	}
+	dao_free( rows );
+}
+DaoTable* DaoTable_Take( DaoTable *self, daoint *rows, daoint count )
+{
+	DaoTable *table = DaoTable_Alloc( self->ctype, self->rowType );
+	daoint i;
+
+	for(i=0; i<self->columns->size; ++i){
+		DaoValue *column = self->columns->items.pValue[i];
+		DaoValue *copy = DaoTable_CloneColumn( column );
+		DaoTable_ResizeColumn( copy, count );
+		DaoTable_GatherColumn( copy, column, rows, count );
+		DList_Append( table->columns, copy );
+	}
+	table->size = count;
+	return table;
+}
+
+
+
+static void TABLE_PutRow( DaoProcess *proc, DaoTable *self, daoint index )
+{
+	DaoValue *row = DaoTable_GetRow( self, index );
+	GC_IncRC( row );
+	DaoProcess_PutValue( proc, row );
+	GC_DecRC( row );
+}
+static int TABLE_GetColumn( DaoProcess *proc, DaoTable *self, DString *field )
+{
+	int column = DaoTable_FindColumn( self, field );
+	if( column < 0 ) DaoProcess_RaiseError( proc, "Field::NotExist", field->chars );
+	return column;
+}
+static void TABLE_PutTake( DaoProcess *proc, DaoTable *self, daoint *rows, daoint count )
+{
+	DaoTable *table = DaoTable_Take( self, rows, count );
+	DaoProcess_PutValue( proc, (DaoValue*) table );
+}
+
+static void TABLE_New( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoType *retype = DaoProcess_GetReturnType( proc );
+	DaoTable *self = DaoTable_New( retype, proc->activeNamespace );
+	DList *rows;
+	daoint i;
+
+	if( self == NULL ){
+		DaoProcess_RaiseError( proc, "Param", "table rows must be of a non-variadic tuple type or a simple class type" );
+		return;
+	}
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+	if( N == 0 ) return;
+
+	rows = p[0]->xList.value;
+	DaoTable_Resize( self, rows->size );
+	for(i=0; i<rows->size; ++i){
+		DaoValue *row = rows->items.pValue[i];
+		if( DaoTable_SetRow( self, row, i ) == 0 ){
+			DaoTable_Resize( self, 0 );
+			DaoProcess_RaiseError( proc, "Value", "invalid row" );
+			return;
+		}
+	}
+}
+static void TABLE_Size( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	DaoProcess_PutInteger( proc, DaoTable_Size( self ) );
+}
+static void TABLE_Append( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+	if( DaoTable_Check( self, proc ) == 0 ) return;
+	if( DaoTable_AppendRow( self, p[1] ) == 0 ){
+		DaoProcess_RaiseError( proc, "Value", "invalid row" );
+	}
+}
+/* Put the column, after checking that it has the requested storage and type: */
+static void TABLE_PutColumn( DaoProcess *proc, DaoTable *self, daoint column, DaoType *type, int array )
+{
+	DaoValue *values;
+	int matched = 0;
+
+	if( column < 0 ) return;
+	values = self->columns->items.pValue[column];
+	if( values->type == DAO_LIST ){
+		DaoType *itype = values->xList.ctype->args->items.pType[0];
+		matched = array == 0 && DaoType_MatchTo( itype, type, NULL ) >= DAO_MT_EQ;
+	}
+#ifdef DAO_WITH_NUMARRAY
+	if( values->type == DAO_ARRAY ) matched = array && values->xArray.etype == type->tid;
+#endif
+	if( matched == 0 ){
+		DaoProcess_RaiseError( proc, "Param", "unmatched column type" );
+		return;
+	}
+	DaoProcess_PutValue( proc, values );
+}
+#ifdef DAO_WITH_NUMARRAY
+static void TABLE_ArrayColumn( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	int column = TABLE_GetColumn( proc, self, p[1]->xString.value );
+	TABLE_PutColumn( proc, self, column, (DaoType*) p[2], 1 );
+}
+static void TABLE_ArrayColumn2( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	daoint column = Dao_CheckNumberIndex( p[1]->xInteger.value, self->columns->size, proc );
+	TABLE_PutColumn( proc, self, column, (DaoType*) p[2], 1 );
+}
+#endif
+static void TABLE_ListColumn( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	int column = TABLE_GetColumn( proc, self, p[1]->xString.value );
+	TABLE_PutColumn( proc, self, column, (DaoType*) p[2], 0 );
+}
+static void TABLE_ListColumn2( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	daoint column = Dao_CheckNumberIndex( p[1]->xInteger.value, self->columns->size, proc );
+	TABLE_PutColumn( proc, self, column, (DaoType*) p[2], 0 );
+}
+static void TABLE_Sort( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	int column = TABLE_GetColumn( proc, self, p[1]->xString.value );
+	DaoProcess_PutValue( proc, (DaoValue*) self );
+	if( column < 0 || DaoTable_Check( self, proc ) == 0 ) return;
+	DaoTable_Sort( self, column, p[2]->xEnum.value == 1 );
+}
+static void TABLE_Select( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	int column = TABLE_GetColumn( proc, self, p[1]->xString.value );
+	dao_float min = p[2]->xFloat.value;
+	dao_float max = p[3]->xFloat.value;
+	DaoValue *values;
+	daoint i, count = 0, *rows;
+
+	if( column < 0 || DaoTable_Check( self, proc ) == 0 ) return;
+
+	values = self->columns->items.pValue[column];
+	rows = (daoint*) dao_malloc( (self->size + 1) * sizeof(daoint) );
+	for(i=0; i<self->size; ++i){
+		dao_float value;
+#ifdef DAO_WITH_NUMARRAY
+		if( values->type == DAO_ARRAY ){
+			value = DaoArray_GetFloat( (DaoArray*) values, i );
+			if( value >= min && value <= max ) rows[count++] = i;
+			continue;
+		}
+#endif
+		if( values->xList.value->items.pValue[i]->type > DAO_FLOAT ){
+			DaoProcess_RaiseError( proc, "Param", "the field is not numeric" );
+			dao_free( rows );
+			return;
+		}
+		value = DaoValue_GetFloat( values->xList.value->items.pValue[i] );
+		if( value >= min && value <= max ) rows[count++] = i;
+	}
+	TABLE_PutTake( proc, self, rows, count );
+	dao_free( rows );
+}
+static void TABLE_Select2( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	int column = TABLE_GetColumn( proc, self, p[1]->xString.value );
+	DaoValue *values, *value = p[2];
+	daoint i, count = 0, *rows;
+
+	if( column < 0 || DaoTable_Check( self, proc ) == 0 ) return;
+
+	values = self->columns->items.pValue[column];
+	rows = (daoint*) dao_malloc( (self->size + 1) * sizeof(daoint) );
+	for(i=0; i<self->size; ++i){
+#ifdef DAO_WITH_NUMARRAY
+		if( values->type == DAO_ARRAY ){
+			DaoValue item = {DAO_COMPLEX};
+			DaoArray_GetValue( (DaoArray*) values, i, & item );
+			if( DaoValue_Compare( & item, value ) == 0 ) rows[count++] = i;
+			continue;
+		}
+#endif
+		if( DaoValue_Compare( values->xList.value->items.pValue[i], value ) == 0 ){
+			rows[count++] = i;
+		}
+	}
+	TABLE_PutTake( proc, self, rows, count );
+	dao_free( rows );
+}
+static void TABLE_Rows( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoTable *self = (DaoTable*) p[0];
+	DaoList *list = DaoProcess_PutList( proc );
+	daoint i;
+
+	if( DaoTable_Check( self, proc ) == 0 ) return;
+	for(i=0; i<self->size; ++i){
+		DaoValue *row = DaoTable_GetRow( self, i );
+		GC_IncRC( row );
+		DaoList_Append( list, row );
+		GC_DecRC( row );
+	}
+}
+
+static DaoFunctionEntry daoTableMeths[] =
+{
+	{ TABLE_New,
+		"Table<@T>()"
+		/*
+		// Create an empty table with rows of type "@T", which must be a tuple type
+		// or a simple class type (without base classes and non-public fields);
+		*/
+	},
+	{ TABLE_New,
+		"Table<@T>( rows: list<@T> )"
+		/*
+		// Create a table from a list of tuples or objects;
+		*/
+	},
+	{ TABLE_Size,
+		"size( invar self: Table<@T> ) => int"
+		/*
+		// Return the number of rows;
+		*/
+	},
+	{ TABLE_Append,
+		"append( self: Table<@T>, row: @T ) => Table<@T>"
+		/*
+		// Append "row" to the end of the table;
+		// Return the table itself;
+		*/
+	},
+#ifdef DAO_WITH_NUMARRAY
+	{ TABLE_ArrayColumn,
+		"arrayColumn( self: Table<@T>, field: string, type: type<@N<bool|int|float|complex>> )"
+			" => array<@N>"
+		/*
+		// Return the column of the bool, int, float or complex field named "field";
+		// The column is not copied, so that in-place vectorized operations
+		// on it update the table; "type" must be the type of the field;
+		*/
+	},
+	{ TABLE_ArrayColumn2,
+		"arrayColumn( self: Table<@T>, field: int, type: type<@N<bool|int|float|complex>> )"
+			" => array<@N>"
+		/*
+		// Return the column of the numeric field at position "field";
+		*/
+	},
+#endif
+	{ TABLE_ListColumn,
+		"listColumn( self: Table<@T>, field: string, type: type<@V> ) => list<@V>"
+		/*
+		// Return the column of the field named "field" that is stored in a list:
+		// fields of the other types, and also of the numeric types when numeric
+		// arrays are disabled; "type" must be the type of the field;
+		*/
+	},
+	{ TABLE_ListColumn2,
+		"listColumn( self: Table<@T>, field: int, type: type<@V> ) => list<@V>"
+		/*
+		// Return the list column of the field at position "field";
+		*/
+	},
+	{ TABLE_Sort,
+		"sort( self: Table<@T>, field: string, order: enum<ascend,descend> = $ascend ) => Table<@T>"
+		/*
+		// Sort the rows stably by the values of field "field";
+		// Return the table itself;
+		*/
+	},
+	{ TABLE_Select,
+		"select( invar self: Table<@T>, field: string, min: float, max: float ) => Table<@T>"
+		/*
+		// Return a new table with the rows whose numeric field "field"
+		// is between "min" and "max" (inclusive);
+		*/
+	},
+	{ TABLE_Select2,
+		"select( invar self: Table<@T>, field: string, value: any ) => Table<@T>"
+		/*
+		// Return a new table with the rows whose field "field" equals to "value";
+		*/
+	},
+	{ TABLE_Rows,
+		"rows( invar self: Table<@T> ) => list<@T>"
+		/*
+		// Return the rows as a list of tuples or objects;
+		*/
+	},
+	{ NULL, NULL }
+};
+
+
+static DaoType* DaoTable_CheckGetItem( DaoType *self, DaoType *index[], int N, DaoRoutine *ctx )
+{
+	DaoType *rowType = self->args->size ? self->args->items.pType[0] : NULL;
+
+	if( rowType == NULL || N != 1 ) return NULL;
+	if( index[0]->tid == DAO_TUPLE && index[0]->subtid == DAO_ITERATOR ){
+		if( DaoType_CheckNumberIndex( index[0]->args->items.pType[1] ) ) return rowType;
+	}else if( DaoType_CheckNumberIndex( index[0] ) ){
+		return rowType;
+	}
+	return NULL;
+}
+static DaoValue* DaoTable_DoGetItem( DaoValue *self, DaoValue *index[], int N, DaoProcess *proc )
+{
+	DaoTable *table = (DaoTable*) self;
+	daoint pos, size = table->size;
+
+	if( N != 1 || DaoTable_Check( table, proc ) == 0 ) return NULL;
+	switch( index[0]->xBase.subtype ){
+	case DAO_BOOLEAN :
+	case DAO_INTEGER :
+	case DAO_FLOAT :
+		pos = Dao_CheckNumberIndex( DaoValue_GetInteger( index[0] ), size, proc );
+		if( pos < 0 ) return NULL;
+		TABLE_PutRow( proc, table, pos );
+		break;
+	case DAO_ITERATOR :
+		if( index[0]->xTuple.values[1]->type != DAO_INTEGER ) return NULL;
+		pos = Dao_CheckNumberIndex( index[0]->xTuple.values[1]->xInteger.value, size, proc );
+		index[0]->xTuple.values[0]->xBoolean.value = (pos + 1) < size;
+		index[0]->xTuple.values[1]->xInteger.value = pos + 1;
+		if( pos < 0 ) return NULL;
+		TABLE_PutRow( proc, table, pos );
+		break;
+	}
+	return NULL;
+}
+static int DaoTable_CheckSetItem( DaoType *self, DaoType *index[], int N, DaoType *value, DaoRoutine *ctx )
+{
+	DaoType *rowType = self->args->size ? self->args->items.pType[0] : NULL;
+
+	if( rowType == NULL || DaoType_MatchTo( value, rowType, NULL ) == 0 ) return DAO_ERROR_VALUE;
+	if( N != 1 || DaoType_CheckNumberIndex( index[0] ) == 0 ) return DAO_ERROR_INDEX;
+	return DAO_OK;
+}
+static int DaoTable_DoSetItem( DaoValue *self, DaoValue *index[], int N, DaoValue *value, DaoProcess *proc )
+{
+	DaoTable *table = (DaoTable*) self;
+	daoint pos;
+
+	if( N != 1 || index[0]->type < DAO_BOOLEAN || index[0]->type > DAO_FLOAT ) return DAO_ERROR_INDEX;
+	if( DaoTable_Check( table, proc ) == 0 ) return DAO_OK;
+	pos = Dao_CheckNumberIndex( DaoValue_GetInteger( index[0] ), table->size, proc );
+	if( pos < 0 ) return DAO_ERROR_INDEX;
+	if( DaoTable_SetRow( table, value, pos ) == 0 ) return DAO_ERROR_VALUE;
+	return DAO_OK;
+}
+static DaoType* DaoTable_CheckForEach( DaoType *self, DaoRoutine *ctx )
+{
+	return ctx->nameSpace->vmSpace->typeIteratorInt;
+}
+static int DaoTable_DoForEach( DaoValue *self, DaoTuple *iterator, DaoProcess *proc )
+{
+	iterator->values[0]->xBoolean.value = ((DaoTable*)self)->size > 0;
+	iterator->values[1]->xInteger.value = 0;
+	return DAO_OK;
+}
+static void DaoTable_Print( DaoValue *self, DaoStream *stream, DMap *cycmap, DaoProcess *proc )
+{
+	DaoTable *table = (DaoTable*) self;
+	daoint i;
+
+	if( DaoTable_Check( table, NULL ) == 0 ){
+		DaoStream_WriteString( stream, table->ctype->name );
+		DaoStream_WriteChars( stream, "[inconsistent]" );
+		return;
+	}
+	DaoStream_PrintHL( stream, '{', "{ " );
+	for(i=0; i<table->size; ++i){
+		DaoValue *row = DaoTable_GetRow( table, i );
+		GC_IncRC( row );
+		DaoValue_Print( row, stream, cycmap, proc );
+		GC_DecRC( row );
+		if( (stream->mode & DAO_STREAM_DEBUGGING) && i >= 19 ) break;
+		if( (i+1) < table->size ) DaoStream_PrintHL( stream, ',', ", " );
+	}
+	if( i < table->size ){
+		DaoStream_PrintHL( stream, ',', ", " );
+		DaoStream_PrintHL( stream, ',', "...(" );
+		DaoStream_TryHighlight( stream, ',' );
+		DaoStream_WriteInt( stream, table->size - 1 - i );
+		DaoStream_WriteChars( stream, " rows truncated)" );
+	}
+	DaoStream_PrintHL( stream, '}', " }" );
+}
+static void DaoTable_HandleGC( DaoValue *p, DList *values, DList *lists, DList *maps, int remove )
+{
+	DaoTable *self = (DaoTable*) p;
+	DList_Append( lists, self->columns );
+}
+
+DaoTypeCore daoTableCore =
+{
+	"Table<@T>",                                       /* name */
+	sizeof(DaoTable),                                  /* size */
+	{ NULL },                                          /* bases */
+	{ NULL },                                          /* casts */
+	NULL,                                              /* numbers */
+	daoTableMeths,                                     /* methods */
+	DaoCstruct_CheckGetField,  DaoCstruct_DoGetField,  /* GetField */
+	NULL,                      NULL,                   /* SetField */
+	DaoTable_CheckGetItem,     DaoTable_DoGetItem,     /* GetItem */
+	DaoTable_CheckSetItem,     DaoTable_DoSetItem,     /* SetItem */
+	NULL,                      NULL,                   /* Unary */
+	NULL,                      NULL,                   /* Binary */
+	NULL,                      NULL,                   /* Conversion */
+	DaoTable_CheckForEach,     DaoTable_DoForEach,     /* ForEach */
+	DaoTable_Print,                                    /* Print */
+	NULL,                                              /* Slice */
+	NULL,                                              /* Compare */
+	NULL,                                              /* Hash */
+	NULL,                                              /* Create */
+	NULL,                                              /* Copy */
+	(DaoDeleteFunction) DaoTable_Delete,               /* Delete */
+	DaoTable_HandleGC                                  /* HandleGC */
+};
@@ -0,0 +1,70 @@
+/*
+// Dao Virtual Machine
+// http://daoscript.org
+//
+// Copyright (c) 2006-2017, Limin Fu
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED  BY THE COPYRIGHT HOLDERS AND  CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED  WARRANTIES,  INCLUDING,  BUT NOT LIMITED TO,  THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL  THE COPYRIGHT HOLDER OR CONTRIBUTORS  BE LIABLE FOR ANY DIRECT,
+// INDIRECT,  INCIDENTAL, SPECIAL,  EXEMPLARY,  OR CONSEQUENTIAL  DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO,  PROCUREMENT OF  SUBSTITUTE  GOODS OR  SERVICES;  LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY OF
+// LIABILITY,  WHETHER IN CONTRACT,  STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+// OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef DAO_TABLE_H
+#define DAO_TABLE_H
+
+#include"daoType.h"
+
+
+/*
+// Columnar table of tuple or object rows:
+// The table of type Table<tuple<...>> stores each field of the row tuples in
+// a separate column. Fields of bool, int, float and complex types are stored
+// in numeric arrays (when numeric arrays are enabled), other fields are stored
+// in lists. Row tuples are created only when they are accessed.
+//
+// The table of type Table<SomeClass> stores the instance variables of the
+// objects of a simple class (without base classes and non-public variables)
+// in the same way, and creates row objects when they are accessed.
+//
+// The columns are ordinary arrays and lists, and can be retrieved with their
+// types and used for vectorized operations directly. Operations on the table
+// check that all the columns still have the same number of rows.
+*/
+struct DaoTable
+{
+	DAO_CSTRUCT_COMMON;
+
+	DaoType  *rowType;  /* row tuple or object type; */
+	DList    *columns;  /* DaoArray or DaoList values, one for each field; */
+	daoint    size;     /* number of rows; */
+};
+
+DAO_DLL DaoTable* DaoTable_New( DaoType *type, DaoNamespace *ns );
+DAO_DLL void DaoTable_Delete( DaoTable *self );
+
+DAO_DLL daoint DaoTable_Size( DaoTable *self );
+DAO_DLL int DaoTable_FindColumn( DaoTable *self, DString *name );
+DAO_DLL int DaoTable_AppendRow( DaoTable *self, DaoValue *row );
+DAO_DLL int DaoTable_SetRow( DaoTable *self, DaoValue *row, daoint index );
+DAO_DLL DaoValue* DaoTable_GetRow( DaoTable *self, daoint index );
+DAO_DLL void DaoTable_Sort( DaoTable *self, int column, int descend );
+DAO_DLL DaoTable* DaoTable_Take( DaoTable *self, daoint *rows, daoint count );
+
+#endif
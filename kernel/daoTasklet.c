@@ -42,7 +42,17 @@
 #include"daoGC.h"
 #include"daoTasklet.h"
 
+#ifdef UNIX
+#include<poll.h>
+#include<fcntl.h>
+#include<unistd.h>
+#endif
+#ifdef LINUX
+#include<sys/epoll.h>
+#endif
+
 #define MIN_TIME  1E-27
+#define IO_EVENTS 64
 
 
 enum DaoTaskletEventType
@@ -51,7 +61,8 @@ enum DaoTaskletEventType
 	DAO_EVENT_WAIT_TASKLET   ,  /* Wait for another tasklet; */
 	DAO_EVENT_WAIT_RECEIVING ,  /* Wait for receiving from a channel; */
 	DAO_EVENT_WAIT_SENDING   ,  /* Wait after sending to a channel; */
-	DAO_EVENT_WAIT_SELECT       /* Wait for multiple futures or channels; */
+	DAO_EVENT_WAIT_SELECT    ,  /* Wait for multiple futures or channels; */
+	DAO_EVENT_WAIT_IO           /* Wait for a file descriptor; */
 };
 enum DaoTaskletEventState
 {
@@ -101,6 +112,13 @@ typedef struct DaoTaskletEvent   DaoTaskletEvent;
 //        channel = NULL;
 //        channels = select list of channels;
 //    };
+// 6. Waiting for a file descriptor becoming ready for reading or writing:
+//    DaoTaskletEvent {
+//        type = DAO_EVENT_WAIT_IO;
+//        future = future value for the waiting tasklet;
+//        channel = NULL;
+//        handle = file descriptor registered to the I/O reactor;
+//    };
 //
 */
 struct DaoTaskletEvent
@@ -109,6 +127,8 @@ struct DaoTaskletEvent
 	uchar_t      state;
 	uchar_t      timeout;
 	uchar_t      auxiliary;
+	uchar_t      writing;   /* waiting for writing instead of reading; */
+	int          handle;    /* file descriptor for I/O waiting; */
 	double       expiring;  /* expiring time for a timeout event; */
 	DaoFuture   *future;
 	DaoChannel  *channel;
@@ -127,6 +147,7 @@ DaoTaskletEvent* DaoTaskletEvent_New( DaoVmSpace *vmspace )
 {
 	DaoTaskletEvent *self = (DaoTaskletEvent*) dao_calloc( 1, sizeof(DaoTaskletEvent) );
 	self->vmspace = vmspace;
+	self->handle = -1;
 	return self;
 }
 void DaoTaskletEvent_Reset( DaoTaskletEvent *self )
@@ -135,6 +156,8 @@ void DaoTaskletEvent_Reset( DaoTaskletEvent *self )
 	self->state = 0;
 	self->timeout = 0;
 	self->auxiliary = 0;
+	self->writing = 0;
+	self->handle = -1;
 	self->expiring = -1.0;
 	GC_DecRC( self->future );
 	GC_DecRC( self->channel );
@@ -206,12 +229,14 @@ static void DaoTaskletThread_Run( DaoTaskletThread *self );
 struct DaoTaskletServer
 {
 	DThread  timer;
+	DThread  reactor;  /* I/O reactor, started by the first I/O waiting; */
 	DMutex   mutex;
 	DCondVar condv;
 	DCondVar condv2;
 
 	volatile int finishing;
 	volatile int timing;
+	volatile int reacting;
 	volatile int total;
 	volatile int vacant;  /* Not used; */
 	volatile int idle;    /* Not active; */
@@ -225,6 +250,7 @@ struct DaoTaskletServer
 	DList  *events;     /* list of DaoTaskletEvent* */
 	DList  *events2;    /* list of DaoTaskletEvent* */
 	DMap   *waitings;   /* timed waiting: <dao_complex,DaoTaskletEvent*> */
+	DMap   *iowaits;    /* I/O waiting: <DaoTaskletEvent*,0> */
 	DMap   *active;     /* map of DaoObject* or DaoProcess* keys */
 	DMap   *pending;    /* map of pointers from ::parameters, ::events and ::events2 */
 
@@ -232,6 +258,9 @@ struct DaoTaskletServer
 
 	dao_complex   timestamp;  /* (time,index); */
 	DaoVmSpace   *vmspace;
+
+	int  epoll;      /* epoll instance of the reactor on Linux; */
+	int  wakeup[2];  /* pipe to wake up the reactor from polling; */
 };
 
 static DaoTaskletThread* DaoTaskletThread_New( DaoTaskletServer *server, DThreadTask func, void *param )
@@ -256,8 +285,12 @@ static DaoTaskletServer* DaoTaskletServer_New( DaoVmSpace *vms )
 	DCondVar_Init( & self->condv );
 	DCondVar_Init( & self->condv2 );
 	DThread_Init( & self->timer );
+	DThread_Init( & self->reactor );
 	self->finishing = 0;
 	self->timing = 0;
+	self->reacting = 0;
+	self->epoll = -1;
+	self->wakeup[0] = self->wakeup[1] = -1;
 	self->total = 0;
 	self->vacant = 0;
 	self->idle = 0;
@@ -269,6 +302,7 @@ static DaoTaskletServer* DaoTaskletServer_New( DaoVmSpace *vms )
 	self->events = DList_New(0);
 	self->events2 = DList_New(0);
 	self->waitings = DMap_New( DAO_DATA_COMPLEX, 0 );
+	self->iowaits = DHash_New(0,0);
 	self->pending = DHash_New(0,0);
 	self->active = DHash_New(0,0);
 	self->caches = DList_New(0);
@@ -294,12 +328,21 @@ static void DaoTaskletServer_Delete( DaoTaskletServer *self )
 	DList_Delete( self->events2 );
 	DList_Delete( self->caches );
 	DMap_Delete( self->waitings );
+	DMap_Delete( self->iowaits );
 	DMap_Delete( self->pending );
 	DMap_Delete( self->active );
 	DMutex_Destroy( & self->mutex );
 	DCondVar_Destroy( & self->condv );
 	DCondVar_Destroy( & self->condv2 );
 	DThread_Destroy( & self->timer );
+	DThread_Destroy( & self->reactor );
+#ifdef LINUX
+	if( self->epoll >= 0 ) close( self->epoll );
+#endif
+#ifdef UNIX
+	if( self->wakeup[0] >= 0 ) close( self->wakeup[0] );
+	if( self->wakeup[1] >= 0 ) close( self->wakeup[1] );
+#endif
 	dao_free( self );
 }
 
@@ -408,6 +451,7 @@ static void DaoTaskletServer_ActivateEvents( DaoTaskletServer *self )
 	if( self->idle != self->total ) return;
 	if( self->events->size != 0 ) return;
 	if( self->events2->size == 0 ) return;
+	if( self->iowaits->size != 0 ) return; /* Not a deadlock while waiting for I/O; */
 
 #ifdef DEBUG
 	sprintf( message, "WARNING: try activating events (%i,%i,%i,%i)!\n", self->total,
@@ -496,6 +540,140 @@ static void DaoTaskletServer_Timer( DaoTaskletServer *self )
 	self->timing = 0;
 }
 
+/*
+// Lock self::mutex before calling this function:
+*/
+static void DaoTaskletServer_ResumeIO( DaoTaskletServer *self, DaoTaskletEvent *event, int timeout )
+{
+#ifdef LINUX
+	if( event->handle >= 0 ){
+		epoll_ctl( self->epoll, EPOLL_CTL_DEL, event->handle, NULL );
+		close( event->handle );
+	}
+#endif
+	event->handle = -1;
+	event->state = DAO_EVENT_RESUME;
+	event->timeout = timeout;
+	DMap_Erase( self->iowaits, event );
+	DList_Append( self->events, event );
+}
+/*
+// The I/O reactor polls the file descriptors of the I/O waiting events,
+// and moves the events of the ready or timed-out descriptors to the event list
+// for the tasklet threads to resume the waiting tasklets.
+//
+// On Linux, the descriptors are registered to an epoll instance as duplicated
+// descriptors (one per event), so that multiple tasklets may wait on the same
+// file descriptor; on other Unix systems, poll() is used on the waiting list.
+//
+// The reactor blocks until a descriptor becomes ready or the closest I/O timeout
+// expires. New waitings and stopping the server write to the wakeup pipe, which
+// is polled together with the descriptors, to let the reactor update the polling.
+*/
+#ifdef UNIX
+static void DaoTaskletServer_WakeReactor( DaoTaskletServer *self )
+{
+	char byte = 0;
+	/* The pipe is non-blocking, a full pipe will wake up the reactor anyway: */
+	if( write( self->wakeup[1], & byte, 1 ) < 0 ) return;
+}
+static void DaoTaskletServer_ClearWakeup( DaoTaskletServer *self )
+{
+	char buf[64];
+	while( read( self->wakeup[0], buf, sizeof(buf) ) > 0 );
+}
+static void DaoTaskletServer_Reactor( DaoTaskletServer *self )
+{
+#ifdef LINUX
+	struct epoll_event ready[IO_EVENTS];
+#else
+	DArray *pollfds = DArray_New( sizeof(struct pollfd) );
+	DList *polled = DList_New(0);
+#endif
+	DList *expired = DList_New(0);
+	DNode *it;
+	daoint i;
+
+	while( self->finishing == 0 || self->stopped != self->total ){
+		double time, expiring = -1.0;
+		int count = 0, resumed = 0, timeout = -1;
+
+		DMutex_Lock( & self->mutex );
+		for(it=DMap_First(self->iowaits); it; it=DMap_Next(self->iowaits,it)){
+			DaoTaskletEvent *event = (DaoTaskletEvent*) it->key.pVoid;
+			if( event->expiring < 0.0 ) continue;
+			if( expiring < 0.0 || event->expiring < expiring ) expiring = event->expiring;
+		}
+#ifndef LINUX
+		DArray_Clear( pollfds );
+		DList_Clear( polled );
+		for(it=DMap_First(self->iowaits); it; it=DMap_Next(self->iowaits,it)){
+			DaoTaskletEvent *event = (DaoTaskletEvent*) it->key.pVoid;
+			struct pollfd *pfd = (struct pollfd*) DArray_Push( pollfds );
+			pfd->fd = event->handle;
+			pfd->events = event->writing ? POLLOUT : POLLIN;
+			pfd->revents = 0;
+			DList_Append( polled, event );
+		}
+		{
+			struct pollfd *pfd = (struct pollfd*) DArray_Push( pollfds );
+			pfd->fd = self->wakeup[0];
+			pfd->events = POLLIN;
+			pfd->revents = 0;
+		}
+#endif
+		DMutex_Unlock( & self->mutex );
+
+		if( expiring >= 0.0 ){
+			time = expiring - Dao_GetCurrentTime();
+			timeout = time <= 0.0 ? 0 : (time < 1E6 ? (int) ceil( 1E3 * time ) : (int) 1E9);
+		}
+#ifdef LINUX
+		count = epoll_wait( self->epoll, ready, IO_EVENTS, timeout );
+		DMutex_Lock( & self->mutex );
+		for(i=0; i<count; ++i){
+			DaoTaskletEvent *event = (DaoTaskletEvent*) ready[i].data.ptr;
+			if( event == NULL ){
+				DaoTaskletServer_ClearWakeup( self );
+				continue;
+			}
+			DaoTaskletServer_ResumeIO( self, event, 0 );
+			resumed += 1;
+		}
+#else
+		count = poll( (struct pollfd*) pollfds->data.base, pollfds->size, timeout );
+		DMutex_Lock( & self->mutex );
+		for(i=0; count>0 && i<polled->size; ++i){
+			struct pollfd *pfd = (struct pollfd*) DArray_Get( pollfds, i );
+			if( pfd->revents == 0 ) continue;
+			DaoTaskletServer_ResumeIO( self, (DaoTaskletEvent*) polled->items.pVoid[i], 0 );
+			resumed += 1;
+		}
+		if( count > 0 && ((struct pollfd*) DArray_Get( pollfds, polled->size ))->revents ){
+			DaoTaskletServer_ClearWakeup( self );
+		}
+#endif
+		time = Dao_GetCurrentTime();
+		DList_Clear( expired );
+		for(it=DMap_First(self->iowaits); it; it=DMap_Next(self->iowaits,it)){
+			DaoTaskletEvent *event = (DaoTaskletEvent*) it->key.pVoid;
+			if( event->expiring >= 0.0 && event->expiring < time ) DList_Append( expired, event );
+		}
+		for(i=0; i<expired->size; ++i){
+			DaoTaskletServer_ResumeIO( self, (DaoTaskletEvent*) expired->items.pVoid[i], 1 );
+		}
+		if( resumed || expired->size ) DCondVar_Signal( & self->condv );
+		DMutex_Unlock( & self->mutex );
+	}
+#ifndef LINUX
+	DArray_Delete( pollfds );
+	DList_Delete( polled );
+#endif
+	DList_Delete( expired );
+	self->reacting = 0;
+}
+#endif
+
 void DaoVmSpace_AddTaskletJob( DaoVmSpace *self, DThreadTask func, void *param, void *proc )
 {
 	int scheduled = 0;
@@ -640,6 +818,34 @@ void DaoVmSpace_AddTaskletCall( DaoVmSpace *self, DaoProcess *caller )
 #endif
 }
 
+void DaoProcess_WaitIO( DaoProcess *self, int fd, int writing, double timeout )
+{
+#ifdef UNIX
+	struct pollfd pfd;
+	int ready;
+
+	pfd.fd = fd;
+	pfd.events = writing ? POLLOUT : POLLIN;
+	pfd.revents = 0;
+	ready = poll( & pfd, 1, 0 ) != 0; /* Errors are left to the following I/O; */
+	if( ready || timeout == 0.0 ){
+		DaoProcess_PutBoolean( self, ready );
+		return;
+	}
+#ifdef DAO_WITH_CONCURRENT
+	DaoProcess_PutBoolean( self, 0 );
+	self->status = DAO_PROCESS_SUSPENDED;
+	self->pauseType = DAO_PAUSE_IO_WAIT;
+	DaoVmSpace_AddTaskletIOWait( self->vmSpace, self, fd, writing, timeout );
+#else
+	ready = poll( & pfd, 1, timeout < 0.0 ? -1 : (int)(1000*timeout) ) != 0;
+	DaoProcess_PutBoolean( self, ready );
+#endif
+#else
+	DaoProcess_PutBoolean( self, 1 );
+#endif
+}
+
 #ifdef DAO_WITH_CONCURRENT
 DaoFuture* DaoProcess_GetInitFuture( DaoProcess *self )
 {
@@ -712,6 +918,80 @@ void DaoVmSpace_AddTaskletWait( DaoVmSpace *self, DaoProcess *wait, DaoFuture *p
 	DaoTaskletServer_AddTimedWait( server, wait, event, timeout );
 }
 
+void DaoVmSpace_AddTaskletIOWait( DaoVmSpace *self, DaoProcess *wait, int fd, int writing, double timeout )
+{
+	DaoTaskletEvent *event;
+	DaoTaskletServer *server = DaoTaskletServer_TryInit( self );
+	DaoFuture *future = DaoProcess_GetInitFuture( wait );
+#ifdef UNIX
+	int i;
+#endif
+#ifdef LINUX
+	struct epoll_event ev;
+#endif
+
+	future->state = DAO_TASKLET_PAUSED;
+
+	event = DaoTaskletServer_MakeEvent( server );
+	DaoTaskletEvent_Init( event, DAO_EVENT_WAIT_IO, DAO_EVENT_WAIT, future, NULL );
+	event->writing = writing != 0;
+	event->expiring = timeout >= 0.0 ? timeout + Dao_GetCurrentTime() : -1.0;
+
+	/* See the comments in DaoTaskletServer_AddTimedWait(): */
+	DaoProcess_MarkActiveTasklet( wait, 1 );
+
+	DMutex_Lock( & server->mutex );
+#ifdef UNIX
+	if( server->reacting == 0 ){
+		if( server->wakeup[0] < 0 ){
+			if( pipe( server->wakeup ) != 0 ) dao_abort( "failed to create the I/O reactor pipe" );
+			for(i=0; i<2; ++i){
+				fcntl( server->wakeup[i], F_SETFL, O_NONBLOCK );
+				fcntl( server->wakeup[i], F_SETFD, FD_CLOEXEC );
+			}
+		}
+#ifdef LINUX
+		if( server->epoll < 0 ){
+			server->epoll = epoll_create( IO_EVENTS );
+			fcntl( server->epoll, F_SETFD, FD_CLOEXEC );
+			ev.events = EPOLLIN;
+			ev.data.ptr = NULL;
+			epoll_ctl( server->epoll, EPOLL_CTL_ADD, server->wakeup[0], & ev );
+		}
+#endif
+		server->reacting = 1;
+		if( DThread_Start( & server->reactor, (DThreadTask) DaoTaskletServer_Reactor, server ) == 0 ){
+			dao_abort( "failed to create the I/O reactor thread" );
+		}
+	}
+#endif
+	DMap_Insert( server->iowaits, event, NULL );
+	DMap_Insert( server->pending, event, NULL );
+#ifdef LINUX
+	/* Not to be inherited by the child processes of other tasklets: */
+	event->handle = fcntl( fd, F_DUPFD_CLOEXEC, 0 );
+	ev.events = writing ? EPOLLOUT : EPOLLIN;
+	ev.data.ptr = event;
+	if( event->handle < 0 || epoll_ctl( server->epoll, EPOLL_CTL_ADD, event->handle, & ev ) != 0 ){
+		/* Not pollable (such as a regular file), let the tasklet try the I/O: */
+		if( event->handle >= 0 ) close( event->handle );
+		event->handle = -1;
+		DaoTaskletServer_ResumeIO( server, event, 0 );
+		DCondVar_Signal( & server->condv );
+	}
+#elif defined(UNIX)
+	event->handle = fd;
+#else
+	DaoTaskletServer_ResumeIO( server, event, 0 );
+	DCondVar_Signal( & server->condv );
+#endif
+#ifdef UNIX
+	/* Let the reactor poll the new descriptor and update its timeout: */
+	DaoTaskletServer_WakeReactor( server );
+#endif
+	DMutex_Unlock( & server->mutex );
+}
+
 static int DaoTaskletServer_CheckEvent( DaoTaskletEvent *event, DaoFuture *fut, DaoChannel *chan )
 {
 	DaoTaskletEvent event2 = *event;
@@ -978,11 +1258,11 @@ static void DaoTaskletThread_Run( DaoTaskletThread *self )
 		DMutex_Lock( & server->mutex );
 		server->idle += 1;
 		server->vacant += self->taskOwner == NULL;
-		while( server->pending->size == (server->events2->size + server->waitings->size) ){
+		while( server->pending->size == (server->events2->size + server->waitings->size + server->iowaits->size) ){
 			//printf( "%p %i %i %i %i\n", self, server->events->size, server->pending->size, server->events2->size, server->waitings->size );
 			if( server->vmspace->stopit ) break;
 			if( server->finishing && server->vacant == server->total ){
-				if( (server->events2->size + server->waitings->size) == 0 ) break;
+				if( (server->events2->size + server->waitings->size + server->iowaits->size) == 0 ) break;
 			}
 			wt = 0.01*(server->idle == server->total) + 0.001;
 			timeout = DCondVar_TimedWait( & server->condv, & server->mutex, wt );
@@ -1097,7 +1377,10 @@ void DaoVmSpace_StopTasklets( DaoVmSpace *self )
 	DaoTaskletThread_Run( taskthd );  /* process tasks in the main thread; */
 
 	DMutex_Lock( & server->mutex );
-	while( server->stopped != server->total || server->timing ){
+	while( server->stopped != server->total || server->timing || server->reacting ){
+#ifdef UNIX
+		if( server->reacting ) DaoTaskletServer_WakeReactor( server );
+#endif
 		DCondVar_TimedWait( & condv, & server->mutex, 0.01 );
 	}
 	DMutex_Unlock( & server->mutex );
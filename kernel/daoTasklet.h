@@ -92,6 +92,17 @@ DAO_DLL DaoFuture*  DaoFuture_New( DaoNamespace *ns, DaoType *type, int vatype )
 
 DAO_DLL void DaoVmSpace_AddTaskletCall( DaoVmSpace *self, DaoProcess *call );
 
+/*
+// Wait until the file descriptor "fd" becomes ready for reading (writing=0)
+// or writing (writing=1), or until "timeout" (in seconds, negative for no timeout);
+// Put a boolean as the returned value of the current call, true if it is ready.
+//
+// With concurrency support, the process is suspended as a tasklet and resumed
+// when the descriptor is ready, without occupying a thread while waiting;
+// Otherwise, the calling thread is blocked.
+*/
+DAO_DLL void DaoProcess_WaitIO( DaoProcess *self, int fd, int writing, double timeout );
+
 #ifdef DAO_WITH_CONCURRENT
 
 DAO_DLL DaoChannel* DaoChannel_New( DaoNamespace *ns, DaoType *type, int dtype );
@@ -117,6 +128,7 @@ DAO_DLL void DaoVmSpace_StopTasklets( DaoVmSpace *self );
 DAO_DLL void DaoVmSpace_AddTaskletThread( DaoVmSpace *self, DThreadTask func, void *param, void *proc );
 DAO_DLL void DaoVmSpace_AddTaskletJob( DaoVmSpace *self, DThreadTask func, void *param, void *proc );
 DAO_DLL void DaoVmSpace_AddTaskletWait( DaoVmSpace *self, DaoProcess *wait, DaoFuture *future, double timeout );
+DAO_DLL void DaoVmSpace_AddTaskletIOWait( DaoVmSpace *self, DaoProcess *wait, int fd, int writing, double timeout );
 
 #endif
 
@@ -134,6 +134,7 @@ void DThread_Init( DThread *self )
 	self->taskFunc = NULL;
 	self->taskArg = NULL;
 	self->thdSpecData = NULL;
+	self->process = NULL;
 	DCondVar_Init( & self->condv );
 	DMutex_Init( & self->mutex );
 }
@@ -193,6 +194,12 @@ void DThread_Exit( DThread *self )
 	pthread_exit( NULL );
 }
 
+int DThread_GetProcessorCount()
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return count > 0 ? count : 1;
+}
+
 DThreadData* DThread_GetSpecific()
 {
 	return (DThreadData*) pthread_getspecific( thdSpecKey );
@@ -327,6 +334,7 @@ void DThread_Init( DThread *self )
 	self->vmstopped = 0;
 	self->myThread = 0;
 	self->thdSpecData = NULL;
+	self->process = NULL;
 	self->cleaner = NULL;
 	self->taskFunc = NULL;
 	self->taskArg = NULL;
@@ -341,6 +349,7 @@ void DThread_Destroy( DThread *self )
 	DCondVar_Destroy( & self->condv );
 	DMutex_Destroy( & self->mutex );
 	self->thdSpecData = NULL;
+	self->process = NULL;
 }
 
 static DThreadData* DThreadData_New()
@@ -391,6 +400,13 @@ void DThread_Exit( DThread *thd )
 	_endthread();
 }
 
+int DThread_GetProcessorCount()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo( & info );
+	return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
 DThreadData* DThread_GetSpecific()
 {
 	return (DThreadData*) TlsGetValue( thdSpecKey );
@@ -479,6 +495,13 @@ int DThread_IsMain()
 #ifdef DAO_WITH_CONCURRENT
 /* mt module: */
 
+/*
+// The items are partitioned into contiguous chunks, about DAO_MT_CHUNKS
+// of them for each thread. The threads claim the chunks dynamically in
+// increasing order, so that uneven items are balanced among the threads;
+*/
+#define DAO_MT_CHUNKS  8
+
 
 typedef struct DaoTaskData DaoTaskData;
 struct DaoTaskData
@@ -494,12 +517,25 @@ struct DaoTaskData
 
 	uint_t   funct; /* type of functional; */
 	uint_t   entry; /* entry code; */
-	uint_t   first; /* first index; */
-	uint_t   step; /* index step; */
+	uint_t   threadid; /* thread index; */
+	uint_t   phase; /* execution phase; */
 	uint_t   status; /* execution status; */
+	uint_t   order; /* descending order for sorting; */
+	daoint   chunk; /* number of items per chunk; */
+	daoint   width; /* width of sorted runs, or number of partitions; */
+	int     *cursor; /* next chunk to be claimed by all threads; */
 	daoint  *joined; /* number of joined threads; */
 	daoint  *index; /* smallest index found by all threads; */
 	DNode  **node; /* smallest key found by all threads; */
+
+	DaoList    *partial; /* partial values by chunks, or keys by items; */
+	DaoValue  **source; /* sorted runs to be merged; */
+	DaoValue  **target; /* merged runs; */
+	DaoMap    **groups; /* partitioned groups; */
+	uint_t     *hashes; /* key hashes by items; */
+	daoint     *buckets; /* item indexes bucketed by partitions within chunks; */
+	daoint     *offsets; /* bucket offsets of the partitions for each chunk; */
+	daoint      chunks; /* number of chunks in the first phase; */
 };
 
 static void DaoMT_InitProcess( DaoProcess *proto, DaoProcess *clone, int argcount )
@@ -513,6 +549,15 @@ static void DaoMT_InitProcess( DaoProcess *proto, DaoProcess *clone, int argcoun
 	clone->topFrame->retmode = DVM_RET_PROCESS;
 	clone->topFrame->returning = 0;
 }
+static int DaoMT_ClaimChunk( DaoTaskData *self, daoint count, daoint *start, daoint *end )
+{
+	daoint chunk = DAtomic_Add( self->cursor, 1 ) - 1;
+	*start = chunk * self->chunk;
+	if( *start >= count ) return 0;
+	*end = *start + self->chunk;
+	if( *end > count ) *end = count;
+	return 1;
+}
 static void DaoMT_RunIterateFunctional( void *p )
 {
 	DaoInteger idint = {DAO_INTEGER,0,0,0,0,0};
@@ -522,17 +567,19 @@ static void DaoMT_RunIterateFunctional( void *p )
 	DaoTaskData *self = (DaoTaskData*)p;
 	DaoProcess *clone = self->clone;
 	DaoVmCode *sect = self->sect;
-	daoint i, n = self->param->xInteger.value;
+	daoint i, start, end, n = self->param->xInteger.value;
 
 	DaoMT_InitProcess( self->proto, clone, 2 );
-	tidint.value = self->first;
-	for(i=self->first; i<n; i+=self->step){
-		idint.value = i;
-		if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, index );
-		if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, threadid );
-		clone->topFrame->entry = self->entry;
-		DaoProcess_Execute( clone );
-		if( clone->status != DAO_PROCESS_FINISHED ) break;
+	tidint.value = self->threadid;
+	while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+		for(i=start; i<end; ++i){
+			idint.value = i;
+			if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, index );
+			if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, threadid );
+			clone->topFrame->entry = self->entry;
+			DaoProcess_Execute( clone );
+			if( clone->status != DAO_PROCESS_FINISHED ) return;
+		}
 	}
 }
 static void DaoMT_RunListFunctional( void *p )
@@ -548,30 +595,32 @@ static void DaoMT_RunListFunctional( void *p )
 	DaoProcess *clone = self->clone;
 	DaoVmCode *sect = self->sect;
 	DaoValue **items = list->value->items.pValue;
-	daoint i, n = list->value->size;
+	daoint i, start, end, n = list->value->size;
 
 	DaoMT_InitProcess( self->proto, clone, 3 );
-	tidint.value = self->first;
-	for(i=self->first; i<n; i+=self->step){
-		idint.value = i;
-		if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, items[i] );
-		if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, index );
-		if( sect->b >2 ) DaoProcess_SetValue( clone, sect->a+2, threadid );
-		clone->topFrame->entry = self->entry;
-		DaoProcess_Execute( clone );
-		if( clone->status != DAO_PROCESS_FINISHED ) break;
-		res = clone->stackValues[0];
-		if( self->funct == DVM_FUNCT_MAP ){
-			self->status |= DaoList_SetItem( list2, res, i );
-		}else if( self->funct == DVM_FUNCT_APPLY ){
-			self->status |= DaoList_SetItem( list, res, i );
-		}else if( self->funct == DVM_FUNCT_FIND ){
-			if( *self->index >= 0 && *self->index < i ) break;
-			if( res->xInteger.value ){
-				DMutex_Lock( self->mutex );
-				if( *self->index < 0 || i < *self->index ) *self->index = i;
-				DMutex_Unlock( self->mutex );
-				break;
+	tidint.value = self->threadid;
+	while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+		for(i=start; i<end; ++i){
+			idint.value = i;
+			if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, items[i] );
+			if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, index );
+			if( sect->b >2 ) DaoProcess_SetValue( clone, sect->a+2, threadid );
+			clone->topFrame->entry = self->entry;
+			DaoProcess_Execute( clone );
+			if( clone->status != DAO_PROCESS_FINISHED ) return;
+			res = clone->stackValues[0];
+			if( self->funct == DVM_FUNCT_MAP ){
+				self->status |= DaoList_SetItem( list2, res, i );
+			}else if( self->funct == DVM_FUNCT_APPLY ){
+				self->status |= DaoList_SetItem( list, res, i );
+			}else if( self->funct == DVM_FUNCT_FIND ){
+				if( *self->index >= 0 && *self->index < i ) return;
+				if( res->xInteger.value ){
+					DMutex_Lock( self->mutex );
+					if( *self->index < 0 || i < *self->index ) *self->index = i;
+					DMutex_Unlock( self->mutex );
+					return;
+				}
 			}
 		}
 	}
@@ -587,34 +636,36 @@ static void DaoMT_RunMapFunctional( void *p )
 	DaoProcess *clone = self->clone;
 	DaoVmCode *sect = self->sect;
 	DaoType *type = map->ctype;
-	DNode *node = NULL;
-	daoint i = 0;
+	DNode *node = DMap_First( map->value );
+	daoint i = 0, start, end, n = map->value->size;
 
 	DaoMT_InitProcess( self->proto, clone, 3 );
-	tidint.value = self->first;
+	tidint.value = self->threadid;
 	type = type && type->args->size > 1 ? type->args->items.pType[1] : NULL;
-	for(node=DMap_First( map->value ); node; node=DMap_Next(map->value, node) ){
-		if( (i++) % self->step != self->first ) continue;
-		if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, node->key.pValue );
-		if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, node->value.pValue );
-		if( sect->b >2 ) DaoProcess_SetValue( clone, sect->a+2, threadid );
-		clone->topFrame->entry = self->entry;
-		DaoProcess_Execute( clone );
-		if( clone->status != DAO_PROCESS_FINISHED ) break;
-		res = clone->stackValues[0];
-		if( self->funct == DVM_FUNCT_MAP ){
-			self->status |= DaoList_SetItem( list2, res, i-1 );
-		}else if( self->funct == DVM_FUNCT_APPLY ){
-			self->status |= DaoValue_Move( res, & node->value.pValue, type ) == 0;
-		}else if( self->funct == DVM_FUNCT_FIND ){
-			DNode **p = self->node;
-			/* XXX: 2014-11-11 */
-			if( *p && DaoValue_Compare( (*p)->key.pValue, node->key.pValue ) < 0 ) break;
-			if( res->xInteger.value ){
-				DMutex_Lock( self->mutex );
-				if( *p == NULL || DaoValue_Compare( (*p)->key.pValue, node->key.pValue ) >0 ) *p = node;
-				DMutex_Unlock( self->mutex );
-				break;
+	while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+		for(; i<start; ++i) node = DMap_Next( map->value, node );
+		for(; i<end; ++i, node = DMap_Next( map->value, node )){
+			if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, node->key.pValue );
+			if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, node->value.pValue );
+			if( sect->b >2 ) DaoProcess_SetValue( clone, sect->a+2, threadid );
+			clone->topFrame->entry = self->entry;
+			DaoProcess_Execute( clone );
+			if( clone->status != DAO_PROCESS_FINISHED ) return;
+			res = clone->stackValues[0];
+			if( self->funct == DVM_FUNCT_MAP ){
+				self->status |= DaoList_SetItem( list2, res, i );
+			}else if( self->funct == DVM_FUNCT_APPLY ){
+				self->status |= DaoValue_Move( res, & node->value.pValue, type ) == 0;
+			}else if( self->funct == DVM_FUNCT_FIND ){
+				DNode **p = self->node;
+				/* XXX: 2014-11-11 */
+				if( *p && DaoValue_Compare( (*p)->key.pValue, node->key.pValue ) < 0 ) return;
+				if( res->xInteger.value ){
+					DMutex_Lock( self->mutex );
+					if( *p == NULL || DaoValue_Compare( (*p)->key.pValue, node->key.pValue ) >0 ) *p = node;
+					DMutex_Unlock( self->mutex );
+					return;
+				}
 			}
 		}
 	}
@@ -644,54 +695,92 @@ static void DaoMT_RunArrayFunctional( void *p )
 	daoint len = DaoArray_GetWorkIntervalSize( param );
 	daoint step = DaoArray_GetWorkStep( param );
 	daoint *dims = param->dims;
-	daoint i, id, id2, n = size;
+	daoint i, id, id2, begin, end, n = size;
 	int j, D = array->ndim;
 	int isvec = (D == 2 && (dims[0] ==1 || dims[1] == 1));
 	int stackBase, vdim = sect->b - 1;
 
 	DaoMT_InitProcess( self->proto, clone, array->ndim + 1 );
-	tidint.xInteger.value = self->first;
+	tidint.xInteger.value = self->threadid;
 
 	stackBase = clone->topFrame->active->stackBase;
 	idval = clone->activeValues + sect->a + 1;
 	for(j=0; j<vdim; j++) idval[j]->xInteger.value = 0;
-	for(i=self->first; i<n; i+=self->step){
-		idval = clone->stackValues + stackBase + sect->a + 1;
-		id = id2 = start + (i / len) * step + (i % len);
-		if( isvec ){
-			if( vdim >0 ) idval[0]->xInteger.value = id2;
-			if( vdim >1 ) idval[1]->xInteger.value = id2;
-		}else{
-			for( j=D-1; j>=0; j--){
-				int k = id2 % dims[j];
-				id2 /= dims[j];
-				if( j < vdim ) idval[j]->xInteger.value = k;
+	while( DaoMT_ClaimChunk( self, n, & begin, & end ) ){
+		for(i=begin; i<end; ++i){
+			idval = clone->stackValues + stackBase + sect->a + 1;
+			id = id2 = start + (i / len) * step + (i % len);
+			if( isvec ){
+				if( vdim >0 ) idval[0]->xInteger.value = id2;
+				if( vdim >1 ) idval[1]->xInteger.value = id2;
+			}else{
+				for( j=D-1; j>=0; j--){
+					int k = id2 % dims[j];
+					id2 /= dims[j];
+					if( j < vdim ) idval[j]->xInteger.value = k;
+				}
+			}
+			elem = clone->stackValues[ stackBase + sect->a ];
+			if( elem == NULL || elem->type != array->etype ){
+				elem = (DaoValue*)&com;
+				elem->type = array->etype;
+				elem = DaoProcess_SetValue( clone, sect->a, elem );
+			}
+			DaoArray_GetValue( array, id, elem );
+			if( sect->b > 6 ) DaoProcess_SetValue( clone, sect->a+6, threadid );
+			clone->topFrame->entry = self->entry;
+			DaoProcess_Execute( clone );
+			if( clone->status != DAO_PROCESS_FINISHED ) return;
+			res = clone->stackValues[0];
+			if( self->funct == DVM_FUNCT_MAP ){
+				DaoArray_SetValue( result, i, res );
+			}else if( self->funct == DVM_FUNCT_APPLY ){
+				DaoArray_SetValue( array, id, res );
 			}
-		}
-		elem = clone->stackValues[ stackBase + sect->a ];
-		if( elem == NULL || elem->type != array->etype ){
-			elem = (DaoValue*)&com;
-			elem->type = array->etype;
-			elem = DaoProcess_SetValue( clone, sect->a, elem );
-		}
-		DaoArray_GetValue( array, id, elem );
-		if( sect->b > 6 ) DaoProcess_SetValue( clone, sect->a+6, threadid );
-		clone->topFrame->entry = self->entry;
-		DaoProcess_Execute( clone );
-		if( clone->status != DAO_PROCESS_FINISHED ) break;
-		res = clone->stackValues[0];
-		if( self->funct == DVM_FUNCT_MAP ){
-			DaoArray_SetValue( result, i, res );
-		}else if( self->funct == DVM_FUNCT_APPLY ){
-			DaoArray_SetValue( array, id, res );
 		}
 	}
 }
 #endif
+static void DaoMT_JoinTask( DaoTaskData *self )
+{
+	DaoProcess *clone = self->clone;
+	/* The clone remains stacked if the other threads have claimed all the chunks: */
+	if( self->sect != NULL && clone->status != DAO_PROCESS_STACKED ){
+		self->status |= clone->status != DAO_PROCESS_FINISHED;
+	}
+	DMutex_Lock( self->mutex );
+	*self->joined += 1;
+	if( clone->exceptions->size ) DaoProcess_PrintException( clone, NULL, 1 );
+	DCondVar_Signal( self->condv );
+	DMutex_Unlock( self->mutex );
+}
+/*
+// Run one phase of the tasks, with the first task in the current thread,
+// and the others as tasklet jobs. Return after all the tasks are joined:
+*/
+static void DaoMT_RunPhase( DaoProcess *proc, DaoTaskData *tasks, int threads, DThreadTask func, daoint chunk, int phase )
+{
+	int i;
+
+	*tasks->cursor = 0;
+	*tasks->joined = 0;
+	for(i=0; i<threads; i++){
+		tasks[i].chunk = chunk;
+		tasks[i].phase = phase;
+	}
+	for(i=1; i<threads; i++){
+		DaoTaskData *task = tasks + i;
+		DaoVmSpace_AddTaskletJob( proc->vmSpace, func, task, task->clone );
+	}
+	(*func)( tasks );
+
+	DMutex_Lock( tasks->mutex );
+	while( *tasks->joined < threads ) DCondVar_Wait( tasks->condv, tasks->mutex );
+	DMutex_Unlock( tasks->mutex );
+}
 static void DaoMT_RunFunctional( void *p )
 {
 	DaoTaskData *self = (DaoTaskData*)p;
-	DaoProcess *clone = self->clone;
 	switch( self->param->type ){
 	case DAO_INTEGER : DaoMT_RunIterateFunctional( p ); break;
 	case DAO_LIST  : DaoMT_RunListFunctional( p ); break;
@@ -700,12 +789,7 @@ static void DaoMT_RunFunctional( void *p )
 	case DAO_ARRAY : DaoMT_RunArrayFunctional( p ); break;
 #endif
 	}
-	self->status |= clone->status != DAO_PROCESS_FINISHED;
-	DMutex_Lock( self->mutex );
-	*self->joined += 1;
-	if( clone->exceptions->size ) DaoProcess_PrintException( clone, NULL, 1 );
-	DCondVar_Signal( self->condv );
-	DMutex_Unlock( self->mutex );
+	DaoMT_JoinTask( self );
 }
 static void DaoMT_Functional( DaoProcess *proc, DaoValue *P[], int N, int F )
 {
@@ -718,8 +802,8 @@ static void DaoMT_Functional( DaoProcess *proc, DaoValue *P[], int N, int F )
 	DaoArray *array = NULL;
 	DaoVmCode *sect = NULL;
 	DaoStackFrame *frame = DaoProcess_FindSectionFrame( proc );
-	int i, entry, threads = P[1]->xInteger.value;
-	daoint index = -1, status = 0, joined = 0;
+	int i, entry, cursor = 0, threads = P[1]->xInteger.value;
+	daoint index = -1, status = 0, joined = 0, count = 0, chunk;
 	DNode *node = NULL;
 
 	switch( F ){
@@ -734,7 +818,16 @@ static void DaoMT_Functional( DaoProcess *proc, DaoValue *P[], int N, int F )
 		break;
 	case DVM_FUNCT_FIND : DaoProcess_PutValue( proc, dao_none_value ); break;
 	}
-	if( threads <= 0 ) threads = 2;
+	switch( param->type ){
+	case DAO_INTEGER : count = param->xInteger.value; break;
+	case DAO_LIST  : count = param->xList.value->size; break;
+	case DAO_MAP   : count = param->xMap.value->size; break;
+#ifdef DAO_WITH_NUMARRAY
+	case DAO_ARRAY : count = DaoArray_GetWorkSize( (DaoArray*) param ); break;
+#endif
+	}
+	if( threads <= 0 ) threads = DThread_GetProcessorCount();
+	if( threads > count ) threads = count > 0 ? count : 1;
 	if( frame != proc->topFrame->prev ){
 		DaoProcess_RaiseError( proc, NULL, "Invalid code section from non-immediate caller" );
 		return;
@@ -765,21 +858,17 @@ static void DaoMT_Functional( DaoProcess *proc, DaoValue *P[], int N, int F )
 		task->sect = sect;
 		task->funct = F;
 		task->entry = entry;
-		task->first = i;
-		task->step = threads;
+		task->threadid = i;
+		task->cursor = & cursor;
 		task->index = & index;
 		task->node = & node;
 		task->joined = & joined;
 		task->condv = & condv;
 		task->mutex = & mutex;
 		task->clone = DaoVmSpace_AcquireProcess( proc->vmSpace );
-		if( i ) DaoVmSpace_AddTaskletJob( proc->vmSpace, DaoMT_RunFunctional, task, task->clone );
 	}
-	DaoMT_RunFunctional( tasks );
-
-	DMutex_Lock( & mutex );
-	while( joined < threads ) DCondVar_TimedWait( & condv, & mutex, 0.01 );
-	DMutex_Unlock( & mutex );
+	chunk = (count + threads * DAO_MT_CHUNKS - 1) / (threads * DAO_MT_CHUNKS);
+	DaoMT_RunPhase( proc, tasks, threads, DaoMT_RunFunctional, chunk, 0 );
 
 	for(i=0; i<threads; i++){
 		DaoTaskData *task = tasks + i;
@@ -802,6 +891,388 @@ static void DaoMT_Functional( DaoProcess *proc, DaoValue *P[], int N, int F )
 	DCondVar_Destroy( & condv );
 	dao_free( tasks );
 }
+/*
+// Multiple-phase functionals on lists:
+// reduce: each chunk is reduced to a partial value, then the partial values
+//         are reduced in the order of the chunks;
+// scan:   each chunk is scanned locally, then the offsets of the chunks are
+//         scanned from the last values of the chunks, and applied to the chunks;
+// sort:   each chunk is sorted by merge sort, then the sorted chunks are merged
+//         pairwise in parallel, until one sorted run is left;
+// group:  the keys are evaluated and hashed, and the items of each chunk are
+//         bucketed by the partitions of the hashes; then each partition is
+//         grouped by one thread from its buckets in the chunks;
+*/
+enum DaoMTAggregation
+{
+	DAO_MT_REDUCE ,
+	DAO_MT_SCAN ,
+	DAO_MT_SORT ,
+	DAO_MT_GROUP
+};
+
+static DaoValue* DaoMT_Evaluate( DaoTaskData *self, DaoValue *X, DaoValue *Y )
+{
+	DaoProcess *clone = self->clone;
+	DaoVmCode *sect = self->sect;
+
+	if( sect->b >0 ) DaoProcess_SetValue( clone, sect->a, X );
+	if( sect->b >1 ) DaoProcess_SetValue( clone, sect->a+1, Y );
+	clone->topFrame->entry = self->entry;
+	DaoProcess_Execute( clone );
+	if( clone->status != DAO_PROCESS_FINISHED ){
+		self->status = 1;
+		return NULL;
+	}
+	return clone->stackValues[0];
+}
+static void DaoMT_RunReduce( DaoTaskData *self )
+{
+	DaoList *list = (DaoList*) self->param;
+	DaoValue **items = list->value->items.pValue;
+	daoint i, start, end, n = list->value->size;
+
+	while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+		DaoValue *value = items[start];
+		for(i=start+1; i<end; ++i){
+			value = DaoMT_Evaluate( self, value, items[i] );
+			if( value == NULL ) return;
+		}
+		DaoList_SetItem( self->partial, value, start / self->chunk );
+	}
+}
+static void DaoMT_RunScan( DaoTaskData *self )
+{
+	DaoList *list = (DaoList*) self->param;
+	DaoList *result = (DaoList*) self->result;
+	DaoValue **items = list->value->items.pValue;
+	DaoValue **values = result->value->items.pValue;
+	DaoValue **offsets = self->partial->value->items.pValue;
+	daoint i, start, end, n = list->value->size;
+
+	while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+		DaoValue *value = items[start];
+		if( self->phase == 0 ){
+			DaoList_SetItem( result, value, start );
+			for(i=start+1; i<end; ++i){
+				value = DaoMT_Evaluate( self, value, items[i] );
+				if( value == NULL ) return;
+				DaoList_SetItem( result, value, i );
+			}
+		}else if( start > 0 ){
+			for(i=start; i<end; ++i){
+				value = DaoMT_Evaluate( self, offsets[start / self->chunk], values[i] );
+				if( value == NULL ) return;
+				DaoList_SetItem( result, value, i );
+			}
+		}
+	}
+}
+static int DaoMT_Less( DaoTaskData *self, DaoValue *X, DaoValue *Y )
+{
+	DaoValue *res;
+	if( self->sect == NULL ){
+		int cmp = DaoValue_Compare( X, Y );
+		return self->order ? cmp > 0 : cmp < 0;
+	}
+	if( self->status ) return 0;
+	res = DaoMT_Evaluate( self, X, Y );
+	return res != NULL && DaoValue_GetInteger( res ) != 0;
+}
+/* Stable merging of source[first:mid-1] and source[mid:last-1] into target: */
+static void DaoMT_Merge( DaoTaskData *self, DaoValue **source, DaoValue **target,
+		daoint first, daoint mid, daoint last )
+{
+	daoint i = first, j = mid, k = first;
+	while( i < mid && j < last ){
+		if( DaoMT_Less( self, source[j], source[i] ) ){
+			target[k++] = source[j++];
+		}else{
+			target[k++] = source[i++];
+		}
+	}
+	while( i < mid ) target[k++] = source[i++];
+	while( j < last ) target[k++] = source[j++];
+}
+/* Stable merge sort of items[first:last-1], with buffer as the scratch space: */
+static void DaoMT_MergeSort( DaoTaskData *self, DaoValue **items, DaoValue **buffer,
+		daoint first, daoint last )
+{
+	daoint i, j, mid = (first + last) / 2;
+
+	if( (last - first) <= 8 ){
+		for(i=first+1; i<last; ++i){
+			DaoValue *item = items[i];
+			for(j=i; j>first && DaoMT_Less( self, item, items[j-1] ); --j) items[j] = items[j-1];
+			items[j] = item;
+		}
+		return;
+	}
+	DaoMT_MergeSort( self, items, buffer, first, mid );
+	DaoMT_MergeSort( self, items, buffer, mid, last );
+	if( DaoMT_Less( self, items[mid], items[mid-1] ) == 0 ) return;
+	memcpy( buffer + first, items + first, (last - first)*sizeof(DaoValue*) );
+	DaoMT_Merge( self, buffer, items, first, mid, last );
+}
+static void DaoMT_RunSort( DaoTaskData *self )
+{
+	DaoList *list = (DaoList*) self->param;
+	DaoValue **items = list->value->items.pValue;
+	daoint i, start, end, n = list->value->size;
+	daoint width = self->width;
+
+	if( self->phase == 0 ){
+		while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+			DaoMT_MergeSort( self, items, self->target, start, end );
+		}
+		return;
+	}
+	while( DaoMT_ClaimChunk( self, (n + 2*width - 1) / (2*width), & start, & end ) ){
+		for(i=start; i<end; ++i){
+			daoint first = 2 * i * width;
+			daoint mid = first + width < n ? first + width : n;
+			daoint last = mid + width < n ? mid + width : n;
+			DaoMT_Merge( self, self->source, self->target, first, mid, last );
+		}
+	}
+}
+static void DaoMT_RunGroup( DaoTaskData *self )
+{
+	DaoInteger idint = {DAO_INTEGER,0,0,0,0,0};
+	DaoList *list = (DaoList*) self->param;
+	DaoMap *map = (DaoMap*) self->result;
+	DaoValue **items = list->value->items.pValue;
+	DaoValue **keys = self->partial->value->items.pValue;
+	DaoType *type = map->ctype;
+	daoint i, j, k, c, start, end, n = list->value->size;
+	daoint width = self->width;
+
+	type = type && type->args->size > 1 ? type->args->items.pType[1] : NULL;
+	if( self->phase == 0 ){
+		while( DaoMT_ClaimChunk( self, n, & start, & end ) ){
+			daoint *offsets = self->offsets + (start / self->chunk) * (width + 1);
+			for(i=start; i<end; ++i){
+				DaoValue *key;
+				idint.value = i;
+				key = DaoMT_Evaluate( self, items[i], (DaoValue*) & idint );
+				if( key == NULL ) return;
+				DaoList_SetItem( self->partial, key, i );
+				self->hashes[i] = DaoValue_Hash( keys[i], 0 );
+			}
+			/* Counting sort of the chunk items by partitions: */
+			memset( offsets, 0, (width + 1) * sizeof(daoint) );
+			for(i=start; i<end; ++i) offsets[ self->hashes[i] % width + 1 ] += 1;
+			offsets[0] = start;
+			for(j=1; j<=width; ++j) offsets[j] += offsets[j-1];
+			for(i=start; i<end; ++i) self->buckets[ offsets[ self->hashes[i] % width ]++ ] = i;
+			for(j=width; j>0; --j) offsets[j] = offsets[j-1];
+			offsets[0] = start;
+		}
+		return;
+	}
+	while( DaoMT_ClaimChunk( self, width, & start, & end ) ){
+		for(j=start; j<end; ++j){
+			DaoMap *groups = self->groups[j];
+			for(c=0; c<self->chunks; ++c){
+				daoint *offsets = self->offsets + c * (width + 1);
+				for(k=offsets[j]; k<offsets[j+1]; ++k){
+					DNode *node;
+					i = self->buckets[k];
+					node = DMap_Find( groups->value, keys[i] );
+					if( node == NULL ){
+						DaoList *group = DaoList_New();
+						GC_Assign( & group->ctype, type );
+						node = DMap_Insert( groups->value, keys[i], group );
+					}
+					DaoList_Append( (DaoList*) node->value.pValue, items[i] );
+				}
+			}
+		}
+	}
+}
+static void DaoMT_RunAggregation( void *p )
+{
+	DaoTaskData *self = (DaoTaskData*)p;
+	switch( self->funct ){
+	case DAO_MT_REDUCE : DaoMT_RunReduce( self ); break;
+	case DAO_MT_SCAN   : DaoMT_RunScan( self ); break;
+	case DAO_MT_SORT   : DaoMT_RunSort( self ); break;
+	case DAO_MT_GROUP  : DaoMT_RunGroup( self ); break;
+	}
+	DaoMT_JoinTask( self );
+}
+static int DaoMT_JoinStatus( DaoTaskData *tasks, int threads )
+{
+	int i, status = 0;
+	for(i=0; i<threads; i++) status |= tasks[i].status;
+	return status;
+}
+static void DaoMT_Aggregate( DaoProcess *proc, DaoValue *P[], int N, int F )
+{
+	DMutex mutex;
+	DCondVar condv;
+	DaoTaskData *tasks;
+	DaoList *list = (DaoList*) P[0];
+	DaoList *result = NULL;
+	DaoList *partial = NULL;
+	DaoMap *map = NULL;
+	DaoMap **groups = NULL;
+	DaoValue **items = list->value->items.pValue;
+	DaoValue **buffer = NULL;
+	DaoValue **source, **target, **tmp;
+	DaoValue *value;
+	DaoVmCode *sect = NULL;
+	DaoStackFrame *frame = DaoProcess_FindSectionFrame( proc );
+	daoint i, width, chunk, chunks, count = list->value->size;
+	daoint joined = 0;
+	daoint *buckets = NULL;
+	daoint *offsets = NULL;
+	uint_t *hashes = NULL;
+	int entry = 0, cursor = 0, order = 0, status = 0;
+	int threads = P[N-1]->xInteger.value;
+	DNode *it;
+
+	switch( F ){
+	case DAO_MT_REDUCE : DaoProcess_PutValue( proc, dao_none_value ); break;
+	case DAO_MT_SCAN   : result = DaoProcess_PutList( proc ); break;
+	case DAO_MT_SORT   : DaoProcess_PutValue( proc, P[0] ); break;
+	case DAO_MT_GROUP  : map = DaoProcess_PutMap( proc, 0 ); break;
+	}
+	if( count == 0 ) return;
+	if( F == DAO_MT_SORT && P[1]->type == DAO_ENUM ){
+		order = P[1]->xEnum.value;
+	}else{
+		if( frame != proc->topFrame->prev ){
+			DaoProcess_RaiseError( proc, NULL, "Invalid code section from non-immediate caller" );
+			return;
+		}
+		sect = DaoProcess_InitCodeSection( proc, 0 );
+		if( sect == NULL ) return;
+		entry = proc->topFrame->entry;
+		DaoProcess_PopFrame( proc );
+	}
+	if( threads <= 0 ) threads = DThread_GetProcessorCount();
+	if( threads > count ) threads = count;
+	chunk = (count + threads * DAO_MT_CHUNKS - 1) / (threads * DAO_MT_CHUNKS);
+	chunks = (count + chunk - 1) / chunk;
+
+	switch( F ){
+	case DAO_MT_REDUCE :
+	case DAO_MT_SCAN :
+		partial = DaoProcess_NewList( proc );
+		DList_Resize( partial->value, chunks, NULL );
+		if( result == NULL ) break;
+		DList_Clear( result->value );
+		DList_Resize( result->value, count, NULL );
+		break;
+	case DAO_MT_SORT :
+		buffer = (DaoValue**) dao_malloc( count * sizeof(DaoValue*) );
+		break;
+	case DAO_MT_GROUP :
+		partial = DaoProcess_NewList( proc );
+		DList_Resize( partial->value, count, NULL );
+		hashes = (uint_t*) dao_malloc( count * sizeof(uint_t) );
+		buckets = (daoint*) dao_malloc( count * sizeof(daoint) );
+		offsets = (daoint*) dao_malloc( chunks * (threads + 1) * sizeof(daoint) );
+		groups = (DaoMap**) dao_malloc( threads * sizeof(DaoMap*) );
+		for(i=0; i<threads; i++) groups[i] = DaoProcess_NewMap( proc, 1 );
+		break;
+	}
+
+	DMutex_Init( & mutex );
+	DCondVar_Init( & condv );
+	tasks = (DaoTaskData*) dao_calloc( threads, sizeof(DaoTaskData) );
+	for(i=0; i<threads; i++){
+		DaoTaskData *task = tasks + i;
+		task->param = P[0];
+		task->result = result ? (DaoValue*) result : (DaoValue*) map;
+		task->proto = proc;
+		task->sect = sect;
+		task->funct = F;
+		task->entry = entry;
+		task->threadid = i;
+		task->order = order;
+		task->partial = partial;
+		task->groups = groups;
+		task->hashes = hashes;
+		task->buckets = buckets;
+		task->offsets = offsets;
+		task->chunks = chunks;
+		task->width = threads;
+		task->target = buffer;
+		task->cursor = & cursor;
+		task->joined = & joined;
+		task->condv = & condv;
+		task->mutex = & mutex;
+		task->clone = DaoVmSpace_AcquireProcess( proc->vmSpace );
+		if( sect ) DaoMT_InitProcess( proc, task->clone, 2 );
+	}
+	DaoMT_RunPhase( proc, tasks, threads, DaoMT_RunAggregation, chunk, 0 );
+	status = DaoMT_JoinStatus( tasks, threads );
+
+	switch( status ? -1 : F ){
+	case DAO_MT_REDUCE :
+		value = partial->value->items.pValue[0];
+		for(i=1; i<chunks && value != NULL; i++){
+			value = DaoMT_Evaluate( tasks, value, partial->value->items.pValue[i] );
+		}
+		if( value != NULL ) DaoProcess_PutValue( proc, value );
+		status = value == NULL;
+		break;
+	case DAO_MT_SCAN :
+		value = result->value->items.pValue[chunk-1];
+		for(i=1; i<chunks && value != NULL; i++){
+			DaoList_SetItem( partial, value, i );
+			if( (i+1) == chunks ) break;
+			value = DaoMT_Evaluate( tasks, value, result->value->items.pValue[(i+1)*chunk-1] );
+		}
+		if( value == NULL ){
+			status = 1;
+			break;
+		}
+		if( chunks > 1 ) DaoMT_RunPhase( proc, tasks, threads, DaoMT_RunAggregation, chunk, 1 );
+		status = DaoMT_JoinStatus( tasks, threads );
+		break;
+	case DAO_MT_SORT :
+		source = items;
+		target = buffer;
+		for(width=chunk; width<count && status == 0; width*=2){
+			for(i=0; i<threads; i++){
+				tasks[i].source = source;
+				tasks[i].target = target;
+				tasks[i].width = width;
+			}
+			DaoMT_RunPhase( proc, tasks, threads, DaoMT_RunAggregation, 1, 1 );
+			status = DaoMT_JoinStatus( tasks, threads );
+			tmp = source;
+			source = target;
+			target = tmp;
+		}
+		if( source != items ) memcpy( items, source, count * sizeof(DaoValue*) );
+		break;
+	case DAO_MT_GROUP :
+		DaoMT_RunPhase( proc, tasks, threads, DaoMT_RunAggregation, 1, 1 );
+		status = DaoMT_JoinStatus( tasks, threads );
+		for(i=0; i<threads && status == 0; i++){
+			DMap *group = groups[i]->value;
+			for(it=DMap_First(group); it; it=DMap_Next(group,it)){
+				DaoMap_Insert( map, it->key.pValue, it->value.pValue );
+			}
+		}
+		break;
+	}
+
+	for(i=0; i<threads; i++) DaoVmSpace_ReleaseProcess( proc->vmSpace, tasks[i].clone );
+	if( status ) DaoProcess_RaiseError( proc, NULL, "code section execution failed!" );
+	DMutex_Destroy( & mutex );
+	DCondVar_Destroy( & condv );
+	if( buffer ) dao_free( buffer );
+	if( hashes ) dao_free( hashes );
+	if( buckets ) dao_free( buckets );
+	if( offsets ) dao_free( offsets );
+	if( groups ) dao_free( groups );
+	dao_free( tasks );
+}
 static void DaoMT_Start0( void *p )
 {
 	DaoProcess *proc = (DaoProcess*)p;
@@ -889,6 +1360,22 @@ static void DaoMT_MapFind( DaoProcess *proc, DaoValue *p[], int n )
 {
 	DaoMT_Functional( proc, p, n, DVM_FUNCT_FIND );
 }
+static void DaoMT_Reduce( DaoProcess *proc, DaoValue *p[], int n )
+{
+	DaoMT_Aggregate( proc, p, n, DAO_MT_REDUCE );
+}
+static void DaoMT_Scan( DaoProcess *proc, DaoValue *p[], int n )
+{
+	DaoMT_Aggregate( proc, p, n, DAO_MT_SCAN );
+}
+static void DaoMT_Sort( DaoProcess *proc, DaoValue *p[], int n )
+{
+	DaoMT_Aggregate( proc, p, n, DAO_MT_SORT );
+}
+static void DaoMT_Group( DaoProcess *proc, DaoValue *p[], int n )
+{
+	DaoMT_Aggregate( proc, p, n, DAO_MT_GROUP );
+}
 static void DaoMT_ArrayIterate( DaoProcess *proc, DaoValue *p[], int n )
 {
 	DaoMT_Functional( proc, p, n, DVM_FUNCT_ITERATE );
@@ -980,7 +1467,7 @@ DaoFunctionEntry dao_mt_methods[] =
 		"start( mode: enum<shared,exclusive> = $shared ) [ => @V|none] => Future<@V>"
 	},
 	{ DaoMT_Iterate,
-		"iterate( times: int, threads = 2 ) [index: int, threadid: int]"
+		"iterate( times: int, threads = 0 ) [index: int, threadid: int]"
 	},
 	{ DaoMT_Select,
 		"select( invar group: map<@T,int>, timeout = -1.0 )"
@@ -988,56 +1475,96 @@ DaoFunctionEntry dao_mt_methods[] =
 	},
 
 	{ DaoMT_ListIterate,
-		"iterate( alist: list<@T>, threads = 2 ) [item: @T, index: int, threadid: int]"
+		"iterate( alist: list<@T>, threads = 0 ) [item: @T, index: int, threadid: int]"
 	},
 	{ DaoMT_ListIterate,
-		"iterate( invar alist: list<@T>, threads = 2 )"
+		"iterate( invar alist: list<@T>, threads = 0 )"
 			"[invar item: @T, index: int, threadid: int]"
 	},
 	{ DaoMT_ListMap,
-		"map( invar alist: list<@T>, threads = 2 ) [item: @T, index: int, threadid: int => @V]"
+		"map( invar alist: list<@T>, threads = 0 ) [item: @T, index: int, threadid: int => @V]"
 			"=> list<@V>"
 	},
 	{ DaoMT_ListApply,
-		"apply( alist: list<@T>, threads = 2 ) [item: @T, index: int, threadid: int => @T]"
+		"apply( alist: list<@T>, threads = 0 ) [item: @T, index: int, threadid: int => @T]"
 	},
 	{ DaoMT_ListFind,
-		"find( invar alist: list<@T>, threads = 2 )"
+		"find( invar alist: list<@T>, threads = 0 )"
 			"[invar item: @T, index: int, threadid: int => int]"
 			"=> tuple<index: int, item: @T> | none"
 	},
 
+	{ DaoMT_Reduce,
+		"reduce( invar alist: list<@T>, threads = 0 ) [X: invar<@T>, Y: invar<@T> => @T] => @T|none"
+		/*
+		// Reduce the items by the code section, which must be associative,
+		// because the chunks of the list are reduced by different threads,
+		// before their results are reduced in the order of the chunks.
+		// If the list is empty, "none" will be returned.
+		*/
+	},
+	{ DaoMT_Scan,
+		"scan( invar alist: list<@T>, threads = 0 ) [X: invar<@T>, Y: invar<@T> => @T] => list<@T>"
+		/*
+		// Inclusive prefix scan of the items by the code section,
+		// which must be associative as in "reduce()".
+		*/
+	},
+	{ DaoMT_Sort,
+		"sort( alist: list<@T>, order: enum<ascend,descend> = $ascend, threads = 0 ) => list<@T>"
+		/*
+		// Stable parallel merge sort of the list in ascending or descending order.
+		*/
+	},
+	{ DaoMT_Sort,
+		"sort( alist: list<@T>, threads = 0 ) [X: @T, Y: @T => int] => list<@T>"
+		/*
+		// Stable parallel merge sort of the list by the code section,
+		// which produces a non-zero value if "X" is less than "Y".
+		*/
+	},
+	{ DaoMT_Group,
+		"group( invar alist: list<@T>, threads = 0 ) [item: invar<@T>, index: int => @K]"
+			"=> map<@K,list<@T>>"
+		/*
+		// Group the items by the keys produced by the code section.
+		// The items in each group are in the same order as in the list.
+		// The result is an ordered map, so the groups are ordered by their
+		// keys regardless of how the keys are partitioned among the threads.
+		*/
+	},
+
 	{ DaoMT_MapIterate,
-		"iterate( amap: map<@K,@V>, threads = 2 ) [key: @K, value: @V, threadid: int]"
+		"iterate( amap: map<@K,@V>, threads = 0 ) [key: @K, value: @V, threadid: int]"
 	},
 	{ DaoMT_MapIterate,
-		"iterate( invar amap: map<@K,@V>, threads = 2 )"
+		"iterate( invar amap: map<@K,@V>, threads = 0 )"
 			"[invar key: @K, invar value: @V, threadid: int]"
 	},
 	{ DaoMT_MapMap,
-		"map( invar amap: map<@K,@V>, threads = 2 ) [key: @K, value: @V, threadid: int => @T]"
+		"map( invar amap: map<@K,@V>, threads = 0 ) [key: @K, value: @V, threadid: int => @T]"
 			"=> list<@T>"
 	},
 	{ DaoMT_MapApply,
-		"apply( amap: map<@K,@V>, threads = 2 ) [key: @K, value: @V, threadid: int => @V]"
+		"apply( amap: map<@K,@V>, threads = 0 ) [key: @K, value: @V, threadid: int => @V]"
 	},
 	{ DaoMT_MapFind,
-		"find( invar amap: map<@K,@V>, threads = 2 )"
+		"find( invar amap: map<@K,@V>, threads = 0 )"
 			"[invar key: @K, invar value: @V, threadid: int => int]"
 			"=> tuple<key: @K, value: @V>|none"
 	},
 
 	{ DaoMT_ArrayIterate,
-		"iterate( invar aarray: array<@T>, threads = 2 )"
+		"iterate( invar aarray: array<@T>, threads = 0 )"
 			"[item: @T, I: int, J: int, K: int, L: int, M: int, threadid: int]"
 	},
 	{ DaoMT_ArrayMap,
-		"map( invar aarray: array<@T>, threads = 2 )"
+		"map( invar aarray: array<@T>, threads = 0 )"
 			"[item: @T, I: int, J: int, K: int, L: int, M: int, threadid: int => @T2]"
 			"=> array<@T2>"
 	},
 	{ DaoMT_ArrayApply,
-		"apply( aarray: array<@T>, threads = 2 )"
+		"apply( aarray: array<@T>, threads = 0 )"
 			"[item: @T, I: int, J: int, K: int, L: int, M: int, threadid: int => @T]"
 	},
 	{ NULL, NULL }
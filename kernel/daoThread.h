@@ -123,6 +123,8 @@ struct DThread
 	DThreadData     *thdSpecData;
 	DThreadCleanUp   cleaner;
 
+	DaoProcess      *process;  /* process running on the thread (by DaoProcess_Start()); */
+
 	/*
 	// In windows, condv will signal when the thread need to be cancelled,
 	// used to emulate pthread:
@@ -138,6 +140,9 @@ DAO_DLL int DThread_Start( DThread *self, DThreadTask task, void *arg );
 DAO_DLL void DThread_Exit( DThread *self );
 DAO_DLL void DThread_Join( DThread *self );
 
+/* Number of online processors, at least one: */
+DAO_DLL int DThread_GetProcessorCount();
+
 /*
 // In a foreign thead, when DThread_GetCurrent() is called,
 // a new DThread object will be created for that foreign thread.
@@ -167,6 +172,18 @@ typedef int DThread;
 #endif /* DAO_WITH_THREAD */
 
 
+/*
+// Atomic update of integer counters, returning the updated value:
+*/
+#if defined( DAO_WITH_THREAD ) && defined( __GNUC__ )
+#define DAtomic_Add( counter, n )  __sync_add_and_fetch( counter, n )
+#elif defined( DAO_WITH_THREAD ) && defined( WIN32 )
+#define DAtomic_Add( counter, n )  (InterlockedExchangeAdd( (LONG volatile*)(counter), n ) + (n))
+#else
+#define DAtomic_Add( counter, n )  (*(counter) += (n))
+#endif
+
+
 
 
 #endif
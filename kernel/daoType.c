@@ -1326,7 +1326,7 @@ int DaoType_MatchValueX( DaoType *self, DaoValue *value, DMap *defs, int mode )
 		/* generic "type"; */
 		if( self->args == NULL || self->args->size == 0 ) return DAO_MT_SUBX;
 		mt = DaoType_MatchTo( tp, self->args->items.pType[0], defs );
-		if( mt >= DAO_MT_EQ ) return mt;
+		if( mt >= DAO_MT_THT ) return mt; /* DAO_MT_THT for "type<@T>"; */
 		return 0;
 	case DAO_PAR_NAMED :
 	case DAO_PAR_DEFAULT :
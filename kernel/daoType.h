@@ -283,5 +283,8 @@ extern DaoTypeCore  daoStreamCore;
 extern DaoTypeCore  daoFutureCore;
 extern DaoTypeCore  daoChannelCore;
 
+extern DaoTypeCore  daoRopeCore;
+extern DaoTypeCore  daoTableCore;
+
 
 #endif
@@ -685,7 +685,8 @@ int DaoValue_Move5( DaoValue *S, DaoValue **D, DaoType *T, DaoType *C, DMap *def
 		return DaoValue_MoveVariant( S, D, T, C );
 	default : break;
 	}
-	if( S->type >= DAO_OBJECT || !(S->xBase.trait & DAO_VALUE_CONST) || T->invar ){
+	/* Inline values are stored in their owners, and are copied like constants: */
+	if( S->type >= DAO_OBJECT || !(S->xBase.trait & (DAO_VALUE_CONST|DAO_VALUE_INLINE)) || T->invar ){
 		if( DaoValue_FastMatchTo( S, T ) ){
 			if( S->type == DAO_CDATA && S->xCdata.data == NULL ){
 				if( ! DaoType_IsNullable( T ) ) return 0;
@@ -105,6 +105,14 @@ DAO_DLL void DaoValue_Clear( DaoValue **self );
 DAO_DLL int DaoValue_Compare( DaoValue *left, DaoValue *right );
 DAO_DLL int DaoValue_CompareExt( DaoValue *left, DaoValue *right, DMap *cycmap );
 
+/*
+// Values of primitive types may be stored inline in their owners (see
+// DAO_VALUE_INLINE), such as the instance variables of class instances.
+// Pointers to such values are borrowed: they are valid only until the
+// owner is freed, and reflect later assignments to the variable. They must
+// be copied (with DaoValue_Copy(), DaoValue_Move() or DaoValue_SimpleCopy())
+// to be kept; simply increasing their reference counts does not keep them.
+*/
 DAO_DLL void DaoValue_Copy( DaoValue *src, DaoValue **dest );
 DAO_DLL void DaoValue_CopyX( DaoValue *src, DaoValue **dest, DaoType *cst );
 DAO_DLL void DaoValue_MoveCstruct( DaoValue *S, DaoValue **D, int nocopying );
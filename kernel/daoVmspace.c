@@ -581,6 +581,8 @@ DaoVmSpace* DaoVmSpace_New()
 	self->userData = DHash_New(0,0);
 	self->typeKernels = DHash_New(0,0);
 	self->cdataWrappers = DHash_New(0,0);
+	self->regexCache = DHash_New( DAO_DATA_STRING, 0 );
+	self->internTable = DHash_New( DAO_DATA_STRING, 0 );
 	self->pathWorking = DString_New();
 	self->nameLoading = DList_New( DAO_DATA_STRING );
 	self->pathLoading = DList_New( DAO_DATA_STRING );
@@ -700,6 +702,9 @@ static void DaoVmSpace_DeleteData( DaoVmSpace *self )
 	for(it=DMap_First(self->vfiles); it; it=DMap_Next(self->vfiles,it)){
 		DaoVirtualFile_Delete( (DaoVirtualFile*) it->value.pVoid );
 	}
+	for(it=DMap_First(self->regexCache); it; it=DMap_Next(self->regexCache,it)){
+		DaoRegex_Delete( (DaoRegex*) it->value.pVoid );
+	}
 	DaoAux_Delete( self->userData );
 	GC_DecRC( self->daoNamespace );
 	GC_DecRC( self->mainNamespace );
@@ -733,6 +738,8 @@ static void DaoVmSpace_DeleteData( DaoVmSpace *self )
 	DMap_Delete( self->allByteCoders );
 	DMap_Delete( self->allInferencers );
 	DMap_Delete( self->allOptimizers );
+	DMap_Delete( self->regexCache );
+	DMap_Delete( self->internTable );
 	GC_DecRC( self->mainProcess );
 	self->stdioStream = NULL;
 }
@@ -839,6 +846,73 @@ void DaoVmSpace_UnlockCache( DaoVmSpace *self )
 #endif
 }
 
+/*
+// Compiled patterns are shared by all processes through the VM space cache,
+// but matching stores states in the pattern items, so the processes must
+// match with their own copies of the shared patterns.
+*/
+DaoRegex* DaoVmSpace_FindRegex( DaoVmSpace *self, DString *src )
+{
+	DaoRegex *pat = NULL;
+	DNode *node;
+
+	DaoVmSpace_LockCache( self );
+	node = DMap_Find( self->regexCache, src );
+	self->regexHits += node != NULL;
+	self->regexMisses += node == NULL;
+	if( node != NULL ){
+		pat = DaoRegex_Duplicate( (DaoRegex*) node->value.pVoid );
+		/* Move to the end of the insertion order as the most recently used: */
+		if( node != self->regexCache->last ){
+			void *shared = node->value.pVoid;
+			DMap_EraseNode( self->regexCache, node );
+			DMap_Insert( self->regexCache, src, shared );
+		}
+	}
+	DaoVmSpace_UnlockCache( self );
+	return pat;
+}
+void DaoVmSpace_AddRegex( DaoVmSpace *self, DString *src, DaoRegex *pat )
+{
+	DNode *node;
+
+	DaoVmSpace_LockCache( self );
+	node = DMap_Find( self->regexCache, src );
+	if( node == NULL ){
+		DMap_Insert( self->regexCache, src, DaoRegex_Duplicate( pat ) );
+		/* Evict the least recently used, which come first in the insertion order: */
+		while( self->regexCache->size > DAO_REGEX_CACHE ){
+			node = DMap_First( self->regexCache );
+			DaoRegex_Delete( (DaoRegex*) node->value.pVoid );
+			DMap_EraseNode( self->regexCache, node );
+		}
+	}
+	DaoVmSpace_UnlockCache( self );
+}
+/*
+// Make the string share the buffer of its canonical instance. The canonical
+// instances are created with precomputed hash values for the default seed.
+// Once the table is full, new strings are left as they are, so that interning
+// strings from untrusted input cannot exhaust the memory;
+*/
+void DaoVmSpace_InternString( DaoVmSpace *self, DString *str )
+{
+	DNode *node;
+
+	if( str->sharing == 0 ) return;
+
+	DaoVmSpace_LockCache( self );
+	node = DMap_Find( self->internTable, str );
+	if( node == NULL && self->internTable->size < DAO_STRING_INTERN_LIMIT ){
+		/* Short strings are copied into inline buffers unless kept on the heap: */
+		node = DMap_Insert( self->internTable, str, NULL );
+		DString_MakeShareable( node->key.pString );
+		DString_CacheHash( node->key.pString, DAO_HASH_SEED );
+	}
+	if( node != NULL ) DString_Assign( str, node->key.pString );
+	DaoVmSpace_UnlockCache( self );
+}
+
 int DaoDecodeUInt16( const char *data )
 {
 	const uchar_t *p = (const uchar_t*) data;
@@ -1636,7 +1710,7 @@ static void DaoVmSpace_SaveArchive( DaoVmSpace *self, DList *argValues )
 			if( it == NULL ){
 				it = DMap_Insert( archives, group, group );
 				it2 = DMap_Insert( counts, group, 0 );
-				it->value.pString->size = 0;
+				DString_Reset( it->value.pString, 0 );
 			}
 			archsource = it->value.pString;
 			it2->value.pInt += 1;
@@ -1968,13 +2042,17 @@ int DaoVmSpace_CompleteModuleName( DaoVmSpace *self, DString *fname, int lib )
 			if( DaoVmSpace_SearchModulePath( self, fname, lib ) ) modtype = DAO_MODULE_ANY;
 		}else if( modtype == DAO_MODULE_DAC ){
 			size_t tmdac = Dao_FileChangedTime( fname->chars );
+			DString_Detach( fname, fname->size );
 			fname->chars[ fname->size - 1 ] = 'o';  /* .dac to .dao; */
 			if( DaoVmSpace_TestFile( self, fname ) ){
 				size_t tmdao = Dao_FileChangedTime( fname->chars );
 				/* Check if the source file has been changed: */
 				if( tmdac < tmdao ) modtype = DAO_MODULE_DAO;
 			}
-			if( modtype == DAO_MODULE_DAC ) fname->chars[ fname->size - 1 ] = 'c';
+			if( modtype == DAO_MODULE_DAC ){
+				DString_Detach( fname, fname->size );
+				fname->chars[ fname->size - 1 ] = 'c';
+			}
 		}
 		DString_Delete( fn );
 		DString_Delete( path );
@@ -2380,8 +2458,7 @@ int DaoVmSpace_SearchModulePath( DaoVmSpace *self, DString *fname, int lib )
 	DString_Change( fname, "[^%./] + / %. %. /", "", 0 );
 	/* erase the last '/' */
 	if( fname->size && fname->chars[ fname->size-1 ] =='/' ){
-		fname->size --;
-		fname->chars[ fname->size ] = 0;
+		DString_Reset( fname, fname->size - 1 );
 	}
 
 	/* C:\dir\source.dao; /home/...  */
@@ -2615,7 +2692,7 @@ extern void DaoType_Init();
 
 
 #ifdef DAO_WITH_THREAD
-extern DMutex mutex_string_sharing;
+extern DMutex mutex_string_aux;
 extern DMutex mutex_type_map;
 extern DMutex mutex_values_setup;
 extern DMutex mutex_methods_setup;
@@ -2790,6 +2867,8 @@ void DaoVmSpace_InitStdTypes( DaoVmSpace *self )
 
 	NS = DaoVmSpace_GetNamespace( self, "std" );
 	DaoNamespace_AddConstValue( daoNS, "std", (DaoValue*) NS );
+	self->typeRope = DaoNamespace_WrapType( NS, & daoRopeCore, DAO_CSTRUCT, 0 );
+	self->typeTable = DaoNamespace_WrapType( NS, & daoTableCore, DAO_CSTRUCT, 0 );
 	DaoNamespace_WrapFunctions( NS, dao_std_methods );
 
 	DaoNamespace_UpdateLookupTable( self->mainNamespace );
@@ -2806,7 +2885,7 @@ DaoVmSpace* DaoInit( const char *command )
 	/* signal( SIGABRT, print_trace ); */
 
 #ifdef DAO_WITH_THREAD
-	DMutex_Init( & mutex_string_sharing );
+	DMutex_Init( & mutex_string_aux );
 	DMutex_Init( & mutex_type_map );
 	DMutex_Init( & mutex_values_setup );
 	DMutex_Init( & mutex_methods_setup );
@@ -2908,7 +2987,7 @@ void DaoQuit()
 		dao_jit.Execute = NULL;
 	}
 #ifdef DAO_WITH_THREAD
-	DMutex_Destroy( & mutex_string_sharing );
+	DMutex_Destroy( & mutex_string_aux );
 	DMutex_Destroy( & mutex_type_map );
 	DMutex_Destroy( & mutex_values_setup );
 	DMutex_Destroy( & mutex_methods_setup );
@@ -137,6 +137,22 @@ struct DaoVmSpace
 
 	DMap   *cdataWrappers;  /* VM space unique wrappers for Cdata objects; */
 
+	/*
+	// Compiled regular expressions shared by all processes (guarded by cacheMutex),
+	// ordered from the least to the most recently used;
+	*/
+	DMap   *regexCache;    /* <DString*,DaoRegex*> */
+	dao_integer  regexHits;    /* lookups found in regexCache; */
+	dao_integer  regexMisses;  /* lookups not found in regexCache; */
+
+	/*
+	// Canonical instances of interned strings (guarded by cacheMutex):
+	// Interned strings share their buffers with the keys of this map,
+	// so that comparing them with each other reduces to pointer comparison;
+	// The table holds at most DAO_STRING_INTERN_LIMIT strings;
+	*/
+	DMap   *internTable;   /* <DString*,0> */
+
 	DMap   *allProcesses;
 	DMap   *allRoutines;
 	DMap   *allParsers;
@@ -184,6 +200,8 @@ struct DaoVmSpace
 	DaoType  *typeFuture;
 	DaoType  *typeChannel;
 	DaoType  *typeStream;
+	DaoType  *typeRope;
+	DaoType  *typeTable;
 	DaoType  *typeIODevice;
 	DaoType  *typeArrays[DAO_COMPLEX+1];
 
@@ -216,6 +234,11 @@ DAO_DLL void DaoVmSpace_Unlock( DaoVmSpace *self );
 DAO_DLL void DaoVmSpace_LockCache( DaoVmSpace *self );
 DAO_DLL void DaoVmSpace_UnlockCache( DaoVmSpace *self );
 
+DAO_DLL DaoRegex* DaoVmSpace_FindRegex( DaoVmSpace *self, DString *src );
+DAO_DLL void DaoVmSpace_AddRegex( DaoVmSpace *self, DString *src, DaoRegex *pat );
+
+DAO_DLL void DaoVmSpace_InternString( DaoVmSpace *self, DString *str );
+
 DAO_DLL int DaoVmSpace_ParseOptions( DaoVmSpace *self, const char *options );
 
 DAO_DLL int DaoVmSpace_RunMain( DaoVmSpace *self, const char *file );
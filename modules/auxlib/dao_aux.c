@@ -45,6 +45,7 @@
 void name( DaoArray *self, type *vec, daoint N ) \
 { \
 	daoint i; \
+	if( self->stype ) DaoArray_SetNumType( self, self->etype ); \
 	if( vec && N == 0 ){ \
 		DaoArray_UseData( self, vec ); \
 		return; \
@@ -79,6 +80,7 @@ void name( DaoArray *self, type **mat, daoint R, daoint C ) \
 	daoint dm[2]; \
 	daoint i, N = R * C; \
 	dm[0] = R; dm[1] = C; \
+	if( self->stype ) DaoArray_SetNumType( self, self->etype ); \
 	if( N != self->size ) DaoArray_ResizeData( self, N, self->size ); \
 	DaoArray_Reshape( self, dm, 2 ); \
 	switch( self->etype ){ \
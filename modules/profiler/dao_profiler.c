@@ -40,11 +40,26 @@
 #  include <crt_externs.h>
 #endif
 
+#ifdef UNIX
+#  include<signal.h>
+#  define DAOX_WITH_SAMPLING
+#endif
+
+#if defined( __GNUC__ )
+#  define DaoxMemoryBarrier()  __sync_synchronize()
+#else
+#  define DaoxMemoryBarrier()
+#endif
+
 
 static void DaoProfiler_Reset( DaoProfiler *self );
 static void DaoProfiler_EnterFrame( DaoProfiler *self, DaoProcess *, DaoStackFrame *, int );
 static void DaoProfiler_LeaveFrame( DaoProfiler *self, DaoProcess *, DaoStackFrame *, int );
 static void DaoProfiler_Report( DaoProfiler *self0, DaoStream *stream );
+#ifdef DAOX_WITH_SAMPLING
+static void DaoxProfiler_StopSampling( DaoxProfiler *self );
+static void DaoxProfiler_Unpin( DaoxProfiler *self );
+#endif
 
 DaoxProfiler* DaoxProfiler_New()
 {
@@ -60,6 +75,20 @@ DaoxProfiler* DaoxProfiler_New()
 }
 void DaoxProfiler_Delete( DaoxProfiler *self )
 {
+#ifdef DAOX_WITH_SAMPLING
+	DaoxProfiler_StopSampling( self );
+	if( self->names ){
+		DaoxProfiler_Unpin( self );
+		DMap_Delete( self->names );
+		DMap_Delete( self->signatures );
+	}
+#endif
+	if( self->ring ) dao_free( self->ring );
+	if( self->folded ) DMap_Delete( self->folded );
+	if( self->lines ) DMap_Delete( self->lines );
+	if( self->selfs ) DMap_Delete( self->selfs );
+	if( self->totals ) DMap_Delete( self->totals );
+	if( self->output ) DString_Delete( self->output );
 	DMutex_Destroy( & self->mutex );
 	DMap_Delete( self->profile );
 	DMap_Delete( self->one );
@@ -69,6 +98,17 @@ void DaoProfiler_Reset( DaoProfiler *self0 )
 {
 	DaoxProfiler *self = (DaoxProfiler*) self0;
 	DMap_Clear( self->profile );
+#ifdef DAO_WITH_VMSTATS
+	DaoVmStats_Reset();
+#endif
+	if( self->frequency == 0 ) return;
+	DMutex_Lock( & self->mutex );
+	DMap_Clear( self->folded );
+	DMap_Clear( self->lines );
+	DMap_Clear( self->selfs );
+	DMap_Clear( self->totals );
+	self->count = self->lost = 0;
+	DMutex_Unlock( & self->mutex );
 }
 static void DaoxProfiler_Update( DaoxProfiler *self, DaoStackFrame *frame, double time )
 {
@@ -146,6 +186,304 @@ static void DaoProfiler_LeaveFrame( DaoProfiler *self, DaoProcess *proc, DaoStac
 	if( end ) DaoxProfiler_Update( (DaoxProfiler*) self, frame, tmdata->value.real );
 }
 
+
+
+/*
+// Sampling mode:
+//
+// A profiling timer delivers SIGPROF to the threads that consume CPU time.
+// The handler looks up the process running on the interrupted thread, and
+// copies the routines and line numbers of its frame chain into a slot of
+// the sample ring. The frame hooks record which process is running on each
+// thread, and drain the ring into the folded stack counts when it is half
+// full. No locking or allocation is done in the signal handler.
+//
+// A sampled routine may be a closure that is freed before the sample is
+// drained. So the handler records only keys of the routines, and the frame
+// hooks hold references to the keys of the entered routines and store their
+// names, which are used to resolve the samples when they are drained.
+*/
+#ifdef DAOX_WITH_SAMPLING
+
+static DaoxProfiler *daox_sampler = NULL;
+
+static size_t DaoxSampler_ThreadID()
+{
+#ifdef DAO_WITH_THREAD
+	return (size_t) pthread_self();
+#else
+	return 1;
+#endif
+}
+
+static DaoxSampleThread* DaoxProfiler_FindThread( DaoxProfiler *self, size_t id )
+{
+	int i, k = (id >> 4) % DAOX_SAMPLE_THREADS;
+	for(i=0; i<DAOX_SAMPLE_THREADS; ++i){
+		DaoxSampleThread *slot = self->threads + (k + i) % DAOX_SAMPLE_THREADS;
+		if( slot->thread == id ) return slot;
+		if( slot->thread == 0 ) return NULL;
+	}
+	return NULL;
+}
+static DaoxSampleThread* DaoxProfiler_GetThread( DaoxProfiler *self )
+{
+	size_t id = DaoxSampler_ThreadID();
+	DaoxSampleThread *slot = DaoxProfiler_FindThread( self, id );
+	int i, k = (id >> 4) % DAOX_SAMPLE_THREADS;
+
+	if( slot ) return slot;
+
+	/* Slots are never released, so a free slot ends the probing sequence: */
+	DMutex_Lock( & self->mutex );
+	for(i=0; i<DAOX_SAMPLE_THREADS; ++i){
+		DaoxSampleThread *it = self->threads + (k + i) % DAOX_SAMPLE_THREADS;
+		if( it->thread == id || it->thread == 0 ){
+			it->process = NULL;
+			DaoxMemoryBarrier();
+			it->thread = id;
+			slot = it;
+			break;
+		}
+	}
+	DMutex_Unlock( & self->mutex );
+	return slot;
+}
+
+/*
+// Closures share the bodies of their prototype routines, so the routines are
+// identified by their bodies. C functions are identified by themselves:
+*/
+static void* DaoxSample_RoutineKey( DaoRoutine *routine )
+{
+	while( routine->original ) routine = routine->original;
+	if( routine->body ) return routine->body;
+	return routine;
+}
+
+static void DaoxProfiler_Sample( int signum )
+{
+	DaoxProfiler *self = daox_sampler;
+	DaoxSampleThread *slot;
+	DaoStackFrame *frame;
+	DaoxSample *sample;
+	DaoProcess *proc;
+	int pos, depth = 0;
+
+	if( self == NULL ) return;
+	slot = DaoxProfiler_FindThread( self, DaoxSampler_ThreadID() );
+	if( slot == NULL || (proc = slot->process) == NULL ) return;
+
+	pos = DAtomic_Add( & self->head, 1 ) - 1;
+	sample = self->ring + (pos & (DAOX_SAMPLE_RING - 1));
+	if( sample->ready ){
+		DAtomic_Add( & self->lost, 1 );
+		return;
+	}
+	sample->truncated = 0;
+	for(frame=proc->topFrame; frame && frame->routine; frame=frame->prev){
+		DaoRoutine *routine = frame->routine;
+		int line = 0;
+		if( depth >= DAOX_SAMPLE_DEPTH ){
+			sample->truncated = 1;
+			break;
+		}
+		if( routine->body ){
+			DList *annots = routine->body->annotCodes;
+			/*
+			// The caller frames have @entry pointing past the calling instruction;
+			// the top frame is at the most recently published instruction:
+			*/
+			daoint k = frame->entry - 1;
+			if( frame == proc->topFrame ) k = proc->activeCode - frame->codes;
+			if( k >= 0 && k < annots->size ) line = annots->items.pVmc[k]->line;
+		}
+		sample->routines[depth] = DaoxSample_RoutineKey( routine );
+		sample->lines[depth] = line;
+		depth += 1;
+	}
+	sample->depth = depth;
+	DaoxMemoryBarrier();
+	sample->ready = depth > 0;
+}
+
+static void DaoxProfiler_Count( DMap *counts, void *key )
+{
+	DNode *it = DMap_Find( counts, key );
+	if( it == NULL ) it = DMap_Insert( counts, key, NULL );
+	it->value.pInt += 1;
+}
+
+/*
+// Hold a reference to the routine key, and store the names of the routine,
+// so that the samples of the routine can be resolved after it is freed:
+*/
+static void DaoxProfiler_Pin( DaoxProfiler *self, DaoxSampleThread *slot, DaoRoutine *routine )
+{
+	void *key = DaoxSample_RoutineKey( routine );
+	int k = (((size_t) key) >> 4) % DAOX_SAMPLE_PINS;
+	DString *name;
+
+	if( slot != NULL && slot->pinned[k] == key ) return;
+
+	DMutex_Lock( & self->mutex );
+	if( DMap_Find( self->names, key ) == NULL ){
+		while( routine->original ) routine = routine->original;
+		name = DString_New();
+		GC_IncRC( key );
+		DaoRoutine_MakeName( routine, name, 40, 0, 0 );
+		DMap_Insert( self->names, key, name );
+		DaoRoutine_MakeName( routine, name, 38, 10, 2 );
+		DMap_Insert( self->signatures, key, name );
+		DString_Delete( name );
+	}
+	DMutex_Unlock( & self->mutex );
+	if( slot != NULL ) slot->pinned[k] = key;
+}
+
+/* Release the routine keys and their names, after the samples are reported: */
+static void DaoxProfiler_Unpin( DaoxProfiler *self )
+{
+	DNode *it;
+	int i;
+
+	for(it=DMap_First(self->names); it; it=DMap_Next(self->names,it)){
+		GC_DecRC( it->key.pValue );
+	}
+	DMap_Reset( self->names );
+	DMap_Reset( self->signatures );
+	DMap_Reset( self->selfs );
+	DMap_Reset( self->totals );
+	for(i=0; i<DAOX_SAMPLE_THREADS; ++i){
+		memset( self->threads[i].pinned, 0, DAOX_SAMPLE_PINS*sizeof(void*) );
+	}
+}
+
+static void DaoxProfiler_Drain( DaoxProfiler *self )
+{
+	DString *stack = DString_New();
+	DString *name = DString_New();
+	DString unknown = DString_WrapChars( "[unknown]" );
+	char buf[32];
+	int i, j, k;
+
+	self->drained = self->head;
+	for(i=0; i<DAOX_SAMPLE_RING; ++i){
+		DaoxSample *sample = self->ring + i;
+		DNode *it;
+		if( sample->ready == 0 ) continue;
+		DaoxMemoryBarrier();
+
+		DString_Reset( stack, 0 );
+		if( sample->truncated ) DString_AppendChars( stack, "[truncated]" );
+		for(j=sample->depth-1; j>=0; --j){
+			/* Routines not entered through the frame hooks are unknown: */
+			it = DMap_Find( self->names, sample->routines[j] );
+			/* Count each routine once per sample for recursive calls: */
+			for(k=j+1; k<sample->depth; ++k){
+				if( sample->routines[k] == sample->routines[j] ) break;
+			}
+			if( it && k == sample->depth ) DaoxProfiler_Count( self->totals, it->key.pVoid );
+
+			if( stack->size ) DString_AppendChar( stack, ';' );
+			DString_Append( stack, it ? it->value.pString : & unknown );
+			if( sample->lines[j] ){
+				snprintf( buf, sizeof(buf), ":%i", sample->lines[j] );
+				DString_AppendChars( stack, buf );
+			}
+		}
+		it = DMap_Find( self->names, sample->routines[0] );
+		DaoxProfiler_Count( self->folded, stack );
+		if( it ) DaoxProfiler_Count( self->selfs, it->key.pVoid );
+		if( it && sample->lines[0] ){
+			DString_Assign( name, it->value.pString );
+			snprintf( buf, sizeof(buf), "\t%i", sample->lines[0] );
+			DString_AppendChars( name, buf );
+			DaoxProfiler_Count( self->lines, name );
+		}
+		self->count += 1;
+
+		DaoxMemoryBarrier();
+		sample->ready = 0;
+	}
+	DString_Delete( stack );
+	DString_Delete( name );
+}
+
+static void DaoxProfiler_EnterSampled( DaoProfiler *self0, DaoProcess *proc, DaoStackFrame *frame, int start )
+{
+	DaoxProfiler *self = (DaoxProfiler*) self0;
+	DaoxSampleThread *slot = DaoxProfiler_GetThread( self );
+
+	if( frame->routine ) DaoxProfiler_Pin( self, slot, frame->routine );
+
+	/* Entering the auxiliary first frame means the process has finished: */
+	if( slot ) slot->process = frame->routine ? proc : NULL;
+
+	if( (self->head - self->drained) < DAOX_SAMPLE_RING/2 ) return;
+	DMutex_Lock( & self->mutex );
+	if( (self->head - self->drained) >= DAOX_SAMPLE_RING/2 ) DaoxProfiler_Drain( self );
+	DMutex_Unlock( & self->mutex );
+}
+static void DaoxProfiler_LeaveSampled( DaoProfiler *self0, DaoProcess *proc, DaoStackFrame *frame, int end )
+{
+	DaoxProfiler *self = (DaoxProfiler*) self0;
+	DaoxSampleThread *slot;
+
+	/* A suspended process may be deleted before the thread enters another frame: */
+	if( end || proc->status != DAO_PROCESS_SUSPENDED ) return;
+	slot = DaoxProfiler_FindThread( self, DaoxSampler_ThreadID() );
+	if( slot && slot->process == proc ) slot->process = NULL;
+}
+
+static void DaoxProfiler_SetTimer( int frequency )
+{
+	struct itimerval timer;
+	int usec = frequency ? 1000000 / frequency : 0;
+	timer.it_interval.tv_sec = usec / 1000000;
+	timer.it_interval.tv_usec = usec % 1000000;
+	timer.it_value = timer.it_interval;
+	setitimer( ITIMER_PROF, & timer, NULL );
+}
+
+static int DaoxProfiler_StartSampling( DaoxProfiler *self, int frequency )
+{
+	struct sigaction action;
+
+	if( daox_sampler != NULL ) return 0;
+	if( frequency <= 0 || frequency > 100000 ) frequency = 1000;
+
+	memset( & action, 0, sizeof(action) );
+	action.sa_handler = DaoxProfiler_Sample;
+	action.sa_flags = SA_RESTART;
+	sigemptyset( & action.sa_mask );
+	if( sigaction( SIGPROF, & action, NULL ) != 0 ) return 0;
+
+	self->ring = (DaoxSample*) dao_calloc( DAOX_SAMPLE_RING, sizeof(DaoxSample) );
+	self->folded = DHash_New( DAO_DATA_STRING, 0 );
+	self->lines = DHash_New( DAO_DATA_STRING, 0 );
+	self->selfs = DHash_New( 0, 0 );
+	self->totals = DHash_New( 0, 0 );
+	self->names = DHash_New( 0, DAO_DATA_STRING );
+	self->signatures = DHash_New( 0, DAO_DATA_STRING );
+	self->frequency = frequency;
+	self->base.EnterFrame = DaoxProfiler_EnterSampled;
+	self->base.LeaveFrame = DaoxProfiler_LeaveSampled;
+
+	daox_sampler = self;
+	DaoxProfiler_SetTimer( frequency );
+	return 1;
+}
+static void DaoxProfiler_StopSampling( DaoxProfiler *self )
+{
+	if( daox_sampler != self ) return;
+	DaoxProfiler_SetTimer( 0 );
+	signal( SIGPROF, SIG_IGN );
+	daox_sampler = NULL;
+}
+
+#endif /* DAOX_WITH_SAMPLING */
+
 dao_complex DaoProfiler_Sum( DMap *profile )
 {
 	DNode *it2;
@@ -203,6 +541,8 @@ void DaoRoutine_MakeName( DaoRoutine *self, DString *name, int max1, int max2, i
 	// These methods still have the DAO_ROUT_INITOR flag. So checking the names is
 	// the better way to use here.
 	*/
+	/* The names of the implicit class constructors are already qualified: */
+	if( DString_FindChars( self->routName, "::", 0 ) != DAO_NULLPOS ) hostName = NULL;
 	if( hostName && ! DString_EQ( self->routName, hostName ) ){
 		if( hostName->size + self->routName->size < (max1-2) ){
 			DString_Append( name, hostName );
@@ -239,6 +579,237 @@ void DaoRoutine_MakeName( DaoRoutine *self, DString *name, int max1, int max2, i
 	DString_AppendChars( name, " )" );
 }
 
+#ifdef DAOX_WITH_SAMPLING
+
+typedef struct DaoxCount DaoxCount;
+struct DaoxCount
+{
+	DNode   *node;
+	daoint   count;
+	daoint   count2;
+};
+
+static int DaoxCount_Compare( const void *p1, const void *p2 )
+{
+	const DaoxCount *c1 = (const DaoxCount*) p1;
+	const DaoxCount *c2 = (const DaoxCount*) p2;
+	if( c1->count != c2->count ) return c1->count < c2->count ? 1 : -1;
+	if( c1->count2 != c2->count2 ) return c1->count2 < c2->count2 ? 1 : -1;
+	return 0;
+}
+/* Sort the entries of a count map by descending counts: */
+static DaoxCount* DaoxProfiler_Sort( DMap *counts )
+{
+	DaoxCount *items = (DaoxCount*) dao_calloc( counts->size + 1, sizeof(DaoxCount) );
+	DNode *it;
+	daoint i = 0;
+	for(it=DMap_First(counts); it; it=DMap_Next(counts,it), ++i){
+		items[i].node = it;
+		items[i].count = it->value.pInt;
+	}
+	qsort( items, counts->size, sizeof(DaoxCount), DaoxCount_Compare );
+	return items;
+}
+
+static void DaoxProfiler_ReportSampled( DaoxProfiler *self, DaoStream *stream )
+{
+	DString *name = DString_New();
+	DaoxCount *items;
+	FILE *fout = NULL;
+	daoint i, count, max = 20;
+	char buf[160];
+
+	DaoxProfiler_StopSampling( self );
+	DMutex_Lock( & self->mutex );
+	DaoxProfiler_Drain( self );
+	count = self->count ? self->count : 1;
+
+	DaoStream_WriteChars( stream, "\n" );
+	snprintf( buf, sizeof(buf), "============== Program Profile (Sampled at %i Hz) ==============\n", self->frequency );
+	DaoStream_WriteChars( stream, buf );
+	snprintf( buf, sizeof(buf), "Samples: %" DAO_I64 ", lost: %i\n", (long long) self->count, self->lost );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter2 );
+	snprintf( buf, sizeof(buf), "%-48s: %8s, %8s, %8s\n", "Routine", "#Self", "#Total", "Self%" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter2 );
+	/* Order the routines by their self samples, then by their total samples: */
+	items = DaoxProfiler_Sort( self->totals );
+	for(i=0; i<self->totals->size; ++i){
+		DNode *it = DMap_Find( self->selfs, items[i].node->key.pVoid );
+		items[i].count2 = items[i].count;
+		items[i].count = it ? it->value.pInt : 0;
+	}
+	qsort( items, self->totals->size, sizeof(DaoxCount), DaoxCount_Compare );
+	for(i=0; i<self->totals->size && i<max; ++i){
+		DNode *it = DMap_Find( self->signatures, items[i].node->key.pVoid );
+		snprintf( buf, sizeof(buf), "%-48s: %8i, %8i, %8.2f\n", it->value.pString->chars, (int) items[i].count,
+				(int) items[i].count2, 100.0 * items[i].count / count );
+		DaoStream_WriteChars( stream, buf );
+	}
+	dao_free( items );
+
+	DaoStream_WriteChars( stream, "\n" );
+	DaoStream_WriteChars( stream, delimiter3 );
+	snprintf( buf, sizeof(buf), "%-48s: %8s, %8s, %8s\n", "Routine", "Line", "#Samples", "Percent" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter3 );
+	items = DaoxProfiler_Sort( self->lines );
+	for(i=0; i<self->lines->size && i<max; ++i){
+		DString *key = items[i].node->key.pString;
+		daoint pos = DString_FindChar( key, '\t', 0 );
+		DString_SubString( key, name, 0, pos );
+		snprintf( buf, sizeof(buf), "%-48s: %8s, %8i, %8.2f\n", name->chars, key->chars + pos + 1,
+				(int) items[i].count, 100.0 * items[i].count / count );
+		DaoStream_WriteChars( stream, buf );
+	}
+	dao_free( items );
+
+	/* Folded stacks, one stack per line followed by its count (for flame graph tools): */
+	if( self->output ){
+		fout = Dao_OpenFile( self->output->chars, "w" );
+		if( fout == NULL ){
+			DaoStream_WriteChars( stream, "\nFailed to open " );
+			DaoStream_WriteString( stream, self->output );
+			DaoStream_WriteChars( stream, " for the folded stacks!\n" );
+		}
+	}else{
+		DaoStream_WriteChars( stream, "\n" );
+		DaoStream_WriteChars( stream, delimiter3 );
+		DaoStream_WriteChars( stream, "Folded Stacks\n" );
+		DaoStream_WriteChars( stream, delimiter3 );
+	}
+	items = DaoxProfiler_Sort( self->folded );
+	for(i=0; i<self->folded->size && (self->output == NULL || fout != NULL); ++i){
+		DString *stack = items[i].node->key.pString;
+		if( fout ){
+			fprintf( fout, "%s %i\n", stack->chars, (int) items[i].count );
+		}else{
+			DaoStream_WriteString( stream, stack );
+			snprintf( buf, sizeof(buf), " %i\n", (int) items[i].count );
+			DaoStream_WriteChars( stream, buf );
+		}
+	}
+	dao_free( items );
+	if( fout ) fclose( fout );
+	DaoxProfiler_Unpin( self );
+	DMutex_Unlock( & self->mutex );
+	DString_Delete( name );
+}
+
+#endif /* DAOX_WITH_SAMPLING */
+
+#ifdef DAO_WITH_VMSTATS
+
+typedef struct DaoxOpcodeCount DaoxOpcodeCount;
+struct DaoxOpcodeCount
+{
+	short        prev;
+	short        code;
+	dao_integer  count;
+};
+
+static int DaoxOpcodeCount_Compare( const void *p1, const void *p2 )
+{
+	const DaoxOpcodeCount *c1 = (const DaoxOpcodeCount*) p1;
+	const DaoxOpcodeCount *c2 = (const DaoxOpcodeCount*) p2;
+	if( c1->count == c2->count ) return 0;
+	return c1->count < c2->count ? 1 : -1;
+}
+
+static void DaoxProfiler_ReportVmStats( DaoStream *stream )
+{
+	DaoVmStats *stats = DaoVmStats_Get();
+	DaoxOpcodeCount *items = (DaoxOpcodeCount*) dao_calloc( DVM_NULL*DVM_NULL, sizeof(DaoxOpcodeCount) );
+	dao_integer total = 0;
+	int i, j, count = 0, max = 20;
+	char buf[120];
+
+	for(i=0; i<DVM_NULL; ++i){
+		if( stats->counts[i] == 0 ) continue;
+		items[count].code = i;
+		items[count].count = stats->counts[i];
+		total += stats->counts[i];
+		count += 1;
+	}
+	if( total == 0 ) total = 1;
+	qsort( items, count, sizeof(DaoxOpcodeCount), DaoxOpcodeCount_Compare );
+
+	DaoStream_WriteChars( stream, "\n" );
+	DaoStream_WriteChars( stream, delimiter3 );
+	snprintf( buf, sizeof(buf), "%-32s: %16s, %8s, %16s\n", "Opcode", "#Executions", "Percent", "Cycles/Exec" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter3 );
+	for(i=0; i<count && i<max; ++i){
+		int code = items[i].code;
+		snprintf( buf, sizeof(buf), "%-32s: %16" DAO_I64 ", %8.2f, %16.1f\n", DaoVmCode_GetOpcodeName( code ),
+				(long long) items[i].count, 100.0 * items[i].count / total,
+				(double) stats->cycles[code] / items[i].count );
+		DaoStream_WriteChars( stream, buf );
+	}
+
+	for(i=0, count=0; i<DVM_NULL; ++i){
+		for(j=0; j<DVM_NULL; ++j){
+			if( stats->pairs[i][j] == 0 ) continue;
+			items[count].prev = i;
+			items[count].code = j;
+			items[count].count = stats->pairs[i][j];
+			count += 1;
+		}
+	}
+	qsort( items, count, sizeof(DaoxOpcodeCount), DaoxOpcodeCount_Compare );
+
+	DaoStream_WriteChars( stream, "\n" );
+	DaoStream_WriteChars( stream, delimiter3 );
+	snprintf( buf, sizeof(buf), "%-15s  %-15s: %16s, %8s\n", "Opcode", "Next Opcode", "#Executions", "Percent" );
+	DaoStream_WriteChars( stream, buf );
+	DaoStream_WriteChars( stream, delimiter3 );
+	for(i=0; i<count && i<max; ++i){
+		snprintf( buf, sizeof(buf), "%-15s  %-15s: %16" DAO_I64 ", %8.2f\n",
+				DaoVmCode_GetOpcodeName( items[i].prev ), DaoVmCode_GetOpcodeName( items[i].code ),
+				(long long) items[i].count, 100.0 * items[i].count / total );
+		DaoStream_WriteChars( stream, buf );
+	}
+	dao_free( items );
+}
+
+#else
+#define DaoxProfiler_ReportVmStats( stream )
+#endif
+
+/*
+// Allocation profile from the kernel (DAO_PROFILER=alloc), with the folded
+// stacks written to the DAO_PROFILER_OUTPUT file suffixed with ".alloc":
+*/
+static void DaoxProfiler_ReportAllocs( DaoxProfiler *self, DaoStream *stream )
+{
+	DString *folded = DString_New();
+	FILE *fout = NULL;
+
+	DaoGC_PrintProfile( stream, folded );
+	if( folded->size && self->output ){
+		DString *file = DString_Copy( self->output );
+		DString_AppendChars( file, ".alloc" );
+		fout = Dao_OpenFile( file->chars, "w" );
+		if( fout ){
+			fwrite( folded->chars, 1, folded->size, fout );
+			fclose( fout );
+		}else{
+			DaoStream_WriteChars( stream, "\nFailed to open " );
+			DaoStream_WriteString( stream, file );
+			DaoStream_WriteChars( stream, " for the folded stacks!\n" );
+		}
+		DString_Delete( file );
+	}else if( folded->size ){
+		DaoStream_WriteChars( stream, "\n" );
+		DaoStream_WriteChars( stream, delimiter3 );
+		DaoStream_WriteChars( stream, "Folded Allocation Stacks (Bytes)\n" );
+		DaoStream_WriteChars( stream, delimiter3 );
+		DaoStream_WriteString( stream, folded );
+	}
+	DString_Delete( folded );
+}
+
 void DaoProfiler_Report( DaoProfiler *self0, DaoStream *stream )
 {
 	DaoComplex com = {DAO_COMPLEX,0,0,0,1,{0.0,0.0}};
@@ -253,6 +824,15 @@ void DaoProfiler_Report( DaoProfiler *self0, DaoStream *stream )
 	char buf2[24];
 	char buf[120];
 
+#ifdef DAOX_WITH_SAMPLING
+	if( self->frequency ){
+		DaoxProfiler_ReportSampled( self, stream );
+		DaoxProfiler_ReportAllocs( self, stream );
+		DaoxProfiler_ReportVmStats( stream );
+		return;
+	}
+#endif
+
 	for(it=DMap_First(self->profile); it; it=DMap_Next(self->profile,it)){
 		DaoRoutine *callee = (DaoRoutine*) it->key.pValue;
 		com.value = DaoProfiler_Sum( it->value.pMap );
@@ -310,11 +890,35 @@ void DaoProfiler_Report( DaoProfiler *self0, DaoStream *stream )
 	}
 	DString_Delete( name1 );
 	DString_Delete( name2 );
+	DaoxProfiler_ReportAllocs( self, stream );
+	DaoxProfiler_ReportVmStats( stream );
 }
 
 DAO_DLL int DaoProfiler_OnLoad( DaoVmSpace *vmSpace, DaoNamespace *ns )
 {
 	DaoxProfiler *profiler = DaoxProfiler_New();
+	/*
+	// DAO_PROFILER is a comma separated list of the following options:
+	// -- sample[:frequency]: selects the sampling mode;
+	// -- alloc: profiles the allocations and GC pauses;
+	// DAO_PROFILER_OUTPUT=file writes the folded stacks to the file,
+	// and the folded allocation stacks to the file suffixed with ".alloc";
+	*/
+	const char *mode = getenv( "DAO_PROFILER" );
+	const char *output = getenv( "DAO_PROFILER_OUTPUT" );
+	if( output && output[0] ) profiler->output = DString_NewChars( output );
+	while( mode && *mode ){
+		const char *end = strchr( mode, ',' );
+		int size = end ? end - mode : strlen( mode );
+#ifdef DAOX_WITH_SAMPLING
+		if( size >= 6 && strncmp( mode, "sample", 6 ) == 0 ){
+			int frequency = mode[6] == ':' ? strtol( mode + 7, NULL, 10 ) : 0;
+			DaoxProfiler_StartSampling( profiler, frequency );
+		}
+#endif
+		if( size == 5 && strncmp( mode, "alloc", 5 ) == 0 ) DaoGC_SetProfiling( 1 );
+		mode = end ? end + 1 : NULL;
+	}
 	DaoVmSpace_SetProfiler( vmSpace, (DaoProfiler*) profiler );
 	return 0;
 }
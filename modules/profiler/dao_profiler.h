@@ -34,9 +34,38 @@
 #include "daoProcess.h"
 #include "daoNamespace.h"
 #include "daoVmspace.h"
+#include "daoGC.h"
 
 
-typedef struct DaoxProfiler DaoxProfiler;
+#define DAOX_SAMPLE_DEPTH    48    /* maximum number of frames recorded per sample; */
+#define DAOX_SAMPLE_RING     4096  /* capacity of the sample ring (power of two); */
+#define DAOX_SAMPLE_THREADS  256   /* maximum number of threads to be sampled; */
+#define DAOX_SAMPLE_PINS     64    /* size of the per-thread cache of pinned routines; */
+
+typedef struct DaoxSample        DaoxSample;
+typedef struct DaoxSampleThread  DaoxSampleThread;
+typedef struct DaoxProfiler      DaoxProfiler;
+
+/*
+// A snapshot of a frame chain from the innermost frame outwards,
+// written by the signal handler and published by setting @ready;
+*/
+struct DaoxSample
+{
+	volatile int  ready;
+	short         depth;
+	short         truncated;
+	void         *routines[DAOX_SAMPLE_DEPTH];  /* routine bodies or C functions; */
+	int           lines[DAOX_SAMPLE_DEPTH];
+};
+
+/* The process that is currently running on a thread: */
+struct DaoxSampleThread
+{
+	volatile size_t       thread;
+	DaoProcess *volatile  process;
+	void                 *pinned[DAOX_SAMPLE_PINS]; /* routine keys known to be pinned; */
+};
 
 struct DaoxProfiler
 {
@@ -45,6 +74,23 @@ struct DaoxProfiler
 	DMutex  mutex;
 	DMap   *profile; /* map<DaoRoutine*,map<DaoRoutine*,DaoComplex*>> */
 	DMap   *one;     /* map<DaoRoutine*,DaoComplex*> */
+
+	/* Sampling mode: */
+	int      frequency;  /* sampling frequency in Hz, zero for the instrumenting mode; */
+	int      head;       /* number of ring positions reserved by the signal handler; */
+	int      drained;    /* value of @head when the ring was last drained; */
+	int      lost;       /* samples dropped because the ring was full; */
+	daoint   count;      /* samples drained from the ring; */
+	DMap    *folded;     /* map<DString*,daoint>: folded stacks; */
+	DMap    *lines;      /* map<DString*,daoint>: samples per source line; */
+	DMap    *selfs;      /* map<void*,daoint>: samples in the routine itself; */
+	DMap    *totals;     /* map<void*,daoint>: samples with the routine on stack; */
+	DMap    *names;      /* map<void*,DString*>: names of the referenced routine keys; */
+	DMap    *signatures; /* map<void*,DString*>: names with parameter types; */
+	DString *output;     /* file for the folded stacks; */
+
+	DaoxSample        *ring;
+	DaoxSampleThread   threads[DAOX_SAMPLE_THREADS];
 };
 
 DAO_DLL DaoxProfiler* DaoxProfiler_New();
@@ -29,11 +29,14 @@
 #define DAO_STREAM
 
 #include<time.h>
+#include<stdint.h>
 #include<string.h>
 #include<errno.h>
 #include"dao_stream.h"
 #include"daoValue.h"
+#include"daoNumtype.h"
 #include"daoVmspace.h"
+#include"daoTasklet.h"
 
 #ifdef WIN32
 #include<windows.h>
@@ -48,6 +51,7 @@
 
 #else
 #include<sys/wait.h>
+#include<poll.h>
 #endif
 
 
@@ -414,6 +418,170 @@ static void DaoIO_ReadFile( DaoProcess *proc, DaoValue *p[], int N )
 	}
 }
 
+
+
+/*
+// File format of the arrays for io.save() and io.mmap():
+//
+// Bytes 0-7:   magic "DaoArray";
+// Byte  8:     element type: 'b', 'i', 'f' or 'c';
+// Byte  9:     element size in bytes (1, 2 or 4 for compact integer arrays,
+//              4 for compact float arrays);
+// Bytes 10-11: number of dimensions (16-bit integer);
+// Bytes 12-15: byte order mark 0x01020304 (32-bit integer);
+// Bytes 16-:   size of each dimension (64-bit integers);
+//
+// The elements are stored in row major order starting from the first
+// 16-byte aligned offset following the dimensions. All integers are
+// stored in the native byte order, which is checked by the byte order
+// mark when the file is mapped.
+*/
+#ifdef DAO_WITH_NUMARRAY
+
+#define DAO_ARRAY_FILE_MAGIC  "DaoArray"
+#define DAO_ARRAY_FILE_ORDER  0x01020304
+
+static const char daoArrayFileTypes[] = { 0, 'b', 'i', 'f', 'c' };
+
+static daoint DaoIO_ArrayDataOffset( int ndim )
+{
+	daoint offset = 16 + ndim * sizeof(int64_t);
+	return (offset + 15) & ~(daoint)15;
+}
+static int DaoIO_ArrayItemSize( int etype, int stype )
+{
+	switch( stype ){
+	case DAO_ARRAY_SINT8   : return sizeof(signed char);
+	case DAO_ARRAY_SINT16  : return sizeof(short);
+	case DAO_ARRAY_SINT32  : return sizeof(int);
+	case DAO_ARRAY_FLOAT32 : return sizeof(float);
+	}
+	switch( etype ){
+	case DAO_BOOLEAN : return sizeof(dao_boolean);
+	case DAO_INTEGER : return sizeof(dao_integer);
+	case DAO_FLOAT   : return sizeof(dao_float);
+	case DAO_COMPLEX : return sizeof(dao_complex);
+	}
+	return 0;
+}
+static int DaoIO_ArrayStorage( int etype, int itemsize )
+{
+	if( etype == DAO_INTEGER && itemsize != sizeof(dao_integer) ){
+		switch( itemsize ){
+		case sizeof(signed char) : return DAO_ARRAY_SINT8;
+		case sizeof(short) : return DAO_ARRAY_SINT16;
+		case sizeof(int)   : return DAO_ARRAY_SINT32;
+		}
+	}else if( etype == DAO_FLOAT && itemsize == sizeof(float) ){
+		return DAO_ARRAY_FLOAT32;
+	}
+	return DAO_ARRAY_DEFAULT;
+}
+static void DaoIO_SaveArray( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoArray *array = (DaoArray*) p[1];
+	char header[16] = DAO_ARRAY_FILE_MAGIC;
+	uint32_t order = DAO_ARRAY_FILE_ORDER;
+	uint16_t ndim;
+	daoint i, offset, size;
+	FILE *fout;
+
+	DaoArray_Sliced( array );
+	ndim = array->ndim;
+	size = array->size * DaoIO_ArrayItemSize( array->etype, array->stype );
+	offset = DaoIO_ArrayDataOffset( ndim );
+	header[8] = daoArrayFileTypes[ array->etype ];
+	header[9] = DaoIO_ArrayItemSize( array->etype, array->stype );
+	memcpy( header + 10, & ndim, sizeof(uint16_t) );
+	memcpy( header + 12, & order, sizeof(uint32_t) );
+
+	fout = DaoIO_OpenFile( proc, p[0]->xString.value, "wb", 0 );
+	if( fout == NULL ) return;
+	fwrite( header, 1, 16, fout );
+	for(i=0; i<ndim; ++i){
+		int64_t dim = array->dims[i];
+		fwrite( & dim, sizeof(int64_t), 1, fout );
+	}
+	for(i=16+ndim*sizeof(int64_t); i<offset; ++i) fputc( 0, fout );
+	if( fwrite( array->data.p, 1, size, fout ) != size ){
+		DaoProcess_RaiseError( proc, "Stream", "failed to write the array" );
+	}
+	fclose( fout );
+}
+static void DaoIO_MapArray( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DString *fname = DString_Copy( p[0]->xString.value );
+	DaoArray *array = DaoArray_New( p[1]->xType.tid );
+	DMappedFile *mapping;
+	const char *header;
+	uint32_t order = 0;
+	uint16_t ndim = 0;
+	daoint i, offset, size = 1;
+	int etype = DAO_NONE;
+	int stype = DAO_ARRAY_DEFAULT;
+
+	DaoProcess_PutValue( proc, (DaoValue*) array );
+
+	DaoIO_MakePath( proc, fname );
+	mapping = Dao_MapFile( fname->chars, p[2]->xEnum.value == 1 );
+	DString_Delete( fname );
+	if( mapping == NULL ){
+		char buf[200];
+		snprintf( buf, sizeof(buf), "error mapping file: %s", p[0]->xString.value->chars );
+		DaoProcess_RaiseError( proc, "Stream", buf );
+		return;
+	}
+
+	header = (const char*) mapping->data;
+	if( mapping->size >= 16 ){
+		memcpy( & ndim, header + 10, sizeof(uint16_t) );
+		memcpy( & order, header + 12, sizeof(uint32_t) );
+		for(i=DAO_BOOLEAN; i<=DAO_COMPLEX; ++i){
+			if( header[8] == daoArrayFileTypes[i] ) etype = i;
+		}
+		stype = DaoIO_ArrayStorage( etype, header[9] );
+	}
+	offset = DaoIO_ArrayDataOffset( ndim );
+	if( mapping->size < 16 || memcmp( header, DAO_ARRAY_FILE_MAGIC, 8 ) != 0
+			|| etype == DAO_NONE || header[9] != DaoIO_ArrayItemSize( etype, stype )
+			|| order != DAO_ARRAY_FILE_ORDER || ndim == 0 || mapping->size < offset ){
+		Dao_UnmapFile( mapping );
+		DaoProcess_RaiseError( proc, "Stream", "invalid array file" );
+		return;
+	}
+	if( etype != p[1]->xType.tid ){
+		Dao_UnmapFile( mapping );
+		DaoProcess_RaiseError( proc, "Stream", "unmatched array element type" );
+		return;
+	}
+
+	/* Vectors are stored as 1xN arrays: */
+	DaoArray_SetDimCount( array, ndim + (ndim == 1) );
+	array->dims[0] = 1;
+	for(i=0; i<ndim; ++i){
+		int64_t dim;
+		memcpy( & dim, header + 16 + i*sizeof(int64_t), sizeof(int64_t) );
+		array->dims[i + (ndim == 1)] = dim;
+		if( dim < 0 || (dim && size > (daoint)mapping->size / dim) ){
+			size = -1;
+			break;
+		}
+		if( size > 0 ) size *= dim;
+	}
+	if( size < 0 || (size_t)(offset + size * header[9]) > mapping->size ){
+		Dao_UnmapFile( mapping );
+		DaoArray_ResizeVector( array, 0 );
+		DaoProcess_RaiseError( proc, "Stream", "invalid array file" );
+		return;
+	}
+	array->etype = etype;
+	array->stype = stype;
+	DaoArray_UseMappedData( array, mapping, offset );
+	DaoArray_FinalizeDimData( array );
+}
+
+#endif
+
 static void DaoIO_Seek( DaoProcess *proc, DaoValue *p[], int N )
 {
 	DaoFileStream *self = (DaoFileStream*) p[0];
@@ -437,6 +605,48 @@ static void DaoIO_FileNO( DaoProcess *proc, DaoValue *p[], int N )
 	if( self->file == NULL ) return;
 	*num = fileno( self->file );
 }
+/*
+// Check if the stream can be read without waiting on its file descriptor.
+// The input may have been buffered by stdio, which is checked in the FILE
+// structure where its layout is known. Otherwise the descriptor is polled
+// with zero timeout, which misses bytes only held by the stdio buffer.
+*/
+static int DaoFile_HasBufferedInput( FILE *file )
+{
+#ifdef UNIX
+	struct pollfd pfd;
+
+	if( feof( file ) ) return 1;
+#if defined( __GLIBC__ )
+	if( file->_IO_read_ptr < file->_IO_read_end ) return 1;
+#elif defined( __APPLE__ ) || defined( __FreeBSD__ ) || defined( __OpenBSD__ ) || defined( __NetBSD__ )
+	if( file->_r > 0 ) return 1;
+#endif
+	pfd.fd = fileno( file );
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll( & pfd, 1, 0 ) > 0;
+#else
+	return 0;
+#endif
+}
+static void DaoIO_Wait( DaoProcess *proc, DaoValue *p[], int N )
+{
+	DaoFileStream *self = (DaoFileStream*) p[0];
+	int writing = p[1]->xEnum.value;
+	double timeout = p[2]->xFloat.value;
+	if( self->file == NULL ){
+		DaoProcess_RaiseError( proc, "Param", "Stream not open" );
+		return;
+	}
+	if( writing ){
+		fflush( self->file );
+	}else if( DaoFile_HasBufferedInput( self->file ) ){
+		DaoProcess_PutBoolean( proc, 1 );
+		return;
+	}
+	DaoProcess_WaitIO( proc, fileno( self->file ), writing, timeout );
+}
 static void DaoIO_Close( DaoProcess *proc, DaoValue *p[], int N )
 {
 	DaoFileStream *self = (DaoFileStream*) p[0];
@@ -523,6 +733,19 @@ static DaoFunctionEntry dao_io_methods[] =
 	{ PIPE_New,        "popen( command: string, mode: string ) => PipeStream" },
 
 	{ DaoIO_ReadFile,  "read( file: string, silent = false )=>string" },
+
+#ifdef DAO_WITH_NUMARRAY
+	/*! Saves the numeric array \a data to \a file in a format that can be mapped by mmap() */
+	{ DaoIO_SaveArray, "save( file: string, invar data: array<@T<bool|int|float|complex>> )" },
+
+	/*! Creates a numeric array directly over the memory mapped \a file saved by save().
+	 * The element type of the array in the file must be \a type.
+	 * With \a mode $private, the mapping is copy-on-write and the file is not modified;
+	 * with \a mode $shared, modifications to the array are written back to the file.
+	 * Resizing the array detaches it from the file */
+	{ DaoIO_MapArray,  "mmap( file: string, type: type<@E<bool|int|float|complex>>,"
+		" mode: enum<private,shared> = $private ) => array<@E>" },
+#endif
 	{ NULL, NULL }
 };
 
@@ -535,6 +758,11 @@ static DaoFunctionEntry daoFileStreamMeths[] =
 	{ DaoIO_Seek,    "seek( self: FileStream, pos: int, from: enum<start,current,end> ) => int" },
 	{ DaoIO_Tell,    "tell( self: FileStream ) => int" },
 	{ DaoIO_FileNO,  ".fd( invar self: FileStream ) => int" },
+
+	/*! Waits until the stream can be read or written without blocking, or until \a timeout
+	 * (in seconds, negative for no timeout); returns true if the stream is ready.
+	 * Waiting in a tasklet suspends the tasklet instead of blocking its thread */
+	{ DaoIO_Wait,    "wait( self: FileStream, what: enum<read,write> = $read, timeout: float = -1 ) => bool" },
 	{ NULL, NULL }
 };
 
@@ -571,6 +799,9 @@ static DaoFunctionEntry daoPipeStreamMeths[] =
 	{ PIPE_New,     "PipeStream( file: string, mode: string ) => PipeStream" },
 	{ PIPE_FileNO,  ".fd( invar self: PipeStream ) => int" },
 	{ PIPE_Close,   "close( self: PipeStream ) => int" },
+
+	/*! The same as FileStream::wait() */
+	{ DaoIO_Wait,   "wait( self: PipeStream, what: enum<read,write> = $read, timeout: float = -1 ) => bool" },
 	{ NULL, NULL }
 };
 
@@ -279,8 +279,33 @@ static DaoTypeCore daoUserPodTypeCore =
 	NULL                                                        /* HandleGC */
 };
 
+#ifdef DAO_WITH_NUMARRAY
+/*
+// Constant arrays in compact storage, which cannot be created by constant
+// folding in scripts; used to test their encoding in bytecode files:
+*/
+static void DaoxUserPodType_AddCompactArrays( DaoNamespace *ns )
+{
+	DaoArray *ints = DaoArray_New( DAO_INTEGER );
+	DaoArray *floats = DaoArray_New( DAO_FLOAT );
+	daoint i;
+
+	DaoArray_ResizeVector( ints, 100 );
+	DaoArray_ResizeVector( floats, 5 );
+	DaoArray_SetStorage( ints, DAO_ARRAY_SINT8 );
+	DaoArray_SetStorage( floats, DAO_ARRAY_FLOAT32 );
+	for(i=0; i<ints->size; ++i) ints->data.i8[i] = (i % 2) ? -i : i;
+	for(i=0; i<floats->size; ++i) floats->data.f32[i] = 0.25 * i - 0.5;
+	DaoNamespace_AddConstValue( ns, "CompactInt8s", (DaoValue*) ints );
+	DaoNamespace_AddConstValue( ns, "CompactFloat32s", (DaoValue*) floats );
+}
+#endif
+
 DAO_DLL int DaoUserpodtype_OnLoad( DaoVmSpace *vmSpace, DaoNamespace *ns )
 {
 	daox_type_user_pod_type = DaoNamespace_WrapType( ns, & daoUserPodTypeCore, DAO_CSTRUCT, 0 );
+#ifdef DAO_WITH_NUMARRAY
+	DaoxUserPodType_AddCompactArrays( ns );
+#endif
 	return 0;
 }
@@ -0,0 +1,338 @@
+/*
+// Dao Benchmark Tool
+// http://daoscript.org
+//
+// Copyright (c) 2013-2017, Limin Fu
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+// Usage: daobench [options] script.dao ...
+//
+// Each script is loaded once (its main routine serves as the setup), then each of
+// its global routines whose name starts with "bench_" and that take no parameter
+// is called for a number of warmup iterations followed by a number of timed
+// iterations. The median and percentiles of the timed iterations are reported.
+//
+// Options:
+//   --warmup N        Number of untimed iterations (default 2);
+//   --repeat N        Number of timed iterations (default 10);
+//   --filter TEXT     Only run the benchmarks whose names contain TEXT;
+//   --json FILE       Write the results to FILE in JSON format;
+//   --baseline FILE   Compare the medians with the results in FILE (from --json);
+//   --threshold P     Flag a regression when a median is slower by more than
+//                     P percent than the baseline (default 10);
+//
+// The exit status is the number of regressions and failed benchmarks.
+*/
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include"dao.h"
+#include"daoValue.h"
+#include"daoStdtype.h"
+#include"daoRoutine.h"
+#include"daoNamespace.h"
+#include"daoProcess.h"
+#include"daoStream.h"
+#include"daoVmspace.h"
+#include"daoPlatform.h"
+
+
+typedef struct DaoBenchResult  DaoBenchResult;
+
+struct DaoBenchResult
+{
+	DString  *name;     /* script base name and routine name; */
+	int       repeat;
+	int       failed;
+	double    median;
+	double    p10;
+	double    p90;
+	double    min;
+	double    max;
+	double    mean;
+	double    baseline; /* median from the baseline, or zero; */
+};
+
+static DList *dao_results = NULL;  /* list of DaoBenchResult; */
+
+
+static int DaoBench_CompareTime( const void *first, const void *second )
+{
+	double t1 = *(double*) first;
+	double t2 = *(double*) second;
+	if( t1 == t2 ) return 0;
+	return t1 < t2 ? -1 : 1;
+}
+
+/* Percentile of sorted samples, by linear interpolation between the closest ranks: */
+static double DaoBench_Percentile( double *times, int count, double percent )
+{
+	double rank = 0.01 * percent * (count - 1);
+	int low = (int) rank;
+	if( low + 1 >= count ) return times[count-1];
+	return times[low] + (rank - low) * (times[low+1] - times[low]);
+}
+
+/*
+// The call status is not used, because it is not reliable for routines
+// that have been suspended and resumed by tasklets:
+*/
+static int DaoBench_Call( DaoProcess *proc, DaoRoutine *routine )
+{
+	DaoProcess_Call( proc, routine, NULL, NULL, 0 );
+	return proc->status == DAO_PROCESS_ABORTED || proc->exceptions->size != 0;
+}
+
+static DaoBenchResult* DaoBench_Run( DaoProcess *proc, DaoRoutine *routine,
+		DString *name, int warmup, int repeat )
+{
+	DaoBenchResult *result = (DaoBenchResult*) dao_calloc( 1, sizeof(DaoBenchResult) );
+	double *times = (double*) dao_calloc( repeat, sizeof(double) );
+	double start, total = 0.0;
+	int i;
+
+	result->name = DString_Copy( name );
+	result->repeat = repeat;
+	for(i=0; i<warmup && result->failed == 0; ++i){
+		result->failed = DaoBench_Call( proc, routine );
+	}
+	for(i=0; i<repeat && result->failed == 0; ++i){
+		start = Dao_GetCurrentTime();
+		result->failed = DaoBench_Call( proc, routine );
+		times[i] = Dao_GetCurrentTime() - start;
+		total += times[i];
+	}
+	if( result->failed == 0 ){
+		qsort( times, repeat, sizeof(double), DaoBench_CompareTime );
+		result->median = DaoBench_Percentile( times, repeat, 50.0 );
+		result->p10 = DaoBench_Percentile( times, repeat, 10.0 );
+		result->p90 = DaoBench_Percentile( times, repeat, 90.0 );
+		result->min = times[0];
+		result->max = times[repeat-1];
+		result->mean = total / repeat;
+	}
+	dao_free( times );
+	return result;
+}
+
+static void DaoBench_RunScript( DaoVmSpace *vmSpace, const char *file,
+		const char *filter, int warmup, int repeat )
+{
+	DaoNamespace *ns = DaoVmSpace_Load( vmSpace, file );
+	DaoProcess *proc;
+	DString *name;
+	const char *base = strrchr( file, '/' );
+	daoint i;
+
+	base = base ? base + 1 : file;
+	if( ns == NULL ){
+		DaoBenchResult *result;
+		fprintf( stderr, "Error: failed to load %s!\n", file );
+		result = (DaoBenchResult*) dao_calloc( 1, sizeof(DaoBenchResult) );
+		result->name = DString_NewChars( base );
+		result->failed = 1;
+		DList_Append( dao_results, result );
+		return;
+	}
+
+	name = DString_New();
+	proc = DaoVmSpace_AcquireProcess( vmSpace );
+	for(i=0; i<ns->constants->size; ++i){
+		DaoValue *value = ns->constants->items.pConst[i]->value;
+		DaoRoutine *routine = (DaoRoutine*) value;
+		if( value == NULL || value->type != DAO_ROUTINE ) continue;
+		if( routine->nameSpace != ns || routine->overloads != NULL ) continue;
+		if( routine->parCount != 0 || routine->body == NULL ) continue;
+		if( strncmp( routine->routName->chars, "bench_", 6 ) != 0 ) continue;
+
+		DString_SetChars( name, base );
+		DString_AppendChar( name, ':' );
+		DString_Append( name, routine->routName );
+		if( filter && strstr( name->chars, filter ) == NULL ) continue;
+
+		fprintf( stderr, "Running %s ...\n", name->chars );
+		DList_Append( dao_results, DaoBench_Run( proc, routine, name, warmup, repeat ) );
+		if( proc->exceptions->size ) DaoProcess_PrintException( proc, NULL, 1 );
+	}
+	DaoVmSpace_ReleaseProcess( vmSpace, proc );
+	DString_Delete( name );
+}
+
+/*
+// The JSON output has one benchmark per line, so that the baseline
+// can be read back without a JSON parser:
+*/
+static int DaoBench_ReadBaseline( const char *file )
+{
+	char line[1024], name[512];
+	FILE *fin = Dao_OpenFile( file, "r" );
+	daoint i;
+
+	if( fin == NULL ) return 0;
+	while( fgets( line, sizeof(line), fin ) ){
+		char *pname = strstr( line, "\"name\": \"" );
+		char *pmedian = strstr( line, "\"median\": " );
+		char *end;
+		double median;
+		if( pname == NULL || pmedian == NULL ) continue;
+		pname += strlen( "\"name\": \"" );
+		end = strchr( pname, '"' );
+		if( end == NULL || end - pname >= sizeof(name) ) continue;
+		memcpy( name, pname, end - pname );
+		name[end - pname] = '\0';
+		median = strtod( pmedian + strlen( "\"median\": " ), NULL );
+		for(i=0; i<dao_results->size; ++i){
+			DaoBenchResult *result = (DaoBenchResult*) dao_results->items.pVoid[i];
+			if( strcmp( result->name->chars, name ) == 0 ) result->baseline = median;
+		}
+	}
+	fclose( fin );
+	return 1;
+}
+
+static void DaoBench_WriteJSON( const char *file, const char *version )
+{
+	FILE *fout = Dao_OpenFile( file, "w" );
+	daoint i;
+
+	if( fout == NULL ){
+		fprintf( stderr, "Error: failed to open %s!\n", file );
+		return;
+	}
+	fprintf( fout, "{\n\"dao\": \"%s\",\n\"benchmarks\": [\n", version );
+	for(i=0; i<dao_results->size; ++i){
+		DaoBenchResult *result = (DaoBenchResult*) dao_results->items.pVoid[i];
+		fprintf( fout, "{\"name\": \"%s\", \"failed\": %s, \"repeat\": %i, \"median\": %.9g, "
+				"\"p10\": %.9g, \"p90\": %.9g, \"min\": %.9g, \"max\": %.9g, \"mean\": %.9g}%s\n",
+				result->name->chars, result->failed ? "true" : "false", result->repeat,
+				result->median, result->p10, result->p90, result->min, result->max,
+				result->mean, (i + 1) < dao_results->size ? "," : "" );
+	}
+	fprintf( fout, "]\n}\n" );
+	fclose( fout );
+}
+
+/* Print the results and return the number of regressions and failures: */
+static int DaoBench_Report( double threshold )
+{
+	const char *header = "%-40s %10s %10s %10s %10s %10s %8s\n";
+	const char *row = "%-40.40s %10.3f %10.3f %10.3f %10.3f %10.3f";
+	int i, failures = 0, regressions = 0;
+
+	printf( header, "Benchmark", "Median(ms)", "P10(ms)", "P90(ms)", "Min(ms)", "Max(ms)", "Change" );
+	for(i=0; i<dao_results->size; ++i){
+		DaoBenchResult *result = (DaoBenchResult*) dao_results->items.pVoid[i];
+		if( result->failed ){
+			printf( "%-40.40s %10s\n", result->name->chars, "FAILED" );
+			failures += 1;
+			continue;
+		}
+		printf( row, result->name->chars, 1E3*result->median, 1E3*result->p10,
+				1E3*result->p90, 1E3*result->min, 1E3*result->max );
+		if( result->baseline > 0.0 ){
+			double change = 100.0 * (result->median - result->baseline) / result->baseline;
+			int regressed = change > threshold;
+			printf( " %+7.1f%%%s", change, regressed ? "  REGRESSION" : "" );
+			regressions += regressed;
+		}
+		printf( "\n" );
+	}
+	printf( "Benchmark summary: %i run, %i failed, %i regressed;\n",
+			(int) dao_results->size, failures, regressions );
+	return failures + regressions;
+}
+
+int main( int argc, char **argv )
+{
+	DaoVmSpace *vmSpace;
+	DaoProcess *proc;
+	DString *version;
+	const char *json = NULL;
+	const char *baseline = NULL;
+	const char *filter = NULL;
+	double threshold = 10.0;
+	int warmup = 2, repeat = 10;
+	int i, ret;
+
+	dao_results = DList_New(0);
+	vmSpace = DaoInit( argv[0] );
+
+	proc = DaoVmSpace_AcquireProcess( vmSpace );
+	DaoProcess_Eval( proc, vmSpace->mainNamespace, "std.version(true)" );
+	version = DString_NewChars( DaoValue_TryGetChars( proc->stackValues[0] ) );
+	DaoVmSpace_ReleaseProcess( vmSpace, proc );
+
+	for(i=1; i<argc; ++i){
+		const char *arg = argv[i];
+		const char *value = (i + 1) < argc ? argv[i+1] : NULL;
+		if( arg[0] == '-' && arg[1] == '-' && value == NULL ){
+			fprintf( stderr, "Error: missing value for option %s!\n", arg );
+			return 1;
+		}
+		if( strcmp( arg, "--warmup" ) == 0 ){
+			warmup = strtol( value, NULL, 10 );
+		}else if( strcmp( arg, "--repeat" ) == 0 ){
+			repeat = strtol( value, NULL, 10 );
+		}else if( strcmp( arg, "--filter" ) == 0 ){
+			filter = value;
+		}else if( strcmp( arg, "--json" ) == 0 ){
+			json = value;
+		}else if( strcmp( arg, "--baseline" ) == 0 ){
+			baseline = value;
+		}else if( strcmp( arg, "--threshold" ) == 0 ){
+			threshold = strtod( value, NULL );
+		}else{
+			continue;
+		}
+		i += 1;
+	}
+	if( warmup < 0 ) warmup = 0;
+	if( repeat < 1 ) repeat = 1;
+
+	for(i=1; i<argc; ++i){
+		if( argv[i][0] == '-' && argv[i][1] == '-' ){
+			i += 1;
+			continue;
+		}
+		DaoBench_RunScript( vmSpace, argv[i], filter, warmup, repeat );
+	}
+
+	if( baseline && DaoBench_ReadBaseline( baseline ) == 0 ){
+		fprintf( stderr, "Error: failed to read the baseline %s!\n", baseline );
+	}
+	printf( "DaoBench: %s; warmup: %i, repeat: %i\n", version->chars, warmup, repeat );
+	ret = DaoBench_Report( threshold );
+	if( json ) DaoBench_WriteJSON( json, version->chars );
+
+	for(i=0; i<dao_results->size; ++i){
+		DaoBenchResult *result = (DaoBenchResult*) dao_results->items.pVoid[i];
+		DString_Delete( result->name );
+		dao_free( result );
+	}
+	DList_Delete( dao_results );
+	DString_Delete( version );
+	DaoQuit();
+	return ret;
+}
@@ -39,10 +39,20 @@
 #include"daoStream.h"
 #include"daoVmspace.h"
 #include"daoTasklet.h"
+#include"daoPlatform.h"
+
+#ifdef UNIX
+#include<unistd.h>
+#include<poll.h>
+#include<signal.h>
+#include<sys/wait.h>
+#include<errno.h>
+#endif
 
 
 
 typedef struct DaoTestStream  DaoTestStream;
+typedef struct DaoTestFile    DaoTestFile;
 
 struct DaoTestStream
 {
@@ -50,6 +60,27 @@ struct DaoTestStream
 	DString  *output;
 };
 
+/*
+// A test file is run in a new VM space (created by DaoInit()).
+// In parallel mode, each file is run in its own child process
+// which sends back its unit counts and failure reports by a pipe.
+*/
+struct DaoTestFile
+{
+	const char  *file;
+	DString     *report;  /* reports of the failed units; */
+	double       start;
+	double       time;
+	int          passes;
+	int          fails;
+	int          timedout;
+#ifdef UNIX
+	pid_t        pid;
+	int          fd;      /* read end of the pipe from the child process; */
+	DString     *output;  /* data received from the child process; */
+#endif
+};
+
 #ifdef DAO_WITH_THREAD
 
 DMutex mutex;
@@ -160,20 +191,246 @@ void GetCounts( DString *text, int *mps, int *mfs, int *ps, int *fs )
 }
 
 
-int main( int argc, char **argv )
+static void DaoTest_RunFile( DaoTestFile *test, const char *command )
 {
 	DaoTestStream stream0 = { {DAO_CSTRUCT,0,0,0,1,1, NULL,NULL, NULL,NULL,NULL,NULL,NULL, 0, NULL} };
 	DaoTestStream *stream = & stream0;
 	DaoNamespace *ns;
+	int j;
+
+	DMutex_Init( & mutex );
+	vmSpace = DaoInit( command );
+	vmSpace->options |= DAO_OPTION_AUTOVAR;
+
+	dao_tests = DList_New(DAO_DATA_STRING);
+	ns = DaoVmSpace_Load( vmSpace, test->file );
+	if( ns == NULL ){
+		test->fails += 1;
+	}else{
+		DaoProcess *proc = DaoVmSpace_AcquireProcess( vmSpace );
+		DString *output = DString_New();
+		DString *output2 = DString_New();
+		DaoRegex *regex;
+
+		for(j=0; j<ns->mainRoutine->body->source->size; ++j){
+			DaoToken *token = ns->mainRoutine->body->source->items.pToken[j];
+			if( token->type != DTOK_VERBATIM ) continue;
+			HandleVerbatim( & token->string, token->line );
+		}
+
+		stream->base.Write = DaoTestStream_Write;
+		stream->output = output;
+		DaoVmSpace_SetStdio( vmSpace, (DaoStream*) stream );
+		DaoVmSpace_SetStdError( vmSpace, (DaoStream*) stream );
+		for(j=0; j<dao_tests->size; j+=3){
+			DString *id = dao_tests->items.pString[j];
+			DString *codes = dao_tests->items.pString[j+1];
+			DString *result = dao_tests->items.pString[j+2];
+			DaoNamespace *ns2 = DaoNamespace_New( vmSpace, "test" );
+			int failed = test->fails;
+
+			ns2->options |= DAO_NS_AUTO_GLOBAL;
+			stream->output = output;
+			DString_Reset( output, 0 );
+			DaoNamespace_AddParent( ns2, ns );
+			DaoProcess_Eval( proc, ns2, codes->chars );
+#ifdef DAO_WITH_CONCURRENT
+			DaoVmSpace_JoinTasklets( vmSpace );
+#endif
+			DString_Trim( output, 1, 1, 0 );
+			DString_Trim( result, 1, 1, 0 );
+			if( output->size == 0 && result->size != 0 ){
+				/* If there is no output, check the lasted evaluated value: */
+				DaoProcess *proc2 = DaoVmSpace_AcquireProcess( vmSpace );
+				DaoNamespace *ns3 = DaoNamespace_New( vmSpace, "result" );
+				int cmp;
+				stream->output = output2;
+				DString_Reset( output2, 0 );
+				DaoNamespace_AddParent( ns3, ns );
+				DaoProcess_Eval( proc2, ns3, result->chars );
+				cmp = DaoValue_Compare( proc->stackValues[0], proc2->stackValues[0] );
+				DaoVmSpace_ReleaseProcess( vmSpace, proc2 );
+				DaoGC_TryDelete( (DaoValue*) ns3 );
+				test->passes += cmp == 0;
+				test->fails += cmp != 0;
+			}else if( DString_EQ( output, result ) ){
+				/* Check if the output is the same as expected: */
+				test->passes += 1;
+			}else if( (regex = DaoProcess_MakeRegex( proc, result )) ){
+				/* Check if the result is a string pattern and if the output matches it: */
+				daoint start = 0;
+				daoint end = output->size;
+				int match = DaoRegex_Match( regex, output, & start, & end );
+				test->passes += match != 0;
+				test->fails += match == 0;
+			}else{
+				test->fails += 1;
+			}
+			if( test->fails > failed ){
+				DString *log = test->report;
+				if( output->size > 2000 ) DString_Reset( output, 2000 );
+				DString_AppendChars( log, "\n#############################################\n" );
+				DString_AppendChars( log, "\nFAILED: " );
+				DString_AppendChars( log, test->file );
+				DString_AppendChars( log, ", line " );
+				DString_Append( log, id );
+				DString_AppendChars( log, ":\nOUTPUT:\n\n" );
+				DString_Append( log, output );
+				DString_AppendChars( log, "\n\nEXPECTED:\n\n" );
+				DString_Append( log, result );
+				DString_AppendChars( log, "\n\n\n" );
+			}
+			DaoGC_TryDelete( (DaoValue*) ns2 );
+			DList_Clear( proc->exceptions );
+		}
+		DaoVmSpace_ReleaseProcess( vmSpace, proc );
+		DString_Delete( output );
+		DString_Delete( output2 );
+	}
+	DList_Delete( dao_tests );
+	DaoQuit();
+	DMutex_Destroy( & mutex );
+}
+
+#ifdef UNIX
+
+static void DaoTest_WriteAll( int fd, const char *data, daoint size )
+{
+	while( size > 0 ){
+		ssize_t n = write( fd, data, size );
+		if( n < 0 && errno == EINTR ) continue;
+		if( n <= 0 ) break;
+		data += n;
+		size -= n;
+	}
+}
+
+static void DaoTest_Spawn( DaoTestFile *test, const char *command )
+{
+	int fds[2];
+
+	test->fd = -1;
+	test->start = Dao_GetCurrentTime();
+	fflush( stdout );
+	fflush( stderr );
+	if( pipe( fds ) != 0 || (test->pid = fork()) < 0 ){
+		DString_AppendChars( test->report, "\nERROR: failed to start a process for " );
+		DString_AppendChars( test->report, test->file );
+		DString_AppendChars( test->report, "\n" );
+		test->fails += 1;
+		return;
+	}
+	if( test->pid == 0 ){
+		char header[64];
+		close( fds[0] );
+		DaoTest_RunFile( test, command );
+		sprintf( header, "%i %i\n", test->passes, test->fails );
+		DaoTest_WriteAll( fds[1], header, strlen( header ) );
+		DaoTest_WriteAll( fds[1], test->report->chars, test->report->size );
+		close( fds[1] );
+		_exit( 0 );
+	}
+	close( fds[1] );
+	test->fd = fds[0];
+}
+
+static void DaoTest_Finish( DaoTestFile *test, double timeout )
+{
+	daoint pos = DString_FindChar( test->output, '\n', 0 );
+	char buf[100];
+	int status = 0;
+
+	close( test->fd );
+	waitpid( test->pid, & status, 0 );
+	test->time = Dao_GetCurrentTime() - test->start;
+	if( pos != DAO_NULLPOS ){
+		char *p;
+		test->passes = strtol( test->output->chars, & p, 10 );
+		test->fails = strtol( p, & p, 10 );
+		DString_AppendBytes( test->report, test->output->chars + pos + 1, test->output->size - pos - 1 );
+		return;
+	}
+	/* The child process was killed before sending back its results: */
+	test->fails += 1;
+	DString_AppendChars( test->report, "\n#############################################\n" );
+	if( test->timedout ){
+		sprintf( buf, ", after %.1f seconds;\n\n\n", timeout );
+		DString_AppendChars( test->report, "\nTIMEOUT: " );
+	}else{
+		sprintf( buf, ", with status %i;\n\n\n", WIFSIGNALED( status ) ? WTERMSIG( status ) : status );
+		DString_AppendChars( test->report, "\nCRASHED: " );
+	}
+	DString_AppendChars( test->report, test->file );
+	DString_AppendChars( test->report, buf );
+}
+
+/*
+// Run the test files in up to "jobs" child processes, and kill those
+// that have been running for longer than "timeout" seconds:
+*/
+static void DaoTest_RunParallel( DaoTestFile *tests, int count, int jobs, double timeout, const char *command )
+{
+	DaoTestFile **active = (DaoTestFile**) dao_calloc( jobs, sizeof(DaoTestFile*) );
+	struct pollfd *fds = (struct pollfd*) dao_calloc( jobs, sizeof(struct pollfd) );
+	int i, next = 0, running = 0;
+
+	while( next < count || running > 0 ){
+		double now;
+		while( running < jobs && next < count ){
+			DaoTestFile *test = tests + next++;
+			DaoTest_Spawn( test, command );
+			if( test->fd >= 0 ) active[running++] = test;
+		}
+		for(i=0; i<running; ++i){
+			fds[i].fd = active[i]->fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if( running == 0 ) continue;
+		if( poll( fds, running, 50 ) < 0 && errno != EINTR ) break;
+
+		now = Dao_GetCurrentTime();
+		/* Backward, so that the removal does not shift the unchecked ones: */
+		for(i=running-1; i>=0; --i){
+			DaoTestFile *test = active[i];
+			if( fds[i].revents ){
+				char buf[4096];
+				ssize_t n = read( test->fd, buf, sizeof(buf) );
+				if( n > 0 ){
+					DString_AppendBytes( test->output, buf, n );
+				}else if( n == 0 || errno != EINTR ){
+					DaoTest_Finish( test, timeout );
+					active[i] = active[--running];
+					continue;
+				}
+			}
+			if( timeout > 0.0 && test->timedout == 0 && (now - test->start) > timeout ){
+				test->timedout = 1;
+				kill( test->pid, SIGKILL );
+			}
+		}
+	}
+	dao_free( active );
+	dao_free( fds );
+}
+
+#endif
+
+int main( int argc, char **argv )
+{
+	DaoTestFile *tests;
 	DaoProcess *proc;
 	DString *string;
 	DString *summary;
 	DString *info;
 	FILE *fin, *logfile = NULL;
+	double start = Dao_GetCurrentTime();
+	double timeout = 300.0;
 	int passes = 0, mpasses = 0;
 	int fails = 0, mfails = 0;
-	int i, j, logopt = argc;
+	int i, count = 0, logopt = argc;
 	int groupopt = argc;
+	int jobs = 0;
 
 	if( argc <= 1 ) return 0;
 
@@ -252,110 +509,68 @@ int main( int argc, char **argv )
 		DaoQuit();
 		return 0;
 	}
-	DMutex_Init( & mutex );
-
-	if( (logopt+1) < argc ) logfile = Dao_OpenFile( argv[logopt+1], "w+b" );
+	/*
+	// Options before "--log":
+	// --jobs N:    number of test files to run in parallel (default: number of processors);
+	// --timeout S: seconds after which a test file is killed (default: 300; 0 for none);
+	*/
+	tests = (DaoTestFile*) dao_calloc( logopt, sizeof(DaoTestFile) );
 	for(i=1; i<logopt; ++i){
-		vmSpace = DaoInit( argv[0] );
-		vmSpace->options |= DAO_OPTION_AUTOVAR;
-
-		ns = DaoVmSpace_GetNamespace( vmSpace, "dao" );
-
-		string = DString_New();
-		dao_tests = DList_New(DAO_DATA_STRING);
-		ns = DaoVmSpace_Load( vmSpace, argv[i] );
-		if( ns == NULL ){
-			mfails += 1;
-			fails += 1;
+		if( strcmp( argv[i], "--jobs" ) == 0 && (i + 1) < logopt ){
+			jobs = strtol( argv[++i], NULL, 10 );
+		}else if( strcmp( argv[i], "--timeout" ) == 0 && (i + 1) < logopt ){
+			timeout = strtod( argv[++i], NULL );
 		}else{
-			int pass = 0, fail = 0;
-			DaoProcess *proc = DaoVmSpace_AcquireProcess( vmSpace );
-			DString *output = DString_New();
-			DString *output2 = DString_New();
-			DaoRegex *regex;
-
-			for(j=0; j<ns->mainRoutine->body->source->size; ++j){
-				DaoToken *token = ns->mainRoutine->body->source->items.pToken[j];
-				if( token->type != DTOK_VERBATIM ) continue;
-				HandleVerbatim( & token->string, token->line );
-			}
+			tests[count].file = argv[i];
+			tests[count].report = DString_New();
+#ifdef UNIX
+			tests[count].output = DString_New();
+#endif
+			count += 1;
+		}
+	}
+#ifdef DAO_WITH_THREAD
+	if( jobs <= 0 ) jobs = DThread_GetProcessorCount();
+#endif
+	if( jobs <= 0 ) jobs = 1;
+	if( jobs > count ) jobs = count;
 
-			stream->base.Write = DaoTestStream_Write;
-			stream->output = output;
-			DaoVmSpace_SetStdio( vmSpace, (DaoStream*) stream );
-			DaoVmSpace_SetStdError( vmSpace, (DaoStream*) stream );
-			for(j=0; j<dao_tests->size; j+=3){
-				DString *id = dao_tests->items.pString[j];
-				DString *codes = dao_tests->items.pString[j+1];
-				DString *result = dao_tests->items.pString[j+2];
-				DaoNamespace *ns2 = DaoNamespace_New( vmSpace, "test" );
-				int failed = fail;
-
-				ns2->options |= DAO_NS_AUTO_GLOBAL;
-				stream->output = output;
-				DString_Reset( output, 0 );
-				DaoNamespace_AddParent( ns2, ns );
-				DaoProcess_Eval( proc, ns2, codes->chars );
-#ifdef DAO_WITH_CONCURRENT
-				DaoVmSpace_JoinTasklets( vmSpace );
+	if( (logopt+1) < argc ) logfile = Dao_OpenFile( argv[logopt+1], "w+b" );
+#ifdef UNIX
+	if( jobs > 0 ) DaoTest_RunParallel( tests, count, jobs, timeout, argv[0] );
+#else
+	for(i=0; i<count; ++i){
+		tests[i].start = Dao_GetCurrentTime();
+		DaoTest_RunFile( tests + i, argv[0] );
+		tests[i].time = Dao_GetCurrentTime() - tests[i].start;
+	}
 #endif
-				DString_Trim( output, 1, 1, 0 );
-				DString_Trim( result, 1, 1, 0 );
-				if( output->size == 0 && result->size != 0 ){
-					/* If there is no output, check the lasted evaluated value: */
-					DaoProcess *proc2 = DaoVmSpace_AcquireProcess( vmSpace );
-					DaoNamespace *ns3 = DaoNamespace_New( vmSpace, "result" );
-					int cmp;
-					stream->output = output2;
-					DString_Reset( output2, 0 );
-					DaoNamespace_AddParent( ns3, ns );
-					DaoProcess_Eval( proc2, ns3, result->chars );
-					cmp = DaoValue_Compare( proc->stackValues[0], proc2->stackValues[0] );
-					DaoVmSpace_ReleaseProcess( vmSpace, proc2 );
-					DaoGC_TryDelete( (DaoValue*) ns3 );
-					pass += cmp == 0;
-					fail += cmp != 0;
-				}else if( DString_EQ( output, result ) ){
-					/* Check if the output is the same as expected: */
-					pass += 1;
-				}else if( (regex = DaoProcess_MakeRegex( proc, result )) ){
-					/* Check if the result is a string pattern and if the output matches it: */
-					daoint start = 0;
-					daoint end = output->size;
-					int match = DaoRegex_Match( regex, output, & start, & end );
-					pass += match != 0;
-					fail += match == 0;
-				}else{
-					fail += 1;
-				}
-				if( fail > failed ){
-					FILE *log = logfile ? logfile : stderr;
-					if( output->size > 2000 ) DString_Reset( output, 2000 );
-					fprintf( log, "\n#############################################\n" );
-					fprintf( log, "\nFAILED: %s, line %s:\n", argv[i], id->chars );
-					fprintf( log, "OUTPUT:\n\n%s\n\n", output->chars );
-					fprintf( log, "EXPECTED:\n\n%s\n\n\n", result->chars );
-					fflush( log );
-				}
-				DaoGC_TryDelete( (DaoValue*) ns2 );
-				DList_Clear( proc->exceptions );
-			}
-			DaoVmSpace_ReleaseProcess( vmSpace, proc );
-			DString_Delete( output );
-			DString_Delete( output2 );
-			passes += pass;
-			fails += fail;
-			mpasses += fail == 0;
-			mfails += fail != 0;
+
+	for(i=0; i<count; ++i){
+		DaoTestFile *test = tests + i;
+		const char *status = test->fails ? "FAILED " : "passed ";
+		if( test->timedout ) status = "TIMEOUT";
+		printf( "%s %-36s %4i passed, %4i failed; %8.3fs\n",
+				status, test->file, test->passes, test->fails, test->time );
+		if( test->report->size ){
+			FILE *log = logfile ? logfile : stderr;
+			fprintf( log, "%s", test->report->chars );
+			fflush( log );
 		}
-		DString_Delete( string );
-		DList_Delete( dao_tests );
-		DaoQuit();
+		passes += test->passes;
+		fails += test->fails;
+		mpasses += test->fails == 0;
+		mfails += test->fails != 0;
+		DString_Delete( test->report );
+#ifdef UNIX
+		DString_Delete( test->output );
+#endif
 	}
-	DMutex_Destroy( & mutex );
+	dao_free( tests );
 
 	printf( "Test summary:\nfiles: %4i passed, %4i failed;\nunits: %4i passed, %4i failed;\n",
 			mpasses, mfails, passes, fails );
+	printf( "time: %.3fs, with %i jobs;\n", Dao_GetCurrentTime() - start, jobs );
 
 	if( logfile ){
 		if( fails ) fprintf( logfile, "#############################################\n" );